@@ -32,11 +32,16 @@ struct Info
     void Print(FILE *fp);
 };
 
+// Returns the guest symbol covering pc (empty if none).  Only called while streaming
+// a jitdump, see below.
+typedef std::string (*SymbolLookup)(u32 pc);
+
 class InfoVector
 {
     std::vector<Info> m_v;
     char m_prefix[20];
     unsigned int m_vtune_id;
+    SymbolLookup m_lookup;
 
 public:
     InfoVector(const char *prefix);
@@ -45,8 +50,17 @@ public:
     void map(uptr x86, u32 size, const char *symbol);
     void map(uptr x86, u32 size, u32 pc);
     void reset();
+
+    void set_symbol_lookup(SymbolLookup lookup) { m_lookup = lookup; }
 };
 
+// Linux only: when the PCSX2_JITDUMP environment variable is set, every block is written
+// to /tmp/jit-PID.dump as it is compiled, in the jitdump format of perf.  Record with
+// "perf record -k mono" and run "perf inject --jit" on the result.  Unlike the perf map,
+// which is only written on recompiler resets and shutdown, this covers the blocks that
+// were discarded along the way.
+bool jitdump_enabled();
+
 void dump();
 void dump_and_reset();
 
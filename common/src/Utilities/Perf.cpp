@@ -21,6 +21,15 @@
 #include "unistd.h"
 #endif
 
+#ifdef __linux__
+#include <atomic>
+#include <elf.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
 //#define ProfileWithPerf
 #define MERGE_BLOCK_RESULT
 
@@ -41,6 +50,218 @@ InfoVector iop("IOP");
 InfoVector vu("VU");
 InfoVector vif("VIF");
 
+////////////////////////////////////////////////////////////////////////////////
+// jitdump streaming (Linux only)
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+// Layout from tools/perf/Documentation/jitdump-specification.txt in the kernel tree.
+static const u32 JitDumpMagic = 0x4A695444;
+static const u32 JitDumpVersion = 1;
+static const u32 JitCodeLoad = 0;
+
+// Bigger zones are memory reserves (see System.cpp), not code.
+static const u32 JitDumpMaxCodeSize = 16 * _1kb;
+
+struct JitDumpHeader
+{
+    u32 magic;
+    u32 version;
+    u32 total_size;
+    u32 elf_mach;
+    u32 pad1;
+    u32 pid;
+    u64 timestamp;
+    u64 flags;
+};
+
+struct JitCodeLoadRecord
+{
+    u32 id;
+    u32 total_size;
+    u64 timestamp;
+    u32 pid;
+    u32 tid;
+    u64 vma;
+    u64 code_addr;
+    u64 code_size;
+    u64 code_index;
+    // followed by the name (null terminated), and the code itself
+};
+
+class JitDump
+{
+    std::mutex m_lock;
+    FILE *m_fp;
+    void *m_marker;
+    u64 m_index;
+    bool m_checked;
+
+    // Read without the lock: the recompilers ask for every block, and it's usually off.
+    std::atomic<bool> m_disabled;
+
+    static u64 timestamp()
+    {
+        // Has to match the clock perf samples with (perf record -k mono).
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // Called with the lock held.
+    void open()
+    {
+        m_checked = true;
+        if (!getenv("PCSX2_JITDUMP")) {
+            m_disabled = true;
+            return;
+        }
+
+        char file[256];
+        snprintf(file, sizeof(file), "/tmp/jit-%d.dump", getpid());
+        m_fp = fopen(file, "w+");
+        if (!m_fp) {
+            m_disabled = true;
+            return;
+        }
+
+        JitDumpHeader header = {};
+        header.magic = JitDumpMagic;
+        header.version = JitDumpVersion;
+        header.total_size = sizeof(header);
+#ifdef _M_X86_64
+        header.elf_mach = EM_X86_64;
+#else
+        header.elf_mach = EM_386;
+#endif
+        header.pid = getpid();
+        header.timestamp = timestamp();
+        fwrite(&header, sizeof(header), 1, m_fp);
+        fflush(m_fp);
+
+        // perf finds the dump through this (executable) mapping of it.
+        m_marker = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(m_fp), 0);
+        if (m_marker == MAP_FAILED)
+            m_marker = NULL;
+    }
+
+public:
+    JitDump()
+        : m_fp(NULL)
+        , m_marker(NULL)
+        , m_index(0)
+        , m_checked(false)
+        , m_disabled(false)
+    {
+    }
+
+    ~JitDump()
+    {
+        if (m_marker)
+            munmap(m_marker, sysconf(_SC_PAGESIZE));
+        if (m_fp)
+            fclose(m_fp);
+    }
+
+    bool enabled()
+    {
+        if (m_disabled)
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_checked)
+            open();
+        return m_fp != NULL;
+    }
+
+    void code_load(uptr x86, u32 size, const char *name)
+    {
+        if (size == 0 || size >= JitDumpMaxCodeSize || m_disabled)
+            return;
+
+        // The recompilers run on several threads (EE, MTVU).
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_checked)
+            open();
+        if (!m_fp)
+            return;
+
+        const u32 name_size = strlen(name) + 1;
+
+        JitCodeLoadRecord rec;
+        rec.id = JitCodeLoad;
+        rec.total_size = sizeof(rec) + name_size + size;
+        rec.timestamp = timestamp();
+        rec.pid = getpid();
+        rec.tid = syscall(SYS_gettid);
+        rec.vma = x86;
+        rec.code_addr = x86;
+        rec.code_size = size;
+        rec.code_index = m_index++;
+
+        fwrite(&rec, sizeof(rec), 1, m_fp);
+        fwrite(name, name_size, 1, m_fp);
+        fwrite((void *)x86, size, 1, m_fp);
+    }
+
+    void flush()
+    {
+        if (m_disabled)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_fp)
+            fflush(m_fp);
+    }
+};
+
+static JitDump s_jitdump;
+
+bool jitdump_enabled()
+{
+    return s_jitdump.enabled();
+}
+
+static void jitdump_code_load(uptr x86, u32 size, const char *name)
+{
+    s_jitdump.code_load(x86, size, name);
+}
+
+static void jitdump_code_load(uptr x86, u32 size, const char *prefix, u32 pc, SymbolLookup lookup)
+{
+    if (!s_jitdump.enabled())
+        return;
+
+    std::string guest = lookup ? lookup(pc) : std::string();
+
+    char name[256];
+    if (guest.empty())
+        snprintf(name, sizeof(name), "%s_0x%08x", prefix, pc);
+    else
+        snprintf(name, sizeof(name), "%s_0x%08x %s", prefix, pc, guest.c_str());
+
+    s_jitdump.code_load(x86, size, name);
+}
+
+// Blocks discarded by a recompiler reset don't need a record of their own: perf resolves
+// a sample with the last code load which covered its address at that time, so the code
+// compiled over them takes their place.  The file is only flushed, so that it stays
+// usable if the process doesn't exit cleanly.
+static void jitdump_flush()
+{
+    s_jitdump.flush();
+}
+
+#else
+
+bool jitdump_enabled() { return false; }
+static void jitdump_code_load(uptr x86, u32 size, const char *name) {}
+static void jitdump_code_load(uptr x86, u32 size, const char *prefix, u32 pc, SymbolLookup lookup) {}
+static void jitdump_flush() {}
+
+#endif
+
 // Perf is only supported on linux
 #if defined(__linux__) && (defined(ProfileWithPerf) || defined(ENABLE_VTUNE))
 
@@ -74,6 +295,7 @@ void Info::Print(FILE *fp)
 ////////////////////////////////////////////////////////////////////////////////
 
 InfoVector::InfoVector(const char *prefix)
+    : m_lookup(NULL)
 {
     strncpy(m_prefix, prefix, sizeof(m_prefix));
 #ifdef ENABLE_VTUNE
@@ -101,6 +323,8 @@ void InfoVector::map(uptr x86, u32 size, const char *symbol)
     u32 max_code_size = _1gb;
 #endif
 
+    jitdump_code_load(x86, size, symbol);
+
     if (size < max_code_size) {
         m_v.emplace_back(x86, size, symbol);
 
@@ -125,6 +349,8 @@ void InfoVector::map(uptr x86, u32 size, const char *symbol)
 
 void InfoVector::map(uptr x86, u32 size, u32 pc)
 {
+    jitdump_code_load(x86, size, m_prefix, pc, m_lookup);
+
 #ifndef MERGE_BLOCK_RESULT
     m_v.emplace_back(x86, size, m_prefix, pc);
 #endif
@@ -153,6 +379,8 @@ void InfoVector::map(uptr x86, u32 size, u32 pc)
 
 void InfoVector::reset()
 {
+    jitdump_flush();
+
     auto dynamic = std::remove_if(m_v.begin(), m_v.end(), [](Info i) { return i.m_dynamic; });
     m_v.erase(dynamic, m_v.end());
 }
@@ -194,11 +422,13 @@ void dump_and_reset()
 
 InfoVector::InfoVector(const char *prefix)
     : m_vtune_id(0)
+    , m_lookup(NULL)
 {
+    strncpy(m_prefix, prefix, sizeof(m_prefix));
 }
-void InfoVector::map(uptr x86, u32 size, const char *symbol) {}
-void InfoVector::map(uptr x86, u32 size, u32 pc) {}
-void InfoVector::reset() {}
+void InfoVector::map(uptr x86, u32 size, const char *symbol) { jitdump_code_load(x86, size, symbol); }
+void InfoVector::map(uptr x86, u32 size, u32 pc) { jitdump_code_load(x86, size, m_prefix, pc, m_lookup); }
+void InfoVector::reset() { jitdump_flush(); }
 
 void dump() {}
 void dump_and_reset() {}
@@ -76,6 +76,23 @@ class FlatFileReader : public AsyncFileReader
 #elif defined(__linux__)
 	int m_fd; // FIXME don't know if overlap as an equivalent on linux
 	io_context_t m_aio_context;
+
+	// Optional read-only mapping of the whole file. When it's set, reads are plain copies
+	// from it and aio isn't used at all.
+	bool m_memoryMap;
+	u8* m_mapping;
+	u64 m_mappingSize;
+	int m_mappingBytesRead;
+
+	// Access pattern tracking, to give the kernel paging hints.
+	u64 m_nextSequentialOffset;
+	uint m_sequentialReads;
+	u64 m_willNeedEnd;
+
+	bool OpenMapping();
+	void CloseMapping();
+	int ReadMapping(void* pBuffer, u64 offset, u32 bytesToRead);
+	void AdviseMapping(u64 offset, u32 bytes);
 #elif defined(__POSIX__)
 	int m_fd; // TODO OSX don't know if overlap as an equivalent on OSX
 	struct aiocb m_aiocb;
@@ -85,7 +102,8 @@ class FlatFileReader : public AsyncFileReader
 	bool shareWrite;
 
 public:
-	FlatFileReader(bool shareWrite = false);
+	// memoryMap is only implemented on Linux, other platforms ignore it.
+	FlatFileReader(bool shareWrite = false, bool memoryMap = false);
 	virtual ~FlatFileReader(void);
 
 	virtual bool Open(const wxString& fileName);
@@ -0,0 +1,203 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "IopCommon.h"
+#include "BlockProfiler.h"
+#include "System/SysThreads.h"
+#include "MTVU.h"
+#include "AppConfig.h"
+#include "DebugTools/SymbolMap.h"
+
+#include "Utilities/AsciiFile.h"
+
+using namespace Threading;
+
+// Number of blocks listed on the console, per CPU.
+static const uint TopBlockCount = 20;
+
+static const char* const CpuNames[BlockProfiler::Cpu_Count] = { "EE", "IOP", "VU0", "VU1" };
+
+// --------------------------------------------------------------------------------------
+//  BlockProfiler::Sampler
+// --------------------------------------------------------------------------------------
+BlockProfiler::Sampler::Sampler( BlockProfiler& profiler )
+	: _parent( L"Block Profiler" )
+	, m_profiler( profiler )
+{
+}
+
+BlockProfiler::Sampler::~Sampler()
+{
+	try {
+		_parent::Cancel();
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+void BlockProfiler::Sampler::ExecuteTaskInThread()
+{
+	for (;;)
+	{
+		Sleep( 1 );
+		m_profiler.Sample();
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  BlockProfiler  (implementations)
+// --------------------------------------------------------------------------------------
+BlockProfiler::BlockProfiler()
+{
+	m_samples = 0;
+
+	for( int i=0; i<Cpu_Count; ++i )
+	{
+		m_enabled[i]	= false;
+		m_sizeLookup[i]	= NULL;
+	}
+}
+
+void BlockProfiler::ApplySettings()
+{
+	const Pcsx2Config::ProfilerOptions& opts = EmuConfig.Profiler;
+
+	// Whatever changed, report what was gathered with the previous settings.
+	Stop();
+
+	if( !opts.Enabled ) return;
+
+	m_enabled[Cpu_EE]	= opts.RecBlocks_EE;
+	m_enabled[Cpu_IOP]	= opts.RecBlocks_IOP;
+	m_enabled[Cpu_VU0]	= opts.RecBlocks_VU0;
+	m_enabled[Cpu_VU1]	= opts.RecBlocks_VU1;
+
+	Start();
+}
+
+void BlockProfiler::Start()
+{
+	for( int i=0; i<Cpu_Count; ++i )
+		m_hist[i].clear();
+	m_samples = 0;
+
+	m_sampler = std::unique_ptr<Sampler>(new Sampler( *this ));
+	m_sampler->Start();
+
+	Console.WriteLn( Color_StrongBlack, "(BlockProfiler) Sampling started." );
+}
+
+void BlockProfiler::Stop()
+{
+	if( !m_sampler ) return;
+
+	// Cancel waits for the thread to exit, so the histograms are ours after this.
+	m_sampler = nullptr;
+
+	Dump();
+}
+
+// Runs on the sampler thread.  Reads the registers of the other threads without any kind
+// of synchronization: a sample may be a bit stale, but each value is a single aligned u32.
+void BlockProfiler::Sample()
+{
+	// Paused VMs still have a pc; don't let it pile up samples.
+	if( GetCoreThread().IsPaused() ) return;
+
+	++m_samples;
+
+	if( m_enabled[Cpu_EE] )
+		++m_hist[Cpu_EE][cpuRegs.pc];
+
+	if( m_enabled[Cpu_IOP] )
+		++m_hist[Cpu_IOP][psxRegs.pc];
+
+	if( m_enabled[Cpu_VU0] && (VU0.VI[REG_VPU_STAT].UL & 0x1) )
+		++m_hist[Cpu_VU0][VU0.VI[REG_TPC].UL];
+
+	if( m_enabled[Cpu_VU1] )
+	{
+		// MTVU doesn't set VPU_STAT; its busy flag also covers unpacks, which is close enough.
+		const bool busy = THREAD_VU1 ? vu1Thread.IsBusy() : !!(VU0.VI[REG_VPU_STAT].UL & 0x100);
+		if( busy ) ++m_hist[Cpu_VU1][VU1.VI[REG_TPC].UL];
+	}
+}
+
+// Folded stack of an EE block: the function it belongs to when the symbol map knows it.
+static std::string GetFoldedName( BlockProfiler::Cpu cpu, u32 pc )
+{
+	char addr[16];
+	snprintf( addr, sizeof(addr), "0x%08x", pc );
+
+	std::string name( CpuNames[cpu] );
+	if( cpu == BlockProfiler::Cpu_EE )
+	{
+		const u32 start = symbolMap.GetFunctionStart( pc );
+		if( start != SymbolMap::INVALID_ADDRESS )
+		{
+			const std::string func = symbolMap.GetLabelString( start );
+			if( !func.empty() ) name += ";" + func;
+		}
+	}
+
+	return name + ";" + addr;
+}
+
+void BlockProfiler::Dump()
+{
+	Console.WriteLn( Color_StrongBlack, "(BlockProfiler) %u samples.", m_samples );
+
+	if( !m_samples ) return;
+
+	g_Conf->Folders.Logs.Mkdir();
+	AsciiFile folded( Path::Combine( g_Conf->Folders.Logs, L"blocks.folded" ), L"w" );
+
+	for( int i=0; i<Cpu_Count; ++i )
+	{
+		const Cpu cpu = (Cpu)i;
+		const Histogram& hist = m_hist[i];
+		if( !m_enabled[i] || hist.empty() ) continue;
+
+		std::vector<std::pair<u32, u32>> blocks( hist.begin(), hist.end() );
+		std::sort( blocks.begin(), blocks.end(), []( const std::pair<u32, u32>& a, const std::pair<u32, u32>& b ) {
+			return a.second > b.second;
+		});
+
+		Console.WriteLn( Color_StrongBlack, "(BlockProfiler) %s: %u blocks sampled. Hottest:", CpuNames[i], (u32)blocks.size() );
+
+		const uint count = std::min<uint>( TopBlockCount, blocks.size() );
+		for( uint n=0; n<count; ++n )
+		{
+			const u32 pc = blocks[n].first;
+			const u32 hits = blocks[n].second;
+			const u32 size = m_sizeLookup[i] ? m_sizeLookup[i]( pc ) : 0;
+
+			// The symbol map only has EE symbols.
+			const std::string label = (cpu == Cpu_EE) ? symbolMap.GetLabelString( pc ) : std::string();
+
+			Console.WriteLn( "    %08x  %7u hits  %5.2f%%  %6u host bytes  %s", pc, hits,
+				(100.0 * hits) / m_samples, size, label.c_str() );
+		}
+
+		for( const auto& block : blocks )
+			folded.Printf( "%s %u\n", GetFoldedName( cpu, block.first ).c_str(), block.second );
+	}
+}
+
+BlockProfiler& GetBlockProfiler()
+{
+	static BlockProfiler profiler;
+	return profiler;
+}
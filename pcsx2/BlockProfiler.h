@@ -0,0 +1,98 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Utilities/PersistentThread.h"
+#include <memory>
+#include <unordered_map>
+
+// --------------------------------------------------------------------------------------
+//  BlockProfiler
+// --------------------------------------------------------------------------------------
+// Sampling profiler of the guest code.  While EmuConfig.Profiler.Enabled is set, a helper
+// thread wakes up every millisecond and looks at what each CPU is running:
+//
+//  * EE and IOP: the pc.  The recompilers store it on every branch, so it's the start of
+//    the block being run (with the interpreters, the instruction being run).
+//  * VU0 and VU1: the TPC while the VU is busy, which is the entry point of the program.
+//
+// Each CPU can be left out with its Profiler.RecBlocks_* option.
+//
+// Only the sampling thread writes the histograms, and they're only read once it's gone, so
+// nothing is locked and the CPU threads don't do any work for the profiler.  When profiling
+// stops (the option is turned off, or the VM is shut down), the histograms are dumped: the
+// hottest blocks to the console, and all of them to blocks.folded in the logs folder, in the
+// folded stack format flamegraph.pl reads.
+//
+class BlockProfiler
+{
+	DeclareNoncopyableObject( BlockProfiler );
+
+public:
+	enum Cpu
+	{
+		Cpu_EE,
+		Cpu_IOP,
+		Cpu_VU0,
+		Cpu_VU1,
+		Cpu_Count
+	};
+
+	// Host code size of the block starting at pc, 0 if there's none.  Registered by the
+	// recompilers, and only called from the core thread.
+	typedef u32 (*BlockSizeLookup)( u32 pc );
+
+	BlockProfiler();
+	virtual ~BlockProfiler() = default;
+
+	void SetBlockSizeLookup( Cpu cpu, BlockSizeLookup lookup ) { m_sizeLookup[cpu] = lookup; }
+
+	// Starts or stops sampling to follow EmuConfig.Profiler.  Core thread only, before the
+	// recompilers are reset (so that the dump can still tell the size of the blocks).
+	void ApplySettings();
+
+	// Stops sampling and dumps the results, if it was running.  Core thread only.
+	void Stop();
+
+protected:
+	class Sampler : public Threading::pxThread
+	{
+		typedef Threading::pxThread _parent;
+
+	public:
+		Sampler( BlockProfiler& profiler );
+		virtual ~Sampler();
+
+	protected:
+		void ExecuteTaskInThread();
+
+		BlockProfiler& m_profiler;
+	};
+
+	typedef std::unordered_map<u32, u32> Histogram;
+
+	void Start();
+	void Sample();
+	void Dump();
+
+	std::unique_ptr<Sampler>	m_sampler;
+	Histogram					m_hist[Cpu_Count];
+	u32							m_samples;		// sampler wakeups
+	bool						m_enabled[Cpu_Count];
+	BlockSizeLookup				m_sizeLookup[Cpu_Count];
+};
+
+extern BlockProfiler& GetBlockProfiler();
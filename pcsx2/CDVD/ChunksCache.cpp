@@ -16,37 +16,256 @@
 #include "PrecompiledHeader.h"
 #include "ChunksCache.h"
 
+using namespace Threading;
+
+// --------------------------------------------------------------------------------------
+//  ChunksCache::Shard
+// --------------------------------------------------------------------------------------
+
+void ChunksCache::Shard::Configure(uint capacity, uint chunkSize) {
+	ScopedLock lock(m_lock);
+
+	// Slots can't move between slabs, so a smaller limit or another chunk size starts over.
+	if (chunkSize != m_chunkSize || capacity < m_slots.size()) {
+		for (u8* slab : m_slabs)
+			free(slab);
+		m_slabs.clear();
+		m_slots.clear();
+		m_index.clear();
+		m_hand = 0;
+	}
+
+	m_chunkSize = chunkSize;
+	m_capacity = capacity;
+	m_slabChunks = chunkSize ? std::max(1u, SlabBytes / chunkSize) : 1;
+}
+
+void ChunksCache::Shard::Clear() {
+	ScopedLock lock(m_lock);
+	for (u8* slab : m_slabs)
+		free(slab);
+	m_slabs.clear();
+	m_slots.clear();
+	m_index.clear();
+	m_hand = 0;
+}
+
+// Returns a free slot, growing the slabs while under capacity, or evicting the first slot
+// the CLOCK hand finds without its referenced bit. Must be called with m_lock held.
+uint ChunksCache::Shard::AcquireSlot() {
+	if (m_slots.size() < m_capacity) {
+		if (m_slots.size() == m_slabs.size() * m_slabChunks)
+			m_slabs.push_back((u8*)malloc((size_t)m_slabChunks * m_chunkSize));
+
+		CacheSlot slot = {};
+		m_slots.push_back(slot);
+		return m_slots.size() - 1;
+	}
+
+	for (;;) {
+		if (m_hand >= m_slots.size())
+			m_hand = 0;
+
+		CacheSlot& slot = m_slots[m_hand];
+		if (slot.used && slot.referenced) {
+			slot.referenced = false; // second chance
+			m_hand++;
+			continue;
+		}
+
+		if (slot.used)
+			m_index.erase(slot.offset / m_chunkSize);
+		slot.used = false;
+		return m_hand++;
+	}
+}
+
+void ChunksCache::Shard::Take(const void* pSrc, PX_off_t key, PX_off_t offset, int length, int coverage) {
+	ScopedLock lock(m_lock);
+	if (!m_capacity)
+		return;
+
+	uint slot;
+	auto it = m_index.find(key);
+	if (it != m_index.end())
+		slot = it->second; // refresh the existing chunk in place
+	else {
+		slot = AcquireSlot();
+		m_index[key] = slot;
+	}
+
+	CacheSlot& s = m_slots[slot];
+	s.offset = offset;
+	s.size = length;
+	s.coverage = coverage;
+	s.used = true;
+	s.referenced = true;
+	if (length > 0)
+		memcpy(SlotData(slot), pSrc, length);
+}
+
+int ChunksCache::Shard::Read(void* pDest, PX_off_t key, PX_off_t offset, int length) {
+	ScopedLock lock(m_lock);
+	auto it = m_index.find(key);
+	if (it == m_index.end())
+		return -1;
+
+	CacheSlot& s = m_slots[it->second];
+	if (offset < s.offset || (offset + length) > (s.offset + s.coverage))
+		return -1;
+
+	s.referenced = true;
+	return CopyAvailable(SlotData(it->second), s.offset, s.size, pDest, offset, length);
+}
+
+bool ChunksCache::Shard::Contains(PX_off_t key) {
+	ScopedLock lock(m_lock);
+	return m_index.find(key) != m_index.end();
+}
+
+// --------------------------------------------------------------------------------------
+//  ChunksCache
+// --------------------------------------------------------------------------------------
+
+ChunksCache::ChunksCache(uint initialLimitMb, uint chunkSize)
+	: m_limit((PX_off_t)initialLimitMb * 1024 * 1024)
+	, m_chunkSize(chunkSize) {
+	Configure();
+}
+
+void ChunksCache::Configure() {
+	uint capacity = 0;
+	if (m_chunkSize) {
+		// Round up so that even a tiny limit keeps at least one chunk per shard.
+		PX_off_t chunks = m_limit / m_chunkSize;
+		capacity = (uint)std::max<PX_off_t>(1, (chunks + ShardCount - 1) / ShardCount);
+	}
+
+	for (Shard& shard : m_shards)
+		shard.Configure(capacity, m_chunkSize);
+}
+
 void ChunksCache::SetLimit(uint megabytes) {
 	m_limit = (PX_off_t)megabytes * 1024 * 1024;
-	MatchLimit();
+	Configure();
 }
 
-void ChunksCache::MatchLimit(bool removeAll) {
-	std::list<CacheEntry*>::reverse_iterator rit;
-	while (!m_entries.empty() && (removeAll || m_size > m_limit)) {
-		rit = m_entries.rbegin();
-		m_size -= (*rit)->size;
-		delete(*rit);
-		m_entries.pop_back();
-	}
+void ChunksCache::SetChunkSize(uint bytes) {
+	if (bytes == m_chunkSize)
+		return;
+	m_chunkSize = bytes;
+	Configure();
 }
 
-void ChunksCache::Take(void* pMallocedSrc, PX_off_t offset, int length, int coverage) {
-	m_entries.push_front(new CacheEntry(pMallocedSrc, offset, length, coverage));
-	m_size += length;
-	MatchLimit();
+void ChunksCache::Clear() {
+	for (Shard& shard : m_shards)
+		shard.Clear();
+}
+
+void ChunksCache::Take(const void* pSrc, PX_off_t offset, int length, int coverage) {
+	// Only whole chunks are cached. Anything else can't be found again by Read() anyway.
+	if (!m_chunkSize || offset % m_chunkSize || length > (int)m_chunkSize || coverage > (int)m_chunkSize)
+		return;
+
+	PX_off_t key = offset / m_chunkSize;
+	ShardOf(key).Take(pSrc, key, offset, length, coverage);
 }
 
 // By design, succeed only if the entire request is in a single cached chunk
 int ChunksCache::Read(void* pDest, PX_off_t offset, int length) {
-	for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
-		CacheEntry* e = *it;
-		if (e && offset >= e->offset && (offset + length) <= (e->offset + e->coverage)) {
-			if (it != m_entries.begin())
-				m_entries.splice(m_entries.begin(), m_entries, it); // Move to top (MRU)
-			return CopyAvailable(e->data, e->offset, e->size, pDest, offset, length);
-		}
+	if (!m_chunkSize)
+		return -1;
+
+	PX_off_t key = offset / m_chunkSize;
+	return ShardOf(key).Read(pDest, key, offset, length);
+}
+
+bool ChunksCache::Contains(PX_off_t offset) {
+	if (!m_chunkSize)
+		return false;
+
+	PX_off_t key = offset / m_chunkSize;
+	return ShardOf(key).Contains(key);
+}
+
+// --------------------------------------------------------------------------------------
+//  ChunksReadAhead
+// --------------------------------------------------------------------------------------
+
+ChunksReadAhead::ChunksReadAhead(IChunkSource& source, uint depth)
+	: m_source(source)
+	, m_depth(depth)
+	, m_chunkSize(0)
+	, m_totalSize(0)
+	, m_lastChunk(-1)
+	, m_sequentialCount(0)
+	, m_nextChunk(0)
+	, m_endChunk(0)
+	, m_quit(true) {
+}
+
+ChunksReadAhead::~ChunksReadAhead() {
+	Close();
+}
+
+void ChunksReadAhead::Open(PX_off_t chunkSize, PX_off_t totalSize) {
+	Close();
+
+	m_chunkSize = chunkSize;
+	m_totalSize = totalSize;
+	m_lastChunk = -1;
+	m_sequentialCount = 0;
+	m_nextChunk = 0;
+	m_endChunk = 0;
+	m_quit = !m_depth || !m_chunkSize;
+}
+
+void ChunksReadAhead::Close() {
+	m_quit = true;
+
+	// Let a running job finish the chunk it's on, rather than interrupting zlib.
+	if (!DecompressionPool::Get().Cancel(*this))
+		DecompressionPool::Get().Wait(*this);
+}
+
+void ChunksReadAhead::OnChunkAccess(PX_off_t offset) {
+	if (m_quit)
+		return;
+
+	PX_off_t chunk = offset / m_chunkSize;
+	if (chunk == m_lastChunk)
+		return;
+
+	if (chunk == m_lastChunk + 1)
+		m_sequentialCount++;
+	else
+		m_sequentialCount = 0;
+	m_lastChunk = chunk;
+
+	if (m_sequentialCount < SequentialThreshold) {
+		// Not (or no longer) sequential, drop whatever is still pending.
+		m_endChunk = m_nextChunk.load();
+		return;
 	}
-	return -1;
+
+	PX_off_t lastChunk = (m_totalSize + m_chunkSize - 1) / m_chunkSize;
+	m_nextChunk = chunk + 1;
+	m_endChunk = std::min<PX_off_t>(chunk + 1 + m_depth, lastChunk);
+
+	// A job which is about to finish may miss the new window. The next access resubmits it.
+	if (!IsPending())
+		DecompressionPool::Get().Submit(*this);
 }
 
+void ChunksReadAhead::Execute() {
+	while (!m_quit) {
+		s64 next = m_nextChunk;
+		if (next >= m_endChunk)
+			break;
+
+		m_source.ExtractChunkAhead(next * m_chunkSize);
+
+		// If the reader moved the window meanwhile, keep its new position.
+		m_nextChunk.compare_exchange_strong(next, next + 1);
+	}
+}
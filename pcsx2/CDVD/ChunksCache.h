@@ -15,19 +15,40 @@
 
 #pragma once
 
+#include <unordered_map>
+#include "DecompressionPool.h"
 #include "zlib_indexed.h"
 
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
+// --------------------------------------------------------------------------------------
+//  ChunksCache
+// --------------------------------------------------------------------------------------
+// Cache of extracted data, made of fixed size chunks which start at chunk size boundaries.
+//
+// Chunks are indexed by (offset / chunk size) in a hash map, so a lookup costs the same
+// regardless of how many chunks are cached. The chunk data itself lives in large slabs
+// which are only released on Clear(), and eviction uses the CLOCK (second chance)
+// approximation of LRU instead of reordering a list on every hit.
+//
+// The cache is split into a few independently locked shards (chunk index modulo the
+// shard count), so the read-ahead worker and the reading thread rarely contend.
+//
 class ChunksCache {
 public:
-	ChunksCache(uint initialLimitMb) : m_entries(0), m_size(0), m_limit(initialLimitMb * 1024 * 1024) {};
+	ChunksCache(uint initialLimitMb, uint chunkSize = 0);
 	~ChunksCache() { Clear(); };
 	void SetLimit(uint megabytes);
-	void Clear() { MatchLimit(true); };
+	void SetChunkSize(uint bytes);
+	uint GetChunkSize() const { return m_chunkSize; }
+	void Clear();
 
-	void Take(void* pMallocedSrc, PX_off_t offset, int length, int coverage);
-	int  Read(void* pDest,        PX_off_t offset, int length);
+	// Copies length bytes (at most one chunk) from pSrc into the cache. offset must be at a
+	// chunk boundary. coverage is the range this chunk answers for, and may be bigger than
+	// length at EOF.
+	void Take(const void* pSrc, PX_off_t offset, int length, int coverage);
+	int  Read(void* pDest,      PX_off_t offset, int length);
+	bool Contains(PX_off_t offset);
 
 	static int CopyAvailable(void* pSrc, PX_off_t srcOffset, int srcSize,
 							 void* pDst, PX_off_t dstOffset, int maxCopySize) {
@@ -37,27 +58,98 @@ public:
 	};
 
 private:
-	class CacheEntry {
-	public:
-		CacheEntry(void* pMallocedSrc, PX_off_t offset, int length, int coverage) :
-			data(pMallocedSrc),
-			offset(offset),
-			coverage(coverage),
-			size(length)
-		{};
-
-		~CacheEntry() { if (data) free(data); };
+	static const uint ShardCount = 8;
+	static const uint SlabBytes  = 1024 * 1024;
 
-		void* data;
+	struct CacheSlot {
 		PX_off_t offset;
-		int coverage;
 		int size;
+		int coverage;
+		bool used;
+		bool referenced;
 	};
 
-	std::list<CacheEntry*> m_entries;
-	void MatchLimit(bool removeAll = false);
-	PX_off_t m_size;
+	class Shard {
+	public:
+		Shard() : m_capacity(0), m_slabChunks(1), m_chunkSize(0), m_hand(0) {}
+		~Shard() { Clear(); }
+
+		void Configure(uint capacity, uint chunkSize);
+		void Clear();
+
+		void Take(const void* pSrc, PX_off_t key, PX_off_t offset, int length, int coverage);
+		int  Read(void* pDest, PX_off_t key, PX_off_t offset, int length);
+		bool Contains(PX_off_t key);
+
+	private:
+		u8* SlotData(uint slot) const {
+			return m_slabs[slot / m_slabChunks] + (slot % m_slabChunks) * m_chunkSize;
+		}
+		uint AcquireSlot();
+
+		Threading::Mutex m_lock;
+		std::unordered_map<PX_off_t, uint> m_index; // chunk index -> slot
+		std::vector<CacheSlot> m_slots;
+		std::vector<u8*> m_slabs;
+		uint m_capacity;    // max slots in this shard
+		uint m_slabChunks;  // chunks per slab
+		uint m_chunkSize;
+		uint m_hand;        // CLOCK hand
+	};
+
+	Shard& ShardOf(PX_off_t key) { return m_shards[key % ShardCount]; }
+	void Configure();
+
+	Shard m_shards[ShardCount];
 	PX_off_t m_limit;
+	uint m_chunkSize;
+};
+
+// --------------------------------------------------------------------------------------
+//  ChunksReadAhead
+// --------------------------------------------------------------------------------------
+// Watches the chunks a compressed reader hands out, and once a few consecutive chunks were
+// requested in order, has the DecompressionPool extract the next ones into the cache before
+// they're needed. Any non sequential access drops the pending read-ahead.
+//
+class ChunksReadAhead : public DecompressionJob {
+public:
+	// Implemented by the reader. Called from a pool thread: must extract the chunk
+	// starting at offset into the cache (if it's not there already), with its own locking.
+	class IChunkSource {
+	public:
+		virtual ~IChunkSource() = default;
+		virtual void ExtractChunkAhead(PX_off_t offset) = 0;
+	};
+
+	ChunksReadAhead(IChunkSource& source, uint depth);
+	virtual ~ChunksReadAhead();
+
+	void Open(PX_off_t chunkSize, PX_off_t totalSize);
+	void Close();
+
+	// Called by the reader after every chunk it served.
+	void OnChunkAccess(PX_off_t offset);
+
+protected:
+	void Execute();
+
+private:
+	static const int SequentialThreshold = 2;
+
+	IChunkSource& m_source;
+	uint m_depth;
+	PX_off_t m_chunkSize;
+	PX_off_t m_totalSize;
+
+	// Only touched by the reading thread
+	PX_off_t m_lastChunk;
+	int m_sequentialCount;
+
+	// Next wanted chunk and how far to go. Moved by the reader while the job runs.
+	std::atomic<s64> m_nextChunk;
+	std::atomic<s64> m_endChunk;
+	std::atomic<bool> m_quit;
 };
 
 #undef CLAMP
@@ -14,6 +14,7 @@
 */
 
 #include "PrecompiledHeader.h"
+#include <algorithm>
 #include "AsyncFileReader.h"
 #include "CompressedFileReaderUtils.h"
 #include "CsoFileReader.h"
@@ -24,6 +25,8 @@
 #include <zlib/zlib.h>
 #endif
 
+using namespace Threading;
+
 // Implementation of CSO compressed ISO reading, based on:
 // https://github.com/unknownbrackets/maxcso/blob/master/README_CSO.md
 struct CsoHeader {
@@ -89,6 +92,11 @@ bool CsoFileReader::Open(const wxString& fileName) {
 		Close();
 		return false;
 	}
+
+#if CSO_USE_CHUNKSCACHE
+	m_cache.SetChunkSize(m_frameSize);
+	m_readAhead.Open(m_frameSize, m_totalSize);
+#endif
 	return true;
 }
 
@@ -126,15 +134,11 @@ bool CsoFileReader::InitializeBuffers() {
 
 	// We might read a bit of alignment too, so be prepared.
 	if (m_frameSize + (1 << m_indexShift) < CSO_READ_BUFFER_SIZE) {
-		m_readBuffer = new u8[CSO_READ_BUFFER_SIZE];
+		m_readBufferSize = CSO_READ_BUFFER_SIZE;
 	} else {
-		m_readBuffer = new u8[m_frameSize + (1 << m_indexShift)];
+		m_readBufferSize = m_frameSize + (1 << m_indexShift);
 	}
 
-	// This is a buffer for the most recently decompressed frame.
-	m_zlibBuffer = new u8[m_frameSize + (1 << m_indexShift)];
-	m_zlibBufferFrame = numFrames;
-
 	const u32 indexSize = numFrames + 1;
 	m_index = new u32[indexSize];
 	if (fread(m_index, sizeof(u32), indexSize, m_src) != indexSize) {
@@ -142,47 +146,114 @@ bool CsoFileReader::InitializeBuffers() {
 		return false;
 	}
 
-	m_z_stream = new z_stream;
-	m_z_stream->zalloc = Z_NULL;
-	m_z_stream->zfree = Z_NULL;
-	m_z_stream->opaque = Z_NULL;
-	if (inflateInit2(m_z_stream, -15) != Z_OK) {
-		Console.Error("Unable to initialize zlib for CSO decompression.");
+	// Create the first decoder now, more are added if several threads need one at once.
+	FrameDecoder* decoder = CreateDecoder();
+	if (!decoder) {
 		return false;
 	}
+	ReleaseDecoder(decoder);
 
 	return true;
 }
 
+CsoFileReader::FrameDecoder* CsoFileReader::CreateDecoder() {
+	FrameDecoder* decoder = new FrameDecoder;
+	decoder->readBuffer = new u8[m_readBufferSize];
+	// This is a buffer for the most recently decompressed frame.
+	decoder->zlibBuffer = new u8[m_frameSize + (1 << m_indexShift)];
+	decoder->zlibBufferFrame = (u32)-1;
+
+	decoder->z = new z_stream;
+	decoder->z->zalloc = Z_NULL;
+	decoder->z->zfree = Z_NULL;
+	decoder->z->opaque = Z_NULL;
+	if (inflateInit2(decoder->z, -15) != Z_OK) {
+		Console.Error("Unable to initialize zlib for CSO decompression.");
+		delete decoder->z;
+		delete[] decoder->zlibBuffer;
+		delete[] decoder->readBuffer;
+		delete decoder;
+		return NULL;
+	}
+
+	return decoder;
+}
+
+// Prefers a decoder which holds this frame already.
+CsoFileReader::FrameDecoder* CsoFileReader::AcquireDecoder(u32 frame) {
+	{
+		ScopedLock lock(m_mtx_Decoders);
+		if (!m_freeDecoders.empty()) {
+			auto it = std::find_if(m_freeDecoders.begin(), m_freeDecoders.end(),
+				[frame](const FrameDecoder* d) { return d->zlibBufferFrame == frame; });
+			if (it == m_freeDecoders.end()) {
+				it = m_freeDecoders.end() - 1;
+			}
+
+			FrameDecoder* decoder = *it;
+			m_freeDecoders.erase(it);
+			return decoder;
+		}
+	}
+
+	return CreateDecoder();
+}
+
+void CsoFileReader::ReleaseDecoder(FrameDecoder* decoder) {
+	ScopedLock lock(m_mtx_Decoders);
+	m_freeDecoders.push_back(decoder);
+}
+
+void CsoFileReader::FreeDecoders() {
+	ScopedLock lock(m_mtx_Decoders);
+	for (FrameDecoder* decoder : m_freeDecoders) {
+		inflateEnd(decoder->z);
+		delete decoder->z;
+		delete[] decoder->zlibBuffer;
+		delete[] decoder->readBuffer;
+		delete decoder;
+	}
+	m_freeDecoders.clear();
+}
+
 void CsoFileReader::Close() {
-	m_filename.Empty();
+	// Nothing may still be using the decoders or the file.
+	m_asyncRead.Cancel();
 #if CSO_USE_CHUNKSCACHE
+	m_readAhead.Close();
 	m_cache.Clear();
 #endif
+	m_filename.Empty();
 
 	if (m_src) {
 		fclose(m_src);
 		m_src = NULL;
 	}
-	if (m_z_stream) {
-		inflateEnd(m_z_stream);
-		m_z_stream = NULL;
-	}
 
-	if (m_readBuffer) {
-		delete[] m_readBuffer;
-		m_readBuffer = NULL;
-	}
-	if (m_zlibBuffer) {
-		delete[] m_zlibBuffer;
-		m_zlibBuffer = NULL;
-	}
+	FreeDecoders();
+
 	if (m_index) {
 		delete[] m_index;
 		m_index = NULL;
 	}
 }
 
+// Decompresses a later frame of a multi-frame read into the cache, on the pool.
+class CsoFileReader::FrameJob : public DecompressionJob {
+public:
+	FrameJob(CsoFileReader& reader, u32 frame) : m_reader(reader), m_frame(frame) {}
+
+	u32 GetFrame() const { return m_frame; }
+
+protected:
+	void Execute() {
+		m_reader.ExtractChunkAhead((u64)m_frame << m_reader.m_frameShift);
+	}
+
+	CsoFileReader& m_reader;
+	u32 m_frame;
+};
+
 int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count) {
 	if (!m_src) {
 		return 0;
@@ -197,34 +268,52 @@ int CsoFileReader::ReadSync(void* pBuffer, uint sector, uint count) {
 	int remaining = count * m_blocksize;
 	int bytes = 0;
 
-	while (remaining > 0) {
-		int readBytes;
-
 #if CSO_USE_CHUNKSCACHE
-		// Try first to read from the cache.
-		readBytes = m_cache.Read(dest + bytes, pos + bytes, remaining);
-#else
-		readBytes = -1;
-#endif
-		if (readBytes < 0) {
-			readBytes = ReadFromFrame(dest + bytes, pos + bytes, remaining);
-			if (readBytes == 0) {
-				// We hit EOF.
-				break;
+	// When the read spans several compressed frames, the pool decompresses the later ones
+	// into the cache while this thread does the first one.
+	std::vector<std::unique_ptr<FrameJob>> frameJobs;
+	if (pos < m_totalSize) {
+		const u32 firstFrame = (u32)(pos >> m_frameShift);
+		const u32 lastFrame = (u32)((std::min<u64>(pos + remaining, m_totalSize) - 1) >> m_frameShift);
+		for (u32 frame = firstFrame + 1; frame <= lastFrame; ++frame) {
+			if (IsFrameCompressed(frame) && !m_cache.Contains((u64)frame << m_frameShift)) {
+				frameJobs.push_back(std::unique_ptr<FrameJob>(new FrameJob(*this, frame)));
+				DecompressionPool::Get().Submit(*frameJobs.back());
 			}
+		}
+	}
+	size_t nextJob = 0;
+#endif
 
+	while (remaining > 0) {
 #if CSO_USE_CHUNKSCACHE
-			// Add the bytes into the cache.  We need to allocate a buffer for it.
-			void *cached = malloc(readBytes);
-			memcpy(cached, dest + bytes, readBytes);
-			m_cache.Take(cached, pos + bytes, readBytes, readBytes);
+		const u32 frame = (u32)((pos + bytes) >> m_frameShift);
+		while (nextJob < frameJobs.size() && frameJobs[nextJob]->GetFrame() <= frame) {
+			DecompressionPool::Get().Wait(*frameJobs[nextJob++]);
+		}
 #endif
+
+		int readBytes = ReadFromFrame(dest + bytes, pos + bytes, remaining);
+		if (readBytes == 0) {
+			// We hit EOF.
+			break;
 		}
 
+#if CSO_USE_CHUNKSCACHE
+		m_readAhead.OnChunkAccess(pos + bytes);
+#endif
+
 		bytes += readBytes;
 		remaining -= readBytes;
 	}
 
+#if CSO_USE_CHUNKSCACHE
+	// The jobs must be done before they're freed, even after an error.
+	while (nextJob < frameJobs.size()) {
+		DecompressionPool::Get().Wait(*frameJobs[nextJob++]);
+	}
+#endif
+
 	return bytes;
 }
 
@@ -239,16 +328,10 @@ int CsoFileReader::ReadFromFrame(u8 *dest, u64 pos, int maxBytes) {
 	// This is how many bytes we will actually be reading from this frame.
 	const u32 bytes = (u32)(std::min(m_blocksize, static_cast<uint>(m_frameSize - offset)));
 
-	// Grab the index data for the frame we're about to read.
-	const bool compressed = (m_index[frame + 0] & 0x80000000) == 0;
-	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
-	const u32 index1 = m_index[frame + 1] & 0x7FFFFFFF;
-
-	// Calculate where the compressed payload is (if compressed.)
-	const u64 frameRawPos = (u64)index0 << m_indexShift;
-	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
+	if (!IsFrameCompressed(frame)) {
+		const u64 frameRawPos = (u64)(m_index[frame + 0] & 0x7FFFFFFF) << m_indexShift;
 
-	if (!compressed) {
+		ScopedLock lock(m_mtx_File);
 		// Just read directly, easy.
 		if (PX_fseeko(m_src, m_dataoffset + frameRawPos + offset, SEEK_SET) != 0) {
 			Console.Error("Unable to seek to uncompressed CSO data.");
@@ -256,58 +339,119 @@ int CsoFileReader::ReadFromFrame(u8 *dest, u64 pos, int maxBytes) {
 		}
 		return fread(dest, 1, bytes, m_src);
 	} else {
-		// We don't need to decompress if we already did this same frame last time.
-		if (m_zlibBufferFrame != frame) {
-			if (PX_fseeko(m_src, m_dataoffset + frameRawPos, SEEK_SET) != 0) {
-				Console.Error("Unable to seek to compressed CSO data.");
-				return 0;
-			}
-			// This might be less bytes than frameRawSize in case of padding on the last frame.
-			// This is because the index positions must be aligned.
-			const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
-			if (!DecompressFrame(frame, readRawBytes)) {
-				return 0;
-			}
+#if CSO_USE_CHUNKSCACHE
+		// The read-ahead or an earlier read may have decompressed this frame already.
+		if (m_cache.Read(dest, pos, bytes) == (int)bytes) {
+			return bytes;
+		}
+#endif
+
+		FrameDecoder* decoder = AcquireDecoder(frame);
+		if (!decoder) {
+			return 0;
+		}
+
+		bool loaded = LoadFrame(*decoder, frame);
+		if (loaded) {
+			// Now we just copy the offset data from the decoder.
+			memcpy(dest, decoder->zlibBuffer + offset, bytes);
 		}
+		ReleaseDecoder(decoder);
 
-		// Now we just copy the offset data from the cache.
-		memcpy(dest, m_zlibBuffer + offset, bytes);
+		if (!loaded) {
+			return 0;
+		}
 	}
 
 	return bytes;
 }
 
-bool CsoFileReader::DecompressFrame(u32 frame, u32 readBufferSize) {
-	m_z_stream->next_in = m_readBuffer;
-	m_z_stream->avail_in = readBufferSize;
-	m_z_stream->next_out = m_zlibBuffer;
-	m_z_stream->avail_out = m_frameSize;
+// Decompresses a frame into the decoder's buffer, and keeps a copy in the cache.
+bool CsoFileReader::LoadFrame(FrameDecoder& decoder, u32 frame) {
+	// We don't need to decompress if we already did this same frame last time.
+	if (decoder.zlibBufferFrame == frame) {
+		return true;
+	}
+
+	// Calculate where the compressed payload is.
+	const u32 index0 = m_index[frame + 0] & 0x7FFFFFFF;
+	const u32 index1 = m_index[frame + 1] & 0x7FFFFFFF;
+	const u64 frameRawPos = (u64)index0 << m_indexShift;
+	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
+
+	u32 readRawBytes;
+	{
+		ScopedLock lock(m_mtx_File);
+		if (PX_fseeko(m_src, m_dataoffset + frameRawPos, SEEK_SET) != 0) {
+			Console.Error("Unable to seek to compressed CSO data.");
+			return false;
+		}
+		// This might be less bytes than frameRawSize in case of padding on the last frame.
+		// This is because the index positions must be aligned.
+		readRawBytes = fread(decoder.readBuffer, 1, frameRawSize, m_src);
+	}
+
+	// Only the file access is serialized, inflate runs in parallel on each thread.
+	if (!DecompressFrame(decoder, frame, readRawBytes)) {
+		return false;
+	}
+
+#if CSO_USE_CHUNKSCACHE
+	m_cache.Take(decoder.zlibBuffer, (u64)frame << m_frameShift, m_frameSize, m_frameSize);
+#endif
+	return true;
+}
+
+// Called from the pool, by the read-ahead and for multi-frame reads.
+void CsoFileReader::ExtractChunkAhead(PX_off_t offset) {
+#if CSO_USE_CHUNKSCACHE
+	if ((u64)offset >= m_totalSize) {
+		return;
+	}
+
+	const u32 frame = (u32)(offset >> m_frameShift);
+	// Uncompressed frames are left to the OS file cache.
+	if (!IsFrameCompressed(frame) || m_cache.Contains(offset)) {
+		return;
+	}
+
+	FrameDecoder* decoder = AcquireDecoder(frame);
+	if (decoder) {
+		LoadFrame(*decoder, frame);
+		ReleaseDecoder(decoder);
+	}
+#endif
+}
+
+bool CsoFileReader::DecompressFrame(FrameDecoder& decoder, u32 frame, u32 readBufferSize) {
+	z_stream* z = decoder.z;
+	z->next_in = decoder.readBuffer;
+	z->avail_in = readBufferSize;
+	z->next_out = decoder.zlibBuffer;
+	z->avail_out = m_frameSize;
 
-	int status = inflate(m_z_stream, Z_FINISH);
-	bool success = status == Z_STREAM_END && m_z_stream->total_out == m_frameSize;
+	int status = inflate(z, Z_FINISH);
+	bool success = status == Z_STREAM_END && z->total_out == m_frameSize;
 	if (success) {
 		// Our buffer now contains this frame.
-		m_zlibBufferFrame = frame;
+		decoder.zlibBufferFrame = frame;
 	} else {
 		Console.Error("Unable to decompress CSO frame using zlib.");
-		m_zlibBufferFrame = (u32)-1;
+		decoder.zlibBufferFrame = (u32)-1;
 	}
 
-	inflateReset(m_z_stream);
+	inflateReset(z);
 	return success;
 }
 
 void CsoFileReader::BeginRead(void* pBuffer, uint sector, uint count) {
-	// TODO: No async support yet, implement as sync.
-	m_bytesRead = ReadSync(pBuffer, sector, count);
+	m_asyncRead.Begin(pBuffer, sector, count);
 }
 
 int CsoFileReader::FinishRead() {
-	int res = m_bytesRead;
-	m_bytesRead = -1;
-	return res;
+	return m_asyncRead.Finish();
 }
 
 void CsoFileReader::CancelRead() {
-	// TODO: No async read support yet.
+	m_asyncRead.Cancel();
 }
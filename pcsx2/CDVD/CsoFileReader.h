@@ -15,14 +15,12 @@
 
 #pragma once
 
-// Based on testing, the overhead of using this cache is high.
+// The cache holds whole decompressed frames, and is what the read-ahead fills.
 //
-// The test was done with CSO files using a block size of 16KB.
-// Cache hit rates were observed in the range of 25%.
-// Cache overhead added 35% to the overall read time.
-//
-// For this reason, it's currently disabled.
-#define CSO_USE_CHUNKSCACHE 0
+// It used to cache each read separately in a linearly scanned list, and testing with
+// 16KB frames showed 25% hit rates for 35% overhead. Caching frames in the hashed cache
+// avoids both problems, so it's enabled again.
+#define CSO_USE_CHUNKSCACHE 1
 
 #include "AsyncFileReader.h"
 #include "ChunksCache.h"
@@ -31,8 +29,10 @@ struct CsoHeader;
 typedef struct z_stream_s z_stream;
 
 static const uint CSO_CHUNKCACHE_SIZE_MB = 200;
+// Frames decompressed ahead once reads are sequential. Requires CSO_USE_CHUNKSCACHE.
+static const uint CSO_READAHEAD_FRAMES = 8;
 
-class CsoFileReader : public AsyncFileReader
+class CsoFileReader : public AsyncFileReader, public ChunksReadAhead::IChunkSource
 {
 	DeclareNoncopyableObject(CsoFileReader);
 public:
@@ -40,17 +40,15 @@ public:
 		m_frameSize(0),
 		m_frameShift(0),
 		m_indexShift(0),
-		m_readBuffer(0),
-		m_zlibBuffer(0),
-		m_zlibBufferFrame(0),
+		m_readBufferSize(0),
 		m_index(0),
 		m_totalSize(0),
 		m_src(0),
-		m_z_stream(0),
 #if CSO_USE_CHUNKSCACHE
 		m_cache(CSO_CHUNKCACHE_SIZE_MB),
+		m_readAhead(*this, CSO_READAHEAD_FRAMES),
 #endif
-		m_bytesRead(0) {
+		m_asyncRead(*this) {
 		m_blocksize = 2048;
 	};
 
@@ -75,28 +73,52 @@ public:
 	virtual void SetDataOffset(int bytes) { m_dataoffset = bytes; }
 
 private:
+	// Everything needed to decompress one frame. There's one per thread decompressing at
+	// the same time, so frames of a single read can be decompressed in parallel.
+	struct FrameDecoder {
+		z_stream* z;
+		u8* readBuffer;
+		u8* zlibBuffer;
+		u32 zlibBufferFrame; // the frame zlibBuffer holds
+	};
+
+	class FrameJob;
+
 	static bool ValidateHeader(const CsoHeader& hdr);
 	bool ReadFileHeader();
 	bool InitializeBuffers();
 	int ReadFromFrame(u8 *dest, u64 pos, int maxBytes);
-	bool DecompressFrame(u32 frame, u32 readBufferSize);
+	bool IsFrameCompressed(u32 frame) const { return (m_index[frame] & 0x80000000) == 0; }
+	bool LoadFrame(FrameDecoder& decoder, u32 frame);
+	bool DecompressFrame(FrameDecoder& decoder, u32 frame, u32 readBufferSize);
+
+	FrameDecoder* AcquireDecoder(u32 frame);
+	void ReleaseDecoder(FrameDecoder* decoder);
+	FrameDecoder* CreateDecoder();
+	void FreeDecoders();
+
+	void ExtractChunkAhead(PX_off_t offset);
 
 	u32 m_frameSize;
 	u8 m_frameShift;
 	u8 m_indexShift;
-	u8* m_readBuffer;
-	u8 *m_zlibBuffer;
-	u32 m_zlibBufferFrame;
+	u32 m_readBufferSize;
 	u32 *m_index;
 	u64 m_totalSize;
 	// The actual source cso file handle.
 	FILE* m_src;
-	z_stream* m_z_stream;
+
+	// Serializes seeking and reading m_src between threads.
+	Threading::Mutex m_mtx_File;
+	// Decoders not in use right now.
+	Threading::Mutex m_mtx_Decoders;
+	std::vector<FrameDecoder*> m_freeDecoders;
 
 #if CSO_USE_CHUNKSCACHE
 	ChunksCache m_cache;
+	ChunksReadAhead m_readAhead;
 #endif
 
-	// The result of a read is stored here between BeginRead() and FinishRead().
-	int m_bytesRead;
+	// The read between BeginRead() and FinishRead(), running on the DecompressionPool.
+	AsyncReadJob m_asyncRead;
 };
@@ -0,0 +1,193 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2014  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PrecompiledHeader.h"
+#include <algorithm>
+#include "AsyncFileReader.h"
+#include "DecompressionPool.h"
+
+using namespace Threading;
+
+// --------------------------------------------------------------------------------------
+//  DecompressionPool::Worker
+// --------------------------------------------------------------------------------------
+
+DecompressionPool::Worker::Worker(DecompressionPool& pool)
+	: _parent(L"CDVD Decompress")
+	, m_pool(pool) {
+}
+
+DecompressionPool::Worker::~Worker() {
+	try {
+		_parent::Cancel();
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+void DecompressionPool::Worker::ExecuteTaskInThread() {
+	for (;;) {
+		m_pool.m_sem_jobs.WaitWithoutYield();
+
+		DecompressionJob* job;
+		{
+			ScopedLock lock(m_pool.m_lock);
+			// Canceled jobs leave their semaphore count behind.
+			if (m_pool.m_queue.empty())
+				continue;
+
+			job = m_pool.m_queue.front();
+			m_pool.m_queue.pop_front();
+			job->m_state = DecompressionJob::Job_Running;
+		}
+
+		m_pool.RunJob(*job);
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  DecompressionPool
+// --------------------------------------------------------------------------------------
+
+DecompressionPool::DecompressionPool() {
+}
+
+DecompressionPool& DecompressionPool::Get() {
+	// Threads shouldn't be static globals (see pxThread), and the workers are only
+	// blocked on a semaphore when idle, so the pool simply lives until exit.
+	static DecompressionPool* pool = new DecompressionPool();
+	return *pool;
+}
+
+void DecompressionPool::StartWorkers() {
+	// Leave the EE, GS and VU threads their cores.
+	int count = std::max(2, std::min(4, (int)x86caps.LogicalCores / 2));
+
+	for (int i = 0; i < count; i++) {
+		m_workers.push_back(std::unique_ptr<Worker>(new Worker(*this)));
+		m_workers.back()->Start();
+	}
+}
+
+void DecompressionPool::Submit(DecompressionJob& job) {
+	{
+		ScopedLock lock(m_lock);
+		pxAssert(!job.IsPending());
+
+		if (m_workers.empty())
+			StartWorkers();
+
+		job.m_sem_done.Reset();
+		job.m_state = DecompressionJob::Job_Queued;
+		m_queue.push_back(&job);
+	}
+
+	m_sem_jobs.Post();
+}
+
+// Must be called with m_lock held.
+bool DecompressionPool::RemoveQueued(DecompressionJob& job) {
+	if (job.m_state != DecompressionJob::Job_Queued)
+		return false;
+
+	m_queue.erase(std::find(m_queue.begin(), m_queue.end(), &job));
+	return true;
+}
+
+bool DecompressionPool::Cancel(DecompressionJob& job) {
+	ScopedLock lock(m_lock);
+	if (!RemoveQueued(job))
+		return false;
+
+	job.m_state = DecompressionJob::Job_Idle;
+	return true;
+}
+
+void DecompressionPool::Wait(DecompressionJob& job) {
+	{
+		ScopedLock lock(m_lock);
+		if (RemoveQueued(job)) {
+			job.m_state = DecompressionJob::Job_Running;
+			lock.Release();
+			RunJob(job);
+			return;
+		}
+
+		if (job.m_state != DecompressionJob::Job_Running)
+			return;
+	}
+
+	// Posted once the job is done, with m_lock held. Taking the lock once more makes sure
+	// RunJob is past the post before the owner is allowed to delete the job.
+	job.m_sem_done.WaitWithoutYield();
+	ScopedLock lock(m_lock);
+}
+
+void DecompressionPool::RunJob(DecompressionJob& job) {
+	job.Execute();
+
+	// The owner only trusts Done with m_lock held (see Wait), so the job stays alive until
+	// the lock is released, and the post is the last access.
+	ScopedLock lock(m_lock);
+	job.m_state = DecompressionJob::Job_Done;
+	job.m_sem_done.Post();
+}
+
+// --------------------------------------------------------------------------------------
+//  AsyncReadJob
+// --------------------------------------------------------------------------------------
+
+AsyncReadJob::AsyncReadJob(AsyncFileReader& reader)
+	: m_reader(reader)
+	, m_buffer(NULL)
+	, m_sector(0)
+	, m_count(0)
+	, m_bytesRead(-1) {
+}
+
+AsyncReadJob::~AsyncReadJob() {
+	Cancel();
+}
+
+void AsyncReadJob::Begin(void* pBuffer, uint sector, uint count) {
+	// Only one read in flight per reader.
+	Cancel();
+
+	m_buffer = pBuffer;
+	m_sector = sector;
+	m_count = count;
+	m_bytesRead = -1;
+	DecompressionPool::Get().Submit(*this);
+}
+
+int AsyncReadJob::Finish() {
+	DecompressionPool::Get().Wait(*this);
+
+	int res = m_bytesRead;
+	m_bytesRead = -1;
+	return res;
+}
+
+void AsyncReadJob::Cancel() {
+	// Checked under the pool lock rather than with IsPending(): a job which is seen done
+	// may still be posting its semaphore. A read which already started can't be
+	// interrupted, but its result is dropped.
+	if (!DecompressionPool::Get().Cancel(*this))
+		DecompressionPool::Get().Wait(*this);
+	m_bytesRead = -1;
+}
+
+void AsyncReadJob::Execute() {
+	m_bytesRead = m_reader.ReadSync(m_buffer, m_sector, m_count);
+}
@@ -0,0 +1,133 @@
+/*  PCSX2 - PS2 Emulator for PCs
+*  Copyright (C) 2002-2014  PCSX2 Dev Team
+*
+*  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+*  of the GNU Lesser General Public License as published by the Free Software Found-
+*  ation, either version 3 of the License, or (at your option) any later version.
+*
+*  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+*  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+*  PURPOSE.  See the GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License along with PCSX2.
+*  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include "Utilities/PersistentThread.h"
+
+class AsyncFileReader;
+
+// --------------------------------------------------------------------------------------
+//  DecompressionJob
+// --------------------------------------------------------------------------------------
+// A unit of work for the DecompressionPool. A job can be submitted again once it's done,
+// and must outlive its execution: Wait() or Cancel() it before deleting it.
+//
+class DecompressionJob {
+	friend class DecompressionPool;
+
+public:
+	DecompressionJob() : m_state(Job_Idle) {}
+	virtual ~DecompressionJob() = default;
+
+	// True while queued or running. Only a hint, the state may change right after: a
+	// job that looks done may still be in use by its worker until Wait() returns.
+	bool IsPending() const {
+		int state = m_state;
+		return state == Job_Queued || state == Job_Running;
+	}
+
+protected:
+	virtual void Execute() = 0;
+
+private:
+	enum JobState {
+		Job_Idle,
+		Job_Queued,
+		Job_Running,
+		Job_Done
+	};
+
+	// Only changed with the pool lock held.
+	std::atomic<int> m_state;
+	Threading::Semaphore m_sem_done;
+};
+
+// --------------------------------------------------------------------------------------
+//  DecompressionPool
+// --------------------------------------------------------------------------------------
+// A few worker threads shared by all the compressed ISO readers, which run their reads,
+// read-ahead and frame decompression off the emulation thread.  The savestate block
+// compressor borrows them too.
+//
+// Waiting on a job which no worker picked up yet runs it on the waiting thread instead,
+// so jobs may safely submit and wait on other jobs.
+//
+class DecompressionPool {
+	DeclareNoncopyableObject(DecompressionPool);
+
+public:
+	static DecompressionPool& Get();
+
+	void Submit(DecompressionJob& job);
+
+	// Returns true if the job was removed from the queue before it started.
+	bool Cancel(DecompressionJob& job);
+
+	// Returns once the job is done. Runs it here if it's still queued.
+	void Wait(DecompressionJob& job);
+
+private:
+	class Worker : public Threading::pxThread {
+		typedef Threading::pxThread _parent;
+
+	public:
+		Worker(DecompressionPool& pool);
+		virtual ~Worker();
+
+	protected:
+		void ExecuteTaskInThread();
+
+		DecompressionPool& m_pool;
+	};
+
+	DecompressionPool();
+
+	void StartWorkers();
+	void RunJob(DecompressionJob& job);
+	bool RemoveQueued(DecompressionJob& job);
+
+	Threading::Mutex m_lock;
+	Threading::Semaphore m_sem_jobs;
+	std::deque<DecompressionJob*> m_queue;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+// --------------------------------------------------------------------------------------
+//  AsyncReadJob
+// --------------------------------------------------------------------------------------
+// Implements BeginRead/FinishRead/CancelRead for readers which only have a ReadSync, by
+// running it on the DecompressionPool.
+//
+class AsyncReadJob : public DecompressionJob {
+public:
+	AsyncReadJob(AsyncFileReader& reader);
+	virtual ~AsyncReadJob();
+
+	void Begin(void* pBuffer, uint sector, uint count);
+	int Finish();
+	void Cancel();
+
+protected:
+	void Execute();
+
+	AsyncFileReader& m_reader;
+	void* m_buffer;
+	uint m_sector;
+	uint m_count;
+	int m_bytesRead;
+};
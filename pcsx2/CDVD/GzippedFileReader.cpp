@@ -22,6 +22,8 @@
 #include "GzippedFileReader.h"
 #include "zlib_indexed.h"
 
+using namespace Threading;
+
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
 static s64 fsize(const wxString& filename) {
@@ -178,11 +180,12 @@ static wxString iso2indexname(const wxString& isoname) {
 }
 
 GzippedFileReader::GzippedFileReader(void) :
-	mBytesRead(0),
 	m_pIndex(0),
 	m_zstates(0),
 	m_src(0),
-	m_cache(GZFILE_CACHE_SIZE_MB) {
+	m_cache(GZFILE_CACHE_SIZE_MB, GZFILE_READ_CHUNK_SIZE),
+	m_readAhead(*this, GZFILE_READAHEAD_CHUNKS),
+	m_asyncRead(*this) {
 	m_blocksize = 2048;
 	AsyncPrefetchReset();
 };
@@ -268,7 +271,8 @@ void GzippedFileReader::AsyncPrefetchCancel()
 	if (!asyncInProgress)
 		return;
 
-	if (!CancelIo(hOverlappedFile)) {
+	// The prefetch may have been issued from another DecompressionPool thread, which CancelIo can't reach.
+	if (!CancelIoEx(hOverlappedFile, &asyncOperationContext)) {
 		Console.Warning("canceling gz prefetch failed. following prefetching will not work.");
 		return;
 	}
@@ -335,19 +339,20 @@ bool GzippedFileReader::Open(const wxString& fileName) {
 	};
 
 	AsyncPrefetchOpen();
+	m_readAhead.Open(GZFILE_READ_CHUNK_SIZE, m_pIndex->uncompressed_size);
 	return true;
 };
 
 void GzippedFileReader::BeginRead(void* pBuffer, uint sector, uint count) {
-	// No a-sync support yet, implement as sync
-	mBytesRead = ReadSync(pBuffer, sector, count);
-	return;
+	m_asyncRead.Begin(pBuffer, sector, count);
 };
 
 int GzippedFileReader::FinishRead(void) {
-	int res = mBytesRead;
-	mBytesRead = -1;
-	return res;
+	return m_asyncRead.Finish();
+};
+
+void GzippedFileReader::CancelRead(void) {
+	m_asyncRead.Cancel();
 };
 
 #define PTT clock_t
@@ -402,11 +407,35 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 	// From here onwards it's guarenteed that the request is inside a single GZFILE_READ_CHUNK_SIZE boundaries
 
 	int res = m_cache.Read(pBuffer, offset, bytesToRead);
+	if (res < 0) {
+		ScopedLock lock(m_mtx_Extract);
+		// The read-ahead may have extracted it while we were waiting for the lock
+		res = m_cache.Read(pBuffer, offset, bytesToRead);
+		if (res < 0)
+			res = ExtractChunk(pBuffer, offset, bytesToRead);
+	}
+
 	if (res >= 0)
-		return res;
+		m_readAhead.OnChunkAccess(offset);
+	return res;
+}
+
+// Called from the read-ahead thread
+void GzippedFileReader::ExtractChunkAhead(PX_off_t offset) {
+	if (m_cache.Contains(offset))
+		return;
+
+	ScopedLock lock(m_mtx_Extract);
+	if (!m_cache.Contains(offset))
+		ExtractChunk(NULL, offset, 0);
+}
+
+// Decompress from optimal starting point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
+// The request must be inside a single chunk. pBuffer may be NULL to only fill the cache.
+// Must be called with m_mtx_Extract held.
+int GzippedFileReader::ExtractChunk(void* pBuffer, PX_off_t offset, uint bytesToRead) {
+	uint maxInChunk = GZFILE_READ_CHUNK_SIZE - offset % GZFILE_READ_CHUNK_SIZE;
 
-	// Not available from cache. Decompress from optimal starting
-	// point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
 	PTT s = NOW();
 	PX_off_t extractOffset = GetOptimalExtractionStart(offset); // guaranteed in GZFILE_READ_CHUNK_SIZE boundaries
 	int size = offset + maxInChunk - extractOffset;
@@ -415,14 +444,14 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 	int span = m_pIndex->span;
 	int spanix = extractOffset / span;
 	AsyncPrefetchCancel();
-	res = extract(m_src, m_pIndex, extractOffset, extracted, size, &(m_zstates[spanix].state));
+	int res = extract(m_src, m_pIndex, extractOffset, extracted, size, &(m_zstates[spanix].state));
 	if (res < 0) {
 		free(extracted);
 		return res;
 	}
 	AsyncPrefetchChunk(getInOffset(&(m_zstates[spanix].state)));
 
-	int copied = ChunksCache::CopyAvailable(extracted, extractOffset, res, pBuffer, offset, bytesToRead);
+	int copied = pBuffer ? ChunksCache::CopyAvailable(extracted, extractOffset, res, pBuffer, offset, bytesToRead) : 0;
 
 	if (m_zstates[spanix].state.isValid && (extractOffset + res) / span != offset / span) {
 		// The state no longer matches this span.
@@ -438,18 +467,12 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 		m_zstates[spanix].Kill();
 	}
 
-	if (size <= GZFILE_READ_CHUNK_SIZE)
-		m_cache.Take(extracted, extractOffset, res, size);
-	else { // split into cacheable chunks
-		for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE) {
-			int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
-			void* chunk = available ? malloc(available) : 0;
-			if (available)
-				memcpy(chunk, extracted + i, available);
-			m_cache.Take(chunk, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
-		}
-		free(extracted);
+	// split into cacheable chunks
+	for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE) {
+		int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
+		m_cache.Take(extracted + i, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
 	}
+	free(extracted);
 
 	int duration = NOW() - s;
 	if (duration > 10)
@@ -463,6 +486,10 @@ int GzippedFileReader::_ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRea
 }
 
 void GzippedFileReader::Close() {
+	// Nothing may still be extracting once the index and states are gone.
+	m_asyncRead.Cancel();
+	m_readAhead.Close();
+
 	m_filename.Empty();
 	if (m_pIndex) {
 		free_index((Access*)m_pIndex);
@@ -24,8 +24,9 @@ typedef struct zstate Zstate;
 #define GZFILE_SPAN_DEFAULT (1048576L * 4)   /* distance between direct access points when creating a new index */
 #define GZFILE_READ_CHUNK_SIZE (256 * 1024)  /* zlib extraction chunks size (at 0-based boundaries) */
 #define GZFILE_CACHE_SIZE_MB 200             /* cache size for extracted data. must be at least GZFILE_READ_CHUNK_SIZE (in MB)*/
+#define GZFILE_READAHEAD_CHUNKS 4            /* chunks extracted ahead once reads are sequential. 0 disables read-ahead */
 
-class GzippedFileReader : public AsyncFileReader
+class GzippedFileReader : public AsyncFileReader, public ChunksReadAhead::IChunkSource
 {
 	DeclareNoncopyableObject(GzippedFileReader);
 public:
@@ -40,7 +41,7 @@ public:
 
 	virtual void BeginRead(void* pBuffer, uint sector, uint count);
 	virtual int FinishRead(void);
-	virtual void CancelRead(void) {};
+	virtual void CancelRead(void);
 
 	virtual void Close(void);
 
@@ -68,15 +69,24 @@ private:
 	bool	OkIndex();  // Verifies that we have an index, or try to create one
 	PX_off_t GetOptimalExtractionStart(PX_off_t offset);
 	int     _ReadSync(void* pBuffer, PX_off_t offset, uint bytesToRead);
+	int     ExtractChunk(void* pBuffer, PX_off_t offset, uint bytesToRead);
 	void	InitZstates();
 
-	int		mBytesRead; // Temp sync read result when simulating async read
+	void	ExtractChunkAhead(PX_off_t offset);
+
 	Access* m_pIndex;   // Quick access index
 	Czstate* m_zstates;
 	FILE*	m_src;
 
 	ChunksCache m_cache;
 
+	// Serializes extraction (m_src, m_zstates) between the reading thread and the read-ahead.
+	Threading::Mutex m_mtx_Extract;
+	ChunksReadAhead m_readAhead;
+
+	// The read between BeginRead() and FinishRead(), running on the DecompressionPool.
+	AsyncReadJob m_asyncRead;
+
 #ifdef _WIN32
 	// Used by async prefetch
 	HANDLE hOverlappedFile;
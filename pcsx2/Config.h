@@ -70,6 +70,14 @@ enum class VsyncMode
 	Adaptive,
 };
 
+// How savestate entries are packed into the zip archive.
+enum class SavestateCompressionMethod
+{
+	Deflate,	// plain zip deflate, as states were packed before the zlib blocks
+	Zlib,		// independent zlib blocks, compressed and decompressed on all cores
+	ZlibFast,	// same as Zlib, at the fastest zlib level
+};
+
 // Template function for casting enumerations to their underlying type
 template <typename Enumeration>
 typename std::underlying_type<Enumeration>::type enum_cast(Enumeration E)
@@ -195,10 +203,10 @@ struct Pcsx2Config
 		BITFIELD32()
 			bool
 				Enabled:1,			// universal toggle for the profiler.
-				RecBlocks_EE:1,		// Enables per-block profiling for the EE recompiler [unimplemented]
-				RecBlocks_IOP:1,	// Enables per-block profiling for the IOP recompiler [unimplemented]
-				RecBlocks_VU0:1,	// Enables per-block profiling for the VU0 recompiler [unimplemented]
-				RecBlocks_VU1:1;	// Enables per-block profiling for the VU1 recompiler [unimplemented]
+				RecBlocks_EE:1,		// Enables per-block profiling for the EE recompiler
+				RecBlocks_IOP:1,	// Enables per-block profiling for the IOP recompiler
+				RecBlocks_VU0:1,	// Enables per-block profiling for the VU0 recompiler
+				RecBlocks_VU1:1;	// Enables per-block profiling for the VU1 recompiler
 		BITFIELD_END
 
 		// Default is Disabled, with all recs enabled underneath.
@@ -244,9 +252,15 @@ struct Pcsx2Config
 			bool
 				StackFrameChecks:1,
 				PreBlockCheckEE	:1,
-				PreBlockCheckIOP:1;
+				PreBlockCheckIOP:1,
+				ShadowCheckEE	:1;		// Also run EE rec blocks in the interpreter, and compare, see iR5900Shadow.h
+			bool
+				EnableEECache   :1,
+				EnableEETiering :1;		// Interpret new EE blocks a few times before recompiling them
 			bool
-				EnableEECache   :1;
+				EnableVUProgCache :1;	// Keep microVU programs across sessions, see microVU_ProgCache.h
+			bool
+				EnableFastmem	:1;		// EE loads/stores access kuseg RAM directly, see recVTLB.cpp
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -298,6 +312,10 @@ struct Pcsx2Config
 
 		int		VsyncQueueSize;
 
+		// number of pause iterations the MTGS spins for new ringbuffer data before it
+		// goes to sleep (0 always sleeps right away).
+		int		MTGSSpinCount;
+
 		bool		FrameLimitEnable;
 		bool		FrameSkipEnable;
 		VsyncMode	VsyncEnable;
@@ -319,6 +337,7 @@ struct Pcsx2Config
 			return
 				OpEqu( SynchronousMTGS )		&&
 				OpEqu( VsyncQueueSize )			&&
+				OpEqu( MTGSSpinCount )			&&
 				
 				OpEqu( FrameSkipEnable )		&&
 				OpEqu( FrameLimitEnable )		&&
@@ -451,12 +470,15 @@ struct Pcsx2Config
 			CdvdVerboseReads	:1,		// enables cdvd read activity verbosely dumped to the console
 			CdvdDumpBlocks		:1,		// enables cdvd block dumping
 			CdvdShareWrite		:1,		// allows the iso to be modified while it's loaded
+			CdvdMemoryMap		:1,		// reads flat isos through a memory mapping (Linux only, not with CdvdShareWrite)
 			EnablePatches		:1,		// enables patch detection and application
 			EnableCheats		:1,		// enables cheat detection and application
 			EnableWideScreenPatches		:1,
 		// when enabled uses BOOT2 injection, skipping sony bios splashes
 			UseBOOT2Injection	:1,
 			BackupSavestate		:1,
+		// keeps recent states in memory, so emulation can be rewound
+			EnableRewind		:1,
 		// enables simulated ejection of memory cards when loading savestates
 			McdEnableEjection	:1,
 			McdFolderAutoManage	:1,
@@ -479,6 +501,11 @@ struct Pcsx2Config
 
 	wxFileName			BiosFilename;
 
+	SavestateCompressionMethod	SavestateCompression;
+
+	uint				RewindInterval;		// frames between two rewind snapshots
+	uint				RewindBufferSize;	// memory budget for the rewind snapshots, in MB
+
 	Pcsx2Config();
 	void LoadSave( IniInterface& ini );
 
@@ -499,7 +526,10 @@ struct Pcsx2Config
 			OpEqu( Gamefixes )	&&
 			OpEqu( Profiler )	&&
 			OpEqu( Trace )		&&
-			OpEqu( BiosFilename );
+			OpEqu( BiosFilename )	&&
+			OpEqu( SavestateCompression )	&&
+			OpEqu( RewindInterval )	&&
+			OpEqu( RewindBufferSize );
 	}
 
 	bool operator !=( const Pcsx2Config& right ) const
@@ -28,7 +28,7 @@
 #warning AIO has been disabled.
 #endif
 
-FlatFileReader::FlatFileReader(bool shareWrite) : shareWrite(shareWrite)
+FlatFileReader::FlatFileReader(bool shareWrite, bool memoryMap) : shareWrite(shareWrite)
 {
 	m_blocksize = 2048;
 	m_fd = -1;
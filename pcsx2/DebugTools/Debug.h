@@ -208,6 +208,11 @@ public:
 	wxString GetCategory() const { return _parent::GetCategory() + L".Events"; }
 };
 
+// Receives everything the VM writes to its consoles, on the thread of the CPU writing it.
+// Set by the automated test runner (see gui/AutoTest.h), NULL otherwise.
+typedef void FnType_VMConsoleCapture( const wxChar* msg );
+extern FnType_VMConsoleCapture* VMConsoleCapture;
+
 // --------------------------------------------------------------------------------------
 //  ConsoleLogFromVM
 // --------------------------------------------------------------------------------------
@@ -232,6 +237,8 @@ public:
 		ConsoleColorScope cs(conColor);
 		Console.WriteRaw( msg );
 
+		if( VMConsoleCapture ) VMConsoleCapture( msg );
+
 		// Buffered output isn't compatible with the testsuite. The end of test
 		// doesn't always get flushed. Let's just flush all the output if EE/IOP
 		// print anything.
@@ -341,6 +341,13 @@ public:
 	Semaphore			m_sem_OpenDone;
 	std::atomic<bool>	m_PluginOpened;
 
+	// Ring wait statistics, for tuning GS.MTGSSpinCount.  Posts are counted on the
+	// EEcore side, the rest by the MTGS thread.
+	std::atomic<u32>	m_StatPosts;		// semaphore posts issued by SetEvent()
+	std::atomic<u32>	m_StatWakes;		// MTGS woken up through the semaphore
+	std::atomic<u32>	m_StatSpinHits;		// new work found while spinning
+	std::atomic<u32>	m_StatSleeps;		// spun without finding work, went to sleep
+
 	// These vars maintain instance data for sending Data Packets.
 	// Only one data packet can be constructed and uploaded at a time.
 
@@ -377,6 +384,9 @@ public:
 
 	bool IsPluginOpened() const { return m_PluginOpened; }
 
+	// True if the GS thread has nothing queued (only a hint, the EE may queue right after).
+	bool IsRingEmpty() const { return m_ReadPos.load(std::memory_order_relaxed) == m_WritePos.load(std::memory_order_relaxed); }
+
 protected:
 	void OpenPlugin();
 	void ClosePlugin();
@@ -390,6 +400,9 @@ protected:
 	void OnCleanupInThread();
 
 	void GenericStall( uint size );
+	bool HasPendingWork() const;
+	bool SpinForWork();
+	void LogWaitStats();
 
 	// Used internally by SendSimplePacket type functions
 	void _FinishSimplePacket();
@@ -16,6 +16,8 @@
 #include "PrecompiledHeader.h"
 #include "GameDatabase.h"
 
+#include <wx/ffile.h>
+
 BaseGameDatabaseImpl::BaseGameDatabaseImpl()
 	: gHash( 9400 )
 	, m_baseKey( L"Serial" )
@@ -50,12 +52,14 @@ BaseGameDatabaseImpl::~BaseGameDatabaseImpl()
 bool BaseGameDatabaseImpl::findGame(Game_Data& dest, const wxString& id) {
 
 	GameDataHash::const_iterator iter( gHash.find(id) );
-	if( iter == gHash.end() ) {
-		dest.clear();
-		return false;
+	if( iter != gHash.end() ) {
+		dest = *iter->second;
+		return true;
 	}
-	dest = *iter->second;
-	return true;
+	if( m_index.Find(dest, id) ) return true;
+
+	dest.clear();
+	return false;
 }
 
 Game_Data* BaseGameDatabaseImpl::createNewGame( const wxString& id )
@@ -82,6 +86,8 @@ Game_Data* BaseGameDatabaseImpl::createNewGame( const wxString& id )
 
 void BaseGameDatabaseImpl::updateGame(const Game_Data& game)
 {
+	ExpandIndex();
+
 	GameDataHash::const_iterator iter( gHash.find(game.id) );
 
 	if( iter == gHash.end() ) {
@@ -94,6 +100,32 @@ void BaseGameDatabaseImpl::updateGame(const Game_Data& game)
 	}
 }
 
+// Moves the games of the compiled index into the tables, where they can be modified and saved.
+void BaseGameDatabaseImpl::ExpandIndex()
+{
+	if( !m_index.IsLoaded() ) return;
+
+	m_index.Extract( *this );
+	m_index.Clear();
+}
+
+// All games, in the order they were created (which is their order in the text database).
+std::vector<const Game_Data*> BaseGameDatabaseImpl::GetGameList() const
+{
+	std::vector<const Game_Data*> games;
+
+	for(uint blockidx=0; blockidx<=m_BlockTableWritePos; ++blockidx)
+	{
+		if( !m_BlockTable[blockidx] ) continue;
+
+		const uint endidx = (blockidx == m_BlockTableWritePos) ? m_CurBlockWritePos : m_GamesPerBlock;
+
+		for( uint gameidx=0; gameidx<endidx; ++gameidx )
+			games.push_back( &m_BlockTable[blockidx][gameidx] );
+	}
+	return games;
+}
+
 // Searches the current game's data to see if the given key exists
 bool Game_Data::keyExists(const wxChar* key) const {
 	for (auto it = kList.begin(); it != kList.end(); ++it) {
@@ -142,4 +174,347 @@ void Game_Data::writeString(const wxString& key, const wxString& value) {
 // Write a bool value to the specified key
 void Game_Data::writeBool(const wxString& key, bool value) {
 	writeString(key, value ? L"1" : L"0");
-}
\ No newline at end of file
+}
+// --------------------------------------------------------------------------------------
+//  GameIndexImage  (implementations)
+// --------------------------------------------------------------------------------------
+// Image layout: Header, u32 displacements[bucketCount], u32 slots[slotCount] (index of the
+// game holding each serial), GameRecord[gameCount], PairRecord[pairCount], string pool.
+
+static const u32 GameIndexMagic		= 0x63424447;	// "GDBc"
+static const u32 GameIndexVersion	= 1;
+
+// Displacements tried per bucket before giving up on compiling the index.
+static const u32 GameIndexMaxSeed	= 1 << 20;
+
+struct GameIndexImage::Header
+{
+	u32		magic;
+	u32		version;
+	u64		srcSize;		// Size and modification time of the .dbf
+	s64		srcTime;
+	u32		gameCount;
+	u32		slotCount;		// Unique serials
+	u32		bucketCount;
+	u32		pairCount;
+	u32		poolSize;
+	u32		header;			// Comments at the start of the .dbf (string offset)
+};
+
+struct GameIndexImage::GameRecord
+{
+	u32		id;				// string offset
+	u32		firstPair;
+	u32		pairCount;
+};
+
+struct GameIndexImage::PairRecord
+{
+	u32		key;			// string offsets
+	u32		value;
+};
+
+// Serials are hashed lowercased, for case insensitive lookups.
+static std::string GameIndexKey( const wxString& id )
+{
+	return std::string( id.Lower().ToUTF8().data() );
+}
+
+// FNV-1a with a seeded basis, and murmur3's finalizer so that nearby seeds don't give
+// related hashes.
+static u32 GameIndexHash( const std::string& key, u32 seed )
+{
+	u32 hash = 0x811c9dc5 ^ (seed * 0x9e3779b1);
+	for( char c : key )
+	{
+		hash ^= (u8)c;
+		hash *= 0x01000193;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+template< typename T >
+static bool GameIndexWrite( wxFFile& file, const std::vector<T>& src )
+{
+	return src.empty() || file.Write( src.data(), src.size() * sizeof(T) ) == src.size() * sizeof(T);
+}
+
+// Compiles the given games into an index file.  Serials found more than once resolve to
+// their last game, which is what GameDataHash does too.
+bool GameIndexImage::Save( const wxString& file, u64 srcSize, s64 srcTime, const wxString& header, const std::vector<const Game_Data*>& games )
+{
+	std::vector<char> pool;
+	std::unordered_map<std::string, u32> interned;
+
+	auto intern = [&]( const wxString& str ) -> u32 {
+		std::string utf8( str.ToUTF8().data() );
+		auto found = interned.find( utf8 );
+		if( found != interned.end() ) return found->second;
+
+		const u32 offset = (u32)pool.size();
+		pool.insert( pool.end(), utf8.c_str(), utf8.c_str() + utf8.length() + 1 );
+		interned[utf8] = offset;
+		return offset;
+	};
+
+	std::vector<GameRecord> gameRecs;
+	std::vector<PairRecord> pairRecs;
+	std::vector<std::string> keys;				// per slot
+	std::vector<u32> slotGames;					// per slot
+	std::unordered_map<std::string, u32> keySlots;
+
+	gameRecs.reserve( games.size() );
+	for( const Game_Data* game : games )
+	{
+		const GameRecord rec = { intern( game->id ), (u32)pairRecs.size(), (u32)game->kList.size() };
+		for( const key_pair& pair : game->kList )
+		{
+			const PairRecord prec = { intern( pair.key ), intern( pair.value ) };
+			pairRecs.push_back( prec );
+		}
+
+		const std::string key( GameIndexKey( game->id ) );
+		auto found = keySlots.find( key );
+		if( found == keySlots.end() )
+		{
+			keySlots[key] = (u32)keys.size();
+			keys.push_back( key );
+			slotGames.push_back( (u32)gameRecs.size() );
+		}
+		else
+			slotGames[found->second] = (u32)gameRecs.size();
+
+		gameRecs.push_back( rec );
+	}
+
+	const u32 headerStr = intern( header );
+
+	// Hash and displace: serials are first spread over buckets, then the buckets, largest
+	// first, each look for a seed that sends all of their serials to free slots.
+	const u32 slotCount = (u32)keys.size();
+	const u32 bucketCount = std::max<u32>( 1, slotCount / 2 );
+
+	std::vector<std::vector<u32>> buckets( bucketCount );
+	for( u32 i=0; i<slotCount; ++i )
+		buckets[GameIndexHash( keys[i], 0 ) % bucketCount].push_back( i );
+
+	std::vector<u32> order( bucketCount );
+	for( u32 i=0; i<bucketCount; ++i ) order[i] = i;
+	std::stable_sort( order.begin(), order.end(), [&]( u32 a, u32 b ) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	std::vector<u32> displacements( bucketCount, 0 );
+	std::vector<u32> slots( slotCount, (u32)-1 );
+	std::vector<u32> placed;
+
+	for( u32 b : order )
+	{
+		const std::vector<u32>& bucket = buckets[b];
+		if( bucket.empty() ) break;
+
+		u32 seed = 1;
+		for( ; seed < GameIndexMaxSeed; ++seed )
+		{
+			placed.clear();
+			for( u32 k : bucket )
+			{
+				const u32 slot = GameIndexHash( keys[k], seed ) % slotCount;
+				if( slots[slot] != (u32)-1 || std::find( placed.begin(), placed.end(), slot ) != placed.end() ) break;
+				placed.push_back( slot );
+			}
+			if( placed.size() == bucket.size() ) break;
+		}
+
+		if( seed == GameIndexMaxSeed )
+		{
+			Console.Warning( "(GameDB) Could not compile the index (no perfect hash found)." );
+			return false;
+		}
+
+		displacements[b] = seed;
+		for( uint i=0; i<bucket.size(); ++i )
+			slots[placed[i]] = slotGames[bucket[i]];
+	}
+
+	Header hdr;
+	memzero( hdr );
+	hdr.magic		= GameIndexMagic;
+	hdr.version		= GameIndexVersion;
+	hdr.srcSize		= srcSize;
+	hdr.srcTime		= srcTime;
+	hdr.gameCount	= (u32)gameRecs.size();
+	hdr.slotCount	= slotCount;
+	hdr.bucketCount	= bucketCount;
+	hdr.pairCount	= (u32)pairRecs.size();
+	hdr.poolSize	= (u32)pool.size();
+	hdr.header		= headerStr;
+
+	wxFFile out( file, L"wb" );
+	if( !out.IsOpened() ) return false;
+
+	const bool ok = out.Write( &hdr, sizeof(hdr) ) == sizeof(hdr)
+		&& GameIndexWrite( out, displacements ) && GameIndexWrite( out, slots )
+		&& GameIndexWrite( out, gameRecs ) && GameIndexWrite( out, pairRecs )
+		&& GameIndexWrite( out, pool );
+	out.Close();
+
+	// A partial image would fail to validate anyway, but don't leave it around.
+	if( !ok ) wxRemoveFile( file );
+	return ok;
+}
+
+bool GameIndexImage::Load( const wxString& file, u64 srcSize, s64 srcTime )
+{
+	Clear();
+
+	if( !wxFileExists( file ) ) return false;
+
+	wxFFile in( file, L"rb" );
+	if( !in.IsOpened() ) return false;
+
+	const wxFileOffset length = in.Length();
+	if( length < (wxFileOffset)sizeof(Header) ) return false;
+
+	m_image.resize( (size_t)length );
+	if( in.Read( m_image.data(), m_image.size() ) != m_image.size() )
+	{
+		Clear();
+		return false;
+	}
+
+	const Header& hdr = GetImageHeader();
+	if( hdr.magic != GameIndexMagic || hdr.version != GameIndexVersion
+	||  hdr.srcSize != srcSize || hdr.srcTime != srcTime || !Validate() )
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+// Checks that every table and offset of the image is within bounds, so that the lookups
+// don't have to.
+bool GameIndexImage::Validate() const
+{
+	const Header& hdr = GetImageHeader();
+
+	const u64 size = sizeof(Header)
+		+ ((u64)hdr.bucketCount + hdr.slotCount) * sizeof(u32)
+		+ (u64)hdr.gameCount * sizeof(GameRecord)
+		+ (u64)hdr.pairCount * sizeof(PairRecord)
+		+ hdr.poolSize;
+
+	if( size != m_image.size() || !hdr.bucketCount || hdr.slotCount > hdr.gameCount ) return false;
+	if( !hdr.poolSize || GetString(0)[hdr.poolSize - 1] != 0 || hdr.header >= hdr.poolSize ) return false;
+
+	const u32* slots = GetSlots();
+	for( u32 i=0; i<hdr.slotCount; ++i )
+		if( slots[i] >= hdr.gameCount ) return false;
+
+	const GameRecord* games = GetGames();
+	for( u32 i=0; i<hdr.gameCount; ++i )
+	{
+		if( games[i].id >= hdr.poolSize ) return false;
+		if( (u64)games[i].firstPair + games[i].pairCount > hdr.pairCount ) return false;
+	}
+
+	const PairRecord* pairs = GetPairs();
+	for( u32 i=0; i<hdr.pairCount; ++i )
+		if( pairs[i].key >= hdr.poolSize || pairs[i].value >= hdr.poolSize ) return false;
+
+	return true;
+}
+
+void GameIndexImage::Clear()
+{
+	m_image.clear();
+	m_image.shrink_to_fit();
+}
+
+uint GameIndexImage::GetGameCount() const
+{
+	return IsLoaded() ? GetImageHeader().gameCount : 0;
+}
+
+wxString GameIndexImage::GetHeader() const
+{
+	return IsLoaded() ? fromUTF8( GetString( GetImageHeader().header ) ) : wxString();
+}
+
+const GameIndexImage::Header& GameIndexImage::GetImageHeader() const
+{
+	return *(const Header*)m_image.data();
+}
+
+const u32* GameIndexImage::GetDisplacements() const
+{
+	return (const u32*)(m_image.data() + sizeof(Header));
+}
+
+const u32* GameIndexImage::GetSlots() const
+{
+	return GetDisplacements() + GetImageHeader().bucketCount;
+}
+
+const GameIndexImage::GameRecord* GameIndexImage::GetGames() const
+{
+	return (const GameRecord*)(GetSlots() + GetImageHeader().slotCount);
+}
+
+const GameIndexImage::PairRecord* GameIndexImage::GetPairs() const
+{
+	return (const PairRecord*)(GetGames() + GetImageHeader().gameCount);
+}
+
+const char* GameIndexImage::GetString( u32 offset ) const
+{
+	return (const char*)(GetPairs() + GetImageHeader().pairCount) + offset;
+}
+
+void GameIndexImage::ReadGame( Game_Data& dest, const GameRecord& game ) const
+{
+	dest.clear();
+	dest.id = fromUTF8( GetString( game.id ) );
+	dest.kList.reserve( game.pairCount );
+
+	const PairRecord* pairs = GetPairs() + game.firstPair;
+	for( u32 i=0; i<game.pairCount; ++i )
+		dest.kList.push_back( key_pair( fromUTF8( GetString( pairs[i].key ) ), fromUTF8( GetString( pairs[i].value ) ) ) );
+}
+
+bool GameIndexImage::Find( Game_Data& dest, const wxString& id ) const
+{
+	if( !IsLoaded() ) return false;
+
+	const Header& hdr = GetImageHeader();
+	if( !hdr.slotCount ) return false;
+
+	const std::string key( GameIndexKey( id ) );
+	const u32 seed = GetDisplacements()[GameIndexHash( key, 0 ) % hdr.bucketCount];
+	const GameRecord& game = GetGames()[GetSlots()[GameIndexHash( key, seed ) % hdr.slotCount]];
+
+	// Serials that aren't in the database land on some other game's slot.
+	if( fromUTF8( GetString( game.id ) ).CmpNoCase( id ) != 0 ) return false;
+
+	ReadGame( dest, game );
+	return true;
+}
+
+void GameIndexImage::Extract( IGameDatabase& db ) const
+{
+	if( !IsLoaded() ) return;
+
+	const GameRecord* games = GetGames();
+	for( u32 i=0; i<GetImageHeader().gameCount; ++i )
+	{
+		Game_Data* game = db.createNewGame( fromUTF8( GetString( games[i].id ) ) );
+		ReadGame( *game, games[i] );
+	}
+}
@@ -188,6 +188,60 @@ public:
 
 typedef std::unordered_map<wxString, Game_Data*, StringHashNoCase> GameDataHash;
 
+// --------------------------------------------------------------------------------------
+//  GameIndexImage
+// --------------------------------------------------------------------------------------
+// Compiled form of the game database, so that it doesn't have to be parsed on every launch.
+// The whole file is read into a single buffer and used in place:
+//
+//  * Serials are found through a perfect hash (hash and displace): one probe into the
+//    displacement table, one into the slot table, and a compare against the serial stored
+//    there.  Lookups are case insensitive, like GameDataHash.
+//  * Keys and values are stored once each in a UTF-8 string pool, and games refer to them
+//    by offset; only the game asked for is turned into a Game_Data.
+//
+// The image remembers the size and modification time of the .dbf it was compiled from, and
+// Load() refuses it when they don't match anymore.
+//
+class GameIndexImage
+{
+	DeclareNoncopyableObject( GameIndexImage );
+
+public:
+	GameIndexImage() = default;
+	virtual ~GameIndexImage() = default;
+
+	bool Load( const wxString& file, u64 srcSize, s64 srcTime );
+	static bool Save( const wxString& file, u64 srcSize, s64 srcTime, const wxString& header, const std::vector<const Game_Data*>& games );
+
+	void Clear();
+	bool IsLoaded() const { return !m_image.empty(); }
+	uint GetGameCount() const;
+	wxString GetHeader() const;
+
+	bool Find( Game_Data& dest, const wxString& id ) const;
+
+	// Recreates every game of the image in db, in their original order.
+	void Extract( IGameDatabase& db ) const;
+
+protected:
+	struct Header;
+	struct GameRecord;
+	struct PairRecord;
+
+	const Header& GetImageHeader() const;
+	const u32* GetDisplacements() const;
+	const u32* GetSlots() const;
+	const GameRecord* GetGames() const;
+	const PairRecord* GetPairs() const;
+	const char* GetString( u32 offset ) const;
+
+	void ReadGame( Game_Data& dest, const GameRecord& game ) const;
+	bool Validate() const;
+
+	std::vector<u8>		m_image;
+};
+
 // --------------------------------------------------------------------------------------
 //  BaseGameDatabaseImpl 
 // --------------------------------------------------------------------------------------
@@ -204,6 +258,10 @@ protected:
 	int						m_CurBlockWritePos;
 	int						m_GamesPerBlock;
 
+	// Games loaded from a compiled index rather than the text database; they're moved
+	// into the tables above before anything gets modified.
+	GameIndexImage			m_index;
+
 public:
 	BaseGameDatabaseImpl();
 	virtual ~BaseGameDatabaseImpl();
@@ -214,6 +272,10 @@ public:
 	bool findGame(Game_Data& dest, const wxString& id);
 	Game_Data* createNewGame( const wxString& id );
 	void updateGame(const Game_Data& game);
+
+protected:
+	void ExpandIndex();
+	std::vector<const Game_Data*> GetGameList() const;
 };
 
 extern IGameDatabase* AppHost_GetGameDatabase();
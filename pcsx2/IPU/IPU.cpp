@@ -646,50 +646,73 @@ static void ipuSETTH(u32 val)
 // --------------------------------------------------------------------------------------
 __fi void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn)
 {
-	int i;
-	u8* p = (u8*)&rgb32;
-
 	yuv2rgb();
 
-	if (s_thresh[0] > 0)
-	{
-		for (i = 0; i < 16*16; i++, p += 4)
-		{
-			if ((p[0] < s_thresh[0]) && (p[1] < s_thresh[0]) && (p[2] < s_thresh[0]))
-				*(u32*)p = 0;
-			else if ((p[0] < s_thresh[1]) && (p[1] < s_thresh[1]) && (p[2] < s_thresh[1]))
-				p[3] = 0x40;
-		}
-	}
-	else if (s_thresh[1] > 0)
-	{
-		for (i = 0; i < 16*16; i++, p += 4)
-		{
-			if ((p[0] < s_thresh[1]) && (p[1] < s_thresh[1]) && (p[2] < s_thresh[1]))
-				p[3] = 0x40;
-		}
-	}
-	if (sgn)
+	if (!s_thresh[0] && !s_thresh[1] && !sgn) return;
+
+	// Pixels with R, G and B all below thresh[0] become 0, the other ones with all three
+	// below thresh[1] get an alpha of 0x40.  A threshold of 0 never matches, so a single
+	// pass covers both of the cases.  Done 4 pixels at a time.
+	const __m128i th0 = _mm_set1_epi8(s_thresh[0]);
+	const __m128i th1 = _mm_set1_epi8(s_thresh[1]);
+	const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+	const __m128i alpha_40 = _mm_set1_epi32(0x40000000);
+	const __m128i sgn_mask = _mm_set1_epi32(sgn ? 0x00808080 : 0);
+	const bool thresh = s_thresh[0] || s_thresh[1];
+
+	__m128i* p = (__m128i*)&rgb32;
+	for (int i = 0; i < 16*16/4; i++)
 	{
-		for (i = 0; i < 16*16; i++, p += 4)
+		__m128i c = _mm_load_si128(p + i);
+
+		if (thresh)
 		{
-			*(u32*)p ^= 0x808080;
+			// subs(th, c) is nonzero exactly where c < th.
+			const __m128i ge0 = _mm_cmpeq_epi8(_mm_subs_epu8(th0, c), _mm_setzero_si128());
+			const __m128i ge1 = _mm_cmpeq_epi8(_mm_subs_epu8(th1, c), _mm_setzero_si128());
+			const __m128i below0 = _mm_cmpeq_epi32(_mm_and_si128(ge0, rgb_mask), _mm_setzero_si128());
+			const __m128i below1 = _mm_cmpeq_epi32(_mm_and_si128(ge1, rgb_mask), _mm_setzero_si128());
+
+			c = _mm_or_si128(_mm_andnot_si128(below1, c),
+				_mm_and_si128(below1, _mm_or_si128(_mm_and_si128(c, rgb_mask), alpha_40)));
+			c = _mm_andnot_si128(below0, c);
 		}
+
+		_mm_store_si128(p + i, _mm_xor_si128(c, sgn_mask));
 	}
 }
 
 __fi void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte)
 {
-	int i, j;
-	for (i = 0; i < 16; ++i)
+	// 8:8:8:8 to 5:5:5:1, with A set where the alpha is 0x40.  Done 8 pixels at a time.
+	const __m128i r_mask = _mm_set1_epi32(0x001f);
+	const __m128i g_mask = _mm_set1_epi32(0x03e0);
+	const __m128i b_mask = _mm_set1_epi32(0x7c00);
+	const __m128i a_mask = _mm_set1_epi32(0xff000000);
+	const __m128i alpha_40 = _mm_set1_epi32(0x40000000);
+	const __m128i a_bit = _mm_set1_epi32(0x8000);
+
+	const __m128i* src = (const __m128i*)&rgb32;
+	__m128i* dest = (__m128i*)&rgb16;
+
+	for (int i = 0; i < 16*16/8; i++)
 	{
-		for (j = 0; j < 16; ++j)
+		__m128i out[2];
+
+		for (int h = 0; h < 2; h++)
 		{
-			rgb16.c[i][j].r = rgb32.c[i][j].r >> 3;
-			rgb16.c[i][j].g = rgb32.c[i][j].g >> 3;
-			rgb16.c[i][j].b = rgb32.c[i][j].b >> 3;
-			rgb16.c[i][j].a = rgb32.c[i][j].a == 0x40;
+			const __m128i c = _mm_load_si128(src + i*2 + h);
+
+			__m128i v = _mm_and_si128(_mm_srli_epi32(c, 3), r_mask);
+			v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(c, 6), g_mask));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(c, 9), b_mask));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(c, a_mask), alpha_40), a_bit));
+
+			// Sign extend bit 15 so that packssdw doesn't saturate the A bit away.
+			out[h] = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
 		}
+
+		_mm_store_si128(dest + i, _mm_packs_epi32(out[0], out[1]));
 	}
 }
 
@@ -22,9 +22,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
-// [TODO] : There are modern SSE versions of idct (idct_mmx.c) in the mpeg2 libs that we
-// should probably upgrade to.  They use their own raw-style intrinsics and not the intel
-// compiler-integrated ones.
+// The IDCT is done with SSE2 (idct_sse2), 8 rows or columns at a time.  It computes
+// exactly what the scalar reference (idct_row / idct_col) does, including the 16 bit
+// truncation between the passes, so the output doesn't change; debug builds check it
+// against the reference on every block.
 
 #include "PrecompiledHeader.h"
 
@@ -39,16 +40,6 @@
 #define W6 1108 /* 2048*sqrt (2)*cos (6*pi/16) */
 #define W7 565  /* 2048*sqrt (2)*cos (7*pi/16) */
 
-/*
- * In legal streams, the IDCT output should be between -384 and +384.
- * In corrupted streams, it is possible to force the IDCT output to go
- * to +-3826 - this is the worst case for a column IDCT where the
- * column inputs are 16-bit values.
- */
-static __aligned16 u8 clip_lut[1024];
-
-#define CLIP(i) ((clip_lut+384)[(i)])
-
 static __fi void BUTTERFLY(int& t0, int& t1, int w0, int w1, int d0, int d1)
 {
 #if 0
@@ -155,7 +146,8 @@ static __fi void idct_col (s16 * const block)
     block[8*7] = (a0 - b0) >> 17;
 }
 
-__ri void mpeg2_idct_copy(s16 * block, u8 * dest, const int stride)
+// Scalar IDCT, in place.  Reference for idct_sse2.
+static void idct_ref (s16 * const block)
 {
     int i;
 
@@ -163,23 +155,177 @@ __ri void mpeg2_idct_copy(s16 * block, u8 * dest, const int stride)
 		idct_row (block + 8 * i);
     for (i = 0; i < 8; i++)
 		idct_col (block + i);
+}
+
+// --------------------------------------------------------------------------------------
+//  SSE2 IDCT
+// --------------------------------------------------------------------------------------
+// Each BUTTERFLY is a single pmaddwd on the interleaved inputs, which is exact since the
+// inputs of both passes are 16 bit.  The rest is done on 32 bit lanes, with the same
+// shifts (and the same wrap around on corrupted streams) as the scalar code.  The row
+// shortcut of idct_row isn't needed: it gives the same result as the full transform.
+
+// Both 16 bit halves of each dword; the low one multiplies the first pmaddwd input.
+#define IDCT_PAIR(lo, hi) _mm_set1_epi32((u16)(lo) | ((u32)(u16)(hi) << 16))
+
+static __fi __m128i idct_mul181(const __m128i& v)
+{
+	// 181 = 128 + 32 + 16 + 4 + 1 (there's no 32 bit multiply in SSE2)
+	__m128i r = _mm_add_epi32(v, _mm_slli_epi32(v, 2));
+	r = _mm_add_epi32(r, _mm_slli_epi32(v, 4));
+	r = _mm_add_epi32(r, _mm_slli_epi32(v, 5));
+	return _mm_add_epi32(r, _mm_slli_epi32(v, 7));
+}
 
-	__m128 zero = _mm_setzero_ps();
-    do {
-		dest[0] = CLIP (block[0]);
-		dest[1] = CLIP (block[1]);
-		dest[2] = CLIP (block[2]);
-		dest[3] = CLIP (block[3]);
-		dest[4] = CLIP (block[4]);
-		dest[5] = CLIP (block[5]);
-		dest[6] = CLIP (block[6]);
-		dest[7] = CLIP (block[7]);
-
-		_mm_store_ps((float*)block, zero);
-
-		dest += stride;
-		block += 8;
-    } while (--i);
+// Transforms 4 lanes of one pass.  p02, p31, p74 and p56 are the interleaved inputs
+// (x0,x2), (x3,x1), (x7,x4) and (x5,x6); out receives the 32 bit results, unshifted.
+template< bool col >
+static __fi void idct_half_sse2(const __m128i& p02, const __m128i& p31, const __m128i& p74,
+								const __m128i& p56, __m128i (&out)[8])
+{
+	const __m128i bias = _mm_set1_epi32(col ? 65536 : 128);
+
+	__m128i t0 = _mm_add_epi32(_mm_madd_epi16(p02, IDCT_PAIR(2048,  2048)), bias);
+	__m128i t1 = _mm_add_epi32(_mm_madd_epi16(p02, IDCT_PAIR(2048, -2048)), bias);
+	__m128i t2 = _mm_madd_epi16(p31, IDCT_PAIR(W6, W2));
+	__m128i t3 = _mm_madd_epi16(p31, IDCT_PAIR(-W2, W6));
+
+	const __m128i a0 = _mm_add_epi32(t0, t2);
+	const __m128i a1 = _mm_add_epi32(t1, t3);
+	const __m128i a2 = _mm_sub_epi32(t1, t3);
+	const __m128i a3 = _mm_sub_epi32(t0, t2);
+
+	t0 = _mm_madd_epi16(p74, IDCT_PAIR(W7, W1));
+	t1 = _mm_madd_epi16(p74, IDCT_PAIR(-W1, W7));
+	t2 = _mm_madd_epi16(p56, IDCT_PAIR(W3, W5));
+	t3 = _mm_madd_epi16(p56, IDCT_PAIR(-W5, W3));
+
+	const __m128i b0 = _mm_add_epi32(t0, t2);
+	const __m128i b3 = _mm_add_epi32(t1, t3);
+	t0 = _mm_sub_epi32(t0, t2);
+	t1 = _mm_sub_epi32(t1, t3);
+
+	__m128i b1, b2;
+	if (col) {
+		t0 = _mm_srai_epi32(t0, 8);
+		t1 = _mm_srai_epi32(t1, 8);
+		b1 = idct_mul181(_mm_add_epi32(t0, t1));
+		b2 = idct_mul181(_mm_sub_epi32(t0, t1));
+	} else {
+		b1 = _mm_srai_epi32(idct_mul181(_mm_add_epi32(t0, t1)), 8);
+		b2 = _mm_srai_epi32(idct_mul181(_mm_sub_epi32(t0, t1)), 8);
+	}
+
+	out[0] = _mm_add_epi32(a0, b0);
+	out[1] = _mm_add_epi32(a1, b1);
+	out[2] = _mm_add_epi32(a2, b2);
+	out[3] = _mm_add_epi32(a3, b3);
+	out[4] = _mm_sub_epi32(a3, b3);
+	out[5] = _mm_sub_epi32(a2, b2);
+	out[6] = _mm_sub_epi32(a1, b1);
+	out[7] = _mm_sub_epi32(a0, b0);
+}
+
+// Shifts the 32 bit results down and packs them to 16 bits the way a store to s16 does
+// (truncating, not saturating).
+template< int shift >
+static __fi __m128i idct_pack_sse2(const __m128i& lo, const __m128i& hi)
+{
+	const __m128i l = _mm_srai_epi32(_mm_slli_epi32(_mm_srai_epi32(lo, shift), 16), 16);
+	const __m128i h = _mm_srai_epi32(_mm_slli_epi32(_mm_srai_epi32(hi, shift), 16), 16);
+	return _mm_packs_epi32(l, h);
+}
+
+// One pass over 8 vectors.  Vector k holds input k (the k-th coefficient) of 8 rows or
+// columns, one per 16 bit lane.
+template< bool col >
+static __fi void idct_pass_sse2(__m128i (&x)[8])
+{
+	__m128i lo[8], hi[8];
+
+	idct_half_sse2<col>(_mm_unpacklo_epi16(x[0], x[2]), _mm_unpacklo_epi16(x[3], x[1]),
+						_mm_unpacklo_epi16(x[7], x[4]), _mm_unpacklo_epi16(x[5], x[6]), lo);
+	idct_half_sse2<col>(_mm_unpackhi_epi16(x[0], x[2]), _mm_unpackhi_epi16(x[3], x[1]),
+						_mm_unpackhi_epi16(x[7], x[4]), _mm_unpackhi_epi16(x[5], x[6]), hi);
+
+	for (int i = 0; i < 8; i++)
+		x[i] = idct_pack_sse2<col ? 17 : 8>(lo[i], hi[i]);
+}
+
+static __fi void idct_transpose_sse2(__m128i (&x)[8])
+{
+	const __m128i a0 = _mm_unpacklo_epi16(x[0], x[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(x[0], x[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(x[2], x[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(x[2], x[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(x[4], x[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(x[4], x[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(x[6], x[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(x[6], x[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	x[0] = _mm_unpacklo_epi64(b0, b4);
+	x[1] = _mm_unpackhi_epi64(b0, b4);
+	x[2] = _mm_unpacklo_epi64(b1, b5);
+	x[3] = _mm_unpackhi_epi64(b1, b5);
+	x[4] = _mm_unpacklo_epi64(b2, b6);
+	x[5] = _mm_unpackhi_epi64(b2, b6);
+	x[6] = _mm_unpacklo_epi64(b3, b7);
+	x[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// Transforms the (16 byte aligned) block into rows, and clears it.
+static __fi void idct_sse2(s16 * const block, __m128i (&rows)[8])
+{
+#ifdef PCSX2_DEBUG
+	__aligned16 s16 ref[64];
+	memcpy(ref, block, sizeof(ref));
+	idct_ref(ref);
+#endif
+
+	const __m128i zero = _mm_setzero_si128();
+	for (int i = 0; i < 8; i++) {
+		rows[i] = _mm_load_si128((__m128i*)block + i);
+		_mm_store_si128((__m128i*)block + i, zero);
+	}
+
+	idct_transpose_sse2(rows);
+	idct_pass_sse2<false>(rows);
+	idct_transpose_sse2(rows);
+	idct_pass_sse2<true>(rows);
+
+#ifdef PCSX2_DEBUG
+	pxAssertMsg(memcmp(ref, rows, sizeof(ref)) == 0, "IPU: SSE2 IDCT doesn't match the reference.");
+#endif
+}
+
+#undef IDCT_PAIR
+
+__ri void mpeg2_idct_copy(s16 * block, u8 * dest, const int stride)
+{
+	__m128i rows[8];
+	idct_sse2(block, rows);
+
+	/*
+	 * In legal streams, the IDCT output should be between -384 and +384.
+	 * In corrupted streams, it is possible to force the IDCT output to go
+	 * to +-3826 - this is the worst case for a column IDCT where the
+	 * column inputs are 16-bit values.  packuswb clamps all of it to 0..255.
+	 */
+	for (int i = 0; i < 8; i += 2) {
+		const __m128i pix = _mm_packus_epi16(rows[i], rows[i+1]);
+		_mm_storel_epi64((__m128i*)dest, pix);
+		_mm_storel_epi64((__m128i*)(dest + stride), _mm_unpackhi_epi64(pix, pix));
+		dest += stride * 2;
+	}
 }
 
 
@@ -190,21 +336,11 @@ __ri void mpeg2_idct_add (const int last, s16 * block, s16 * dest, const int str
 
     if (last != 129 || (block[0] & 7) == 4)
     {
-		int i;
-		for (i = 0; i < 8; i++)
-			idct_row (block + 8 * i);
-		for (i = 0; i < 8; i++)
-			idct_col (block + i);
-
-		__m128 zero = _mm_setzero_ps();
-		do {
-			_mm_store_ps((float*)dest, _mm_load_ps((float*)block));
-			_mm_store_ps((float*)block, zero);
-
-			dest += stride;
-			block += 8;
-		} while (--i);
+		__m128i rows[8];
+		idct_sse2(block, rows);
 
+		for (int i = 0; i < 8; i++)
+			_mm_store_si128((__m128i*)(dest + stride * i), rows[i]);
     }
     else
     {
@@ -237,9 +373,6 @@ mpeg2_scan_pack::mpeg2_scan_pack()
 		53, 61, 22, 30,  7, 15, 23, 31, 38, 46, 54, 62, 39, 47, 55, 63
 	};
 
-	for (int i = -384; i < 640; i++)
-		clip_lut[i+384] = (i < 0) ? 0 : ((i > 255) ? 255 : i);
-
 	for (int i = 0; i < 64; i++) {
 		int j = mpeg2_scan_norm[i];
 		norm[i] = ((j & 0x36) >> 1) | ((j & 0x09) << 2);
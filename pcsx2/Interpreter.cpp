@@ -33,6 +33,7 @@ extern int vu0branch, vu1branch;
 
 static int branch2 = 0;
 static u32 cpuBlockCycles = 0;		// 3 bit fixed point version of cycle count
+static bool intEventTestsHeld = false;	// set by intShadowBlock
 static std::string disOut;
 
 static void intEventTest();
@@ -223,6 +224,30 @@ void __fastcall intDoBranch(u32 target)
 	}
 }
 
+void intExecuteBlock(u32 endpc)
+{
+	u32 pc;
+	do {
+		pc = cpuRegs.pc;
+		execI();
+	} while (cpuRegs.pc == pc + 4 && cpuRegs.pc != endpc);
+
+	// Taken branches already added theirs
+	cpuRegs.cycle += cpuBlockCycles >> 3;
+	cpuBlockCycles &= (1<<3)-1;
+}
+
+void intShadowBlock(u32 endpc)
+{
+	const u32 blockCycles = cpuBlockCycles;
+	ScopedBool held(intEventTestsHeld);
+
+	intExecuteBlock(endpc);
+
+	// The cycles are the caller's to put back, with the rest of cpuRegs
+	cpuBlockCycles = blockCycles;
+}
+
 void intSetBranch()
 {
 	branch2 = /*cpuRegs.branch =*/ 1;
@@ -500,6 +525,8 @@ static void intReset()
 
 static void intEventTest()
 {
+	if (intEventTestsHeld) return;
+
 	// Perform counters, ints, and IOP updates:
 	_cpuEventTest_Shared();
 }
@@ -15,12 +15,29 @@
 
 #include "PrecompiledHeader.h"
 #include "AsyncFileReader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-FlatFileReader::FlatFileReader(bool shareWrite) : shareWrite(shareWrite)
+// Consecutive reads before the mapping is advised as sequential.
+static const uint MappingSequentialReads = 4;
+// How far ahead of a sequential read the kernel is asked to page in.
+static const u64 MappingReadAhead = 2 * _1mb;
+// Largest file mapped: the 32 bit build keeps its address space for the emulator.
+static const u64 MappingMaxSize = (sizeof(void*) > 4) ? (u64)-1 : (u64)_1gb;
+
+FlatFileReader::FlatFileReader(bool shareWrite, bool memoryMap) : shareWrite(shareWrite)
 {
 	m_blocksize = 2048;
 	m_fd = -1;
 	m_aio_context = 0;
+
+	m_memoryMap = memoryMap;
+	m_mapping = NULL;
+	m_mappingSize = 0;
+	m_mappingBytesRead = -1;
+	m_nextSequentialOffset = 0;
+	m_sequentialReads = 0;
+	m_willNeedEnd = 0;
 }
 
 FlatFileReader::~FlatFileReader(void)
@@ -32,16 +49,104 @@ bool FlatFileReader::Open(const wxString& fileName)
 {
 	m_filename = fileName;
 
+	m_fd = wxOpen(fileName, O_RDONLY, 0);
+	if (m_fd == -1) return false;
+
+	// Another process may truncate a shared file, which would fault reads from the mapping.
+	if (m_memoryMap && !shareWrite && OpenMapping())
+		return true;
+
 	int err = io_setup(64, &m_aio_context);
 	if (err) return false;
 
-    m_fd = wxOpen(fileName, O_RDONLY, 0);
+	return true;
+}
+
+bool FlatFileReader::OpenMapping()
+{
+	struct stat st;
+	if (fstat(m_fd, &st) != 0 || st.st_size <= 0)
+		return false;
+
+	if ((u64)st.st_size > MappingMaxSize) {
+		DevCon.WriteLn(L"CDVD: '%s' is too large to be memory mapped, using aio.", WX_STR(m_filename));
+		return false;
+	}
+
+	void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (mapping == MAP_FAILED) {
+		Console.Warning(L"CDVD: Unable to memory map '%s', falling back to aio.", WX_STR(m_filename));
+		return false;
+	}
+
+	m_mapping = (u8*)mapping;
+	m_mappingSize = st.st_size;
+	m_mappingBytesRead = -1;
+	m_nextSequentialOffset = 0;
+	m_sequentialReads = 0;
+	m_willNeedEnd = 0;
+
+	DevCon.WriteLn(L"CDVD: Memory mapped '%s'", WX_STR(m_filename));
+	return true;
+}
+
+void FlatFileReader::CloseMapping()
+{
+	if (m_mapping)
+		munmap(m_mapping, m_mappingSize);
+
+	m_mapping = NULL;
+	m_mappingSize = 0;
+}
+
+// Switches the kernel paging policy between sequential and random depending on how the
+// game reads, and pages in the data right after a sequential stream before it's needed.
+void FlatFileReader::AdviseMapping(u64 offset, u32 bytes)
+{
+	const uptr pageMask = __pagesize - 1;
+
+	if (offset == m_nextSequentialOffset) {
+		if (++m_sequentialReads == MappingSequentialReads) {
+			madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+			m_willNeedEnd = offset;
+		}
+	} else {
+		if (m_sequentialReads >= MappingSequentialReads)
+			madvise(m_mapping, m_mappingSize, MADV_RANDOM);
+		m_sequentialReads = 0;
+	}
+	m_nextSequentialOffset = offset + bytes;
+
+	if (m_sequentialReads < MappingSequentialReads)
+		return;
 
-	return (m_fd != -1);
+	// Refill the window once half of it has been consumed.
+	if (offset + bytes + MappingReadAhead / 2 < m_willNeedEnd)
+		return;
+
+	u64 start = std::max(m_willNeedEnd, offset + bytes) & ~(u64)pageMask;
+	u64 end = std::min(offset + bytes + MappingReadAhead, m_mappingSize);
+	if (start < end)
+		madvise(m_mapping + start, end - start, MADV_WILLNEED);
+	m_willNeedEnd = end;
+}
+
+int FlatFileReader::ReadMapping(void* pBuffer, u64 offset, u32 bytesToRead)
+{
+	if (offset >= m_mappingSize)
+		return -1;
+
+	u32 bytes = (u32)std::min<u64>(bytesToRead, m_mappingSize - offset);
+	AdviseMapping(offset, bytes);
+	memcpy(pBuffer, m_mapping + offset, bytes);
+	return bytes;
 }
 
 int FlatFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 {
+	if (m_mapping)
+		return ReadMapping(pBuffer, sector * (s64)m_blocksize + m_dataoffset, count * m_blocksize);
+
 	BeginRead(pBuffer, sector, count);
 	return FinishRead();
 }
@@ -53,6 +158,12 @@ void FlatFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 
 	u32 bytesToRead = count * m_blocksize;
 
+	if (m_mapping) {
+		// Nothing to wait for, the copy itself is the read.
+		m_mappingBytesRead = ReadMapping(pBuffer, offset, bytesToRead);
+		return;
+	}
+
 	struct iocb iocb;
 	struct iocb* iocbs = &iocb;
 
@@ -62,6 +173,12 @@ void FlatFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 
 int FlatFileReader::FinishRead(void)
 {
+	if (m_mapping) {
+		int res = m_mappingBytesRead;
+		m_mappingBytesRead = -1;
+		return res;
+	}
+
 	int min_nr = 1;
 	int max_nr = 1;
 	struct io_event events[max_nr];
@@ -76,6 +193,8 @@ int FlatFileReader::FinishRead(void)
 
 void FlatFileReader::CancelRead(void)
 {
+	m_mappingBytesRead = -1;
+
 	// Will be done when m_aio_context context is destroyed
 	// Note: io_cancel exists but need the iocb structure as parameter
 	// int io_cancel(aio_context_t ctx_id, struct iocb *iocb,
@@ -84,10 +203,11 @@ void FlatFileReader::CancelRead(void)
 
 void FlatFileReader::Close(void)
 {
+	CloseMapping();
 
 	if (m_fd != -1) close(m_fd);
 
-	io_destroy(m_aio_context);
+	if (m_aio_context) io_destroy(m_aio_context);
 
 	m_fd = -1;
 	m_aio_context = 0;
@@ -77,6 +77,11 @@ void SysMtgsThread::OnStart()
 
 	m_CopyDataTally		= 0;
 
+	m_StatPosts			= 0;
+	m_StatWakes			= 0;
+	m_StatSpinHits		= 0;
+	m_StatSleeps		= 0;
+
 	_parent::OnStart();
 }
 
@@ -271,6 +276,65 @@ class RingBufferLock {
 	}
 };
 
+// True if the ring has data, or the EEcore waits on a ring or vsync signal.
+bool SysMtgsThread::HasPendingWork() const
+{
+	return m_ReadPos.load(std::memory_order_relaxed) != m_WritePos.load(std::memory_order_acquire)
+		|| m_SignalRingEnable.load(std::memory_order_acquire)
+		|| m_VsyncSignalListener.load(std::memory_order_acquire);
+}
+
+// Polls the ring for a little while before the MTGS goes to sleep.  High framerate games
+// tend to queue the next batch right after the previous one was drained, and catching it
+// here saves the EEcore a semaphore post and the MTGS a sleep/wake round trip.
+//
+// The ring locks are *not* held while spinning, so WaitGS callers aren't held up.  The
+// busy flag is, which stops SetEvent() from posting to a thread that's awake anyway.
+// Returns false if the MTGS should wait on m_sem_event.
+bool SysMtgsThread::SpinForWork()
+{
+	const int spins = EmuConfig.GS.MTGSSpinCount;
+	if (spins <= 0) return false;
+
+	m_RingBufferIsBusy.store(true, std::memory_order_relaxed);
+
+	for (int i = 0; i < spins; ++i)
+	{
+		if (HasPendingWork())
+		{
+			m_RingBufferIsBusy.store(false, std::memory_order_relaxed);
+			m_StatSpinHits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		SpinWait();
+	}
+
+	// Data written while the busy flag was still up didn't post anything, so look once
+	// more after dropping it.
+	m_RingBufferIsBusy.store(false, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (HasPendingWork())
+	{
+		m_StatSpinHits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	m_StatSleeps.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void SysMtgsThread::LogWaitStats()
+{
+	const u32 wakes = m_StatWakes.load(std::memory_order_relaxed);
+	const u32 hits  = m_StatSpinHits.load(std::memory_order_relaxed);
+	if (!wakes && !hits) return;
+
+	DevCon.WriteLn( Color_Gray, "(MTGS) Ring waits: %u posts, %u wakes, %u spin hits, %u sleeps (spin count %d)",
+		m_StatPosts.load(std::memory_order_relaxed), wakes, hits,
+		m_StatSleeps.load(std::memory_order_relaxed), EmuConfig.GS.MTGSSpinCount );
+}
+
 void SysMtgsThread::ExecuteTaskInThread()
 {
 	// Threading info: run in MTGS thread
@@ -289,7 +353,11 @@ void SysMtgsThread::ExecuteTaskInThread()
 		// is very optimized (only 1 instruction test in most cases), so no point in trying
 		// to avoid it.
 
-		m_sem_event.WaitWithoutYield();
+		if (!SpinForWork())
+		{
+			m_sem_event.WaitWithoutYield();
+			m_StatWakes.fetch_add(1, std::memory_order_relaxed);
+		}
 		StateCheckInThread();
 		busy.Acquire();
 
@@ -569,6 +637,7 @@ void SysMtgsThread::ClosePlugin()
 {
 	if( !m_PluginOpened ) return;
 	m_PluginOpened = false;
+	LogWaitStats();
 	GetCorePlugins().Close( PluginId_GS );
 }
 
@@ -640,7 +709,10 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 void SysMtgsThread::SetEvent()
 {
 	if(!m_RingBufferIsBusy.load(std::memory_order_relaxed))
+	{
 		m_sem_event.Post();
+		m_StatPosts.fetch_add(1, std::memory_order_relaxed);
+	}
 
 	m_CopyDataTally = 0;
 }
@@ -79,12 +79,18 @@ void VU_Thread::Reset()
 {
 	ScopedLock lock(mtxBusy);
 
+	LogStallStats();
+	ResetStats();
+
 	vuCycleIdx   = 0;
 	isBusy       = false;
 	m_ato_write_pos = 0;
 	m_write_pos     = 0;
+	m_cached_read_pos  = 0;
+	m_kick_pending     = 0;
 	m_ato_read_pos  = 0;
 	m_read_pos      = 0;
+	m_cached_write_pos = 0;
 	memzero(vif);
 	memzero(vifRegs);
 	for (size_t i = 0; i < 4; ++i)
@@ -98,12 +104,78 @@ void VU_Thread::ExecuteTaskInThread()
 	} PCSX2_PAGEFAULT_EXCEPT;
 }
 
+void VU_Thread::ResetStats()
+{
+	m_statStart      = GetCPUTicks();
+	m_statWaitTicks  = 0;
+	m_statRingTicks  = 0;
+	m_statWaits      = 0;
+	m_statRingStalls = 0;
+	m_statPosts      = 0;
+	m_statWakes      = 0;
+	m_statSpinHits   = 0;
+}
+
+void VU_Thread::LogStallStats()
+{
+	if (!m_statWaits && !m_statRingStalls) return;
+
+	const u64 freq = GetTickFrequency();
+	DevCon.WriteLn(Color_Gray, "(MTVU) EE stalled %u ms in WaitVU (%u waits) and %u ms on a full ring (%u times), out of %u ms",
+		(u32)((m_statWaitTicks * 1000) / freq), m_statWaits,
+		(u32)((m_statRingTicks * 1000) / freq), m_statRingStalls,
+		(u32)(((GetCPUTicks() - m_statStart) * 1000) / freq));
+	DevCon.WriteLn(Color_Gray, "(MTVU) %u posts, %u wakes, %u spin hits",
+		m_statPosts.load(std::memory_order_relaxed),
+		m_statWakes.load(std::memory_order_relaxed),
+		m_statSpinHits.load(std::memory_order_relaxed));
+}
+
+// Polls the ring for a little while after it was drained. The EE usually queues the
+// next unpack/MSCAL shortly after, and picking it up here saves both the semaphore post
+// on the EE side and the sleep/wake round trip on this one.
+//
+// isBusy stays raised while spinning so KickStart() doesn't post, but mtxBusy isn't
+// held, so a WaitVU() on an empty ring isn't held up. Returns false if the thread
+// should wait on semaEvent.
+bool VU_Thread::SpinForWork()
+{
+	isBusy.store(true, std::memory_order_relaxed);
+
+	for (int i = 0; i < SpinCount; ++i) {
+		if (m_ato_read_pos.load(std::memory_order_relaxed) != GetWritePos()) {
+			isBusy.store(false, std::memory_order_relaxed);
+			m_statSpinHits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		SpinWait();
+	}
+
+	// Packets committed while isBusy was still up didn't post anything
+	isBusy.store(false, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (m_ato_read_pos.load(std::memory_order_relaxed) != GetWritePos()) {
+		m_statSpinHits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
 void VU_Thread::ExecuteRingBuffer()
 {
 	for(;;) {
-		semaEvent.WaitWithoutYield();
+		if (!SpinForWork()) {
+			semaEvent.WaitWithoutYield();
+			m_statWakes.fetch_add(1, std::memory_order_relaxed);
+		}
 		ScopedLockBool lock(mtxBusy, isBusy);
-		while (m_ato_read_pos.load(std::memory_order_relaxed) != GetWritePos()) {
+		for(;;) {
+			// Only look at the EE's line once everything seen so far is processed
+			if (m_read_pos == m_cached_write_pos) {
+				m_cached_write_pos = GetWritePos();
+				if (m_read_pos == m_cached_write_pos) break;
+			}
 			u32 tag = Read();
 			switch (tag) {
 				case MTVU_VU_EXECUTE: {
@@ -161,10 +233,15 @@ void VU_Thread::ExecuteRingBuffer()
 
 
 // Should only be called by ReserveSpace()
+//
+// The read pos seen last time is checked first. It can only be behind the real one, and
+// the room it implies is always there, so the VU thread's line is only read when the EE
+// may actually have to wait.
 __ri void VU_Thread::WaitOnSize(s32 size)
 {
+	u64 stallStart = 0;
 	for(;;) {
-		s32 readPos  = GetReadPos();
+		s32 readPos  = m_cached_read_pos;
 		if (readPos <= m_write_pos) break; // MTVU is reading in back of write_pos
 		// FIXME greg: there is a bug somewhere in the queue pointer
 		// management. It creates a deadlock/corruption in SotC intro (before
@@ -172,6 +249,11 @@ __ri void VU_Thread::WaitOnSize(s32 size)
 		// trigger the bug.
 		// Note: a wait lock instead of a yield also helps to avoid the bug.
 		if (readPos >  m_write_pos + size + _4kb) break; // Enough free front space
+
+		m_cached_read_pos = GetReadPos();
+		if (m_cached_read_pos != readPos) continue;
+
+		if (!stallStart) stallStart = GetCPUTicks();
 		{ // Let MTVU run to free up buffer space
 			KickStart();
 			// Locking might trigger a full flush of the ring buffer. Yield
@@ -181,6 +263,11 @@ __ri void VU_Thread::WaitOnSize(s32 size)
 			std::this_thread::yield();
 		}
 	}
+
+	if (stallStart) {
+		m_statRingTicks += GetCPUTicks() - stallStart;
+		m_statRingStalls++;
+	}
 }
 
 // Makes sure theres enough room in the ring buffer
@@ -293,10 +380,15 @@ u32 VU_Thread::Get_vuCycles()
 			vuCycles[3].load(std::memory_order_acquire)) >> 2;
 }
 
+// A post which is still pending wakes the thread up just as well, so don't add another.
 void VU_Thread::KickStart(bool forceKick)
 {
-	if ((forceKick && !semaEvent.Count())
-	|| (!isBusy.load(std::memory_order_acquire) && GetReadPos() != m_ato_write_pos.load(std::memory_order_relaxed))) semaEvent.Post();
+	if (semaEvent.Count()) return;
+	if (forceKick
+	|| (!isBusy.load(std::memory_order_acquire) && GetReadPos() != m_ato_write_pos.load(std::memory_order_relaxed))) {
+		semaEvent.Post();
+		m_statPosts.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
 bool VU_Thread::IsDone()
@@ -304,17 +396,31 @@ bool VU_Thread::IsDone()
 	return GetReadPos() == GetWritePos();
 }
 
+// Most waits are on a short program or a few unpacks, which finish well within the
+// spin. Longer ones yield for a bit, and only then sleep until the VU thread drains
+// the ring (the mutex is held while it processes packets).
 void VU_Thread::WaitVU()
 {
 	MTVU_LOG("MTVU - WaitVU!");
-	for(;;) {
-		if (IsDone()) break;
-		//DevCon.WriteLn("WaitVU()");
-		pxAssert(THREAD_VU1);
+	if (IsDone()) return;
+	//DevCon.WriteLn("WaitVU()");
+	pxAssert(THREAD_VU1);
+
+	m_kick_pending = 0;
+	u64 waitStart = GetCPUTicks();
+	for (int i = 0; !IsDone(); ++i) {
 		KickStart();
-		std::this_thread::yield(); // Give a chance to the MTVU thread to actually start
-		ScopedLock lock(mtxBusy);
+		if (i < WaitSpinCount)
+			SpinWait();
+		else if (i < WaitSpinCount + WaitYieldCount)
+			std::this_thread::yield(); // Give a chance to the MTVU thread to actually start
+		else {
+			ScopedLock lock(mtxBusy);
+		}
 	}
+
+	m_statWaitTicks += GetCPUTicks() - waitStart;
+	m_statWaits++;
 }
 
 void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
@@ -327,6 +433,7 @@ void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
 	Write(vif_itop);
 	CommitWritePos();
 	gifUnit.TransferGSPacketData(GIF_TRANS_MTVU, NULL, 0);
+	m_kick_pending = 0;
 	KickStart();
 	u32 cycles = std::min(Get_vuCycles(), 3000u);
 	cpuRegs.cycle += cycles * EmuConfig.Speedhacks.VUCycleSteal;
@@ -336,14 +443,23 @@ void VU_Thread::VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32
 {
 	MTVU_LOG("MTVU - VifUnpack!");
 	u32 vif_copy_size = (uptr)&_vif.StructEnd - (uptr)&_vif.tag;
-	ReserveSpace(1 + size_u32(vif_copy_size) + size_u32(sizeof(VIFregistersMTVU)) + 1 + size_u32(size));
+	s32 packet_size   = 1 + size_u32(vif_copy_size) + size_u32(sizeof(VIFregistersMTVU)) + 1 + size_u32(size);
+	ReserveSpace(packet_size);
 	Write(MTVU_VIF_UNPACK);
 	Write(&_vif.tag, vif_copy_size);
 	WriteRegs(&_vifRegs);
 	Write(size);
 	Write(data, size);
 	CommitWritePos();
-	KickStart();
+
+	// Small unpacks are usually followed by more of them and an MSCAL, which kicks
+	// anyway. Everything that waits on the VU thread kicks first, so holding back
+	// the wakeup is safe.
+	m_kick_pending += packet_size;
+	if (m_kick_pending >= KickThreshold) {
+		m_kick_pending = 0;
+		KickStart();
+	}
 }
 
 void VU_Thread::WriteMicroMem(u32 vu_micro_addr, void* data, u32 size)
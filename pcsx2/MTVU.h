@@ -29,13 +29,39 @@
 class VU_Thread : public pxThread {
 	static const s32 buffer_size = (_1mb * 16) / sizeof(s32);
 
+	// VU thread: polls this many times for new packets before sleeping on semaEvent
+	static const int SpinCount      = 1000;
+	// EE thread: WaitVU() spins, then yields, then sleeps on mtxBusy
+	static const int WaitSpinCount  = 256;
+	static const int WaitYieldCount = 16;
+	// EE thread: unpacks only wake up the VU thread once this many u32's are queued
+	static const s32 KickThreshold  = _64kb / sizeof(u32);
+
 	u32 buffer[buffer_size];
 	// Note: keep atomic on separate cache line to avoid CPU conflict
 	__aligned(64) std::atomic<bool> isBusy;   // Is thread processing data?
 	__aligned(64) std::atomic<int> m_ato_read_pos; // Only modified by VU thread
 	__aligned(64) std::atomic<int> m_ato_write_pos;    // Only modified by EE thread
+
+	// Local state of each side gets its own line too, so that the EE writing a packet
+	// doesn't evict what the VU thread is working with (and vice versa).
 	__aligned(64) int  m_read_pos; // temporary read pos (local to the VU thread)
-	int  m_write_pos; // temporary write pos (local to the EE thread)
+	int  m_cached_write_pos; // last write pos seen by the VU thread
+	std::atomic<u32> m_statWakes; // VU thread woken up through semaEvent
+	std::atomic<u32> m_statSpinHits; // new packets found while spinning
+
+	__aligned(64) int  m_write_pos; // temporary write pos (local to the EE thread)
+	int  m_cached_read_pos; // last read pos seen by the EE thread
+	s32  m_kick_pending; // u32's written since the last kick
+	std::atomic<u32> m_statPosts; // semaEvent posts (EE thread and MTGS)
+
+	// EE stall statistics (EE thread only), reported on Reset()
+	u64  m_statStart;       // when the counters were last cleared
+	u64  m_statWaitTicks;   // time spent in WaitVU()
+	u64  m_statRingTicks;   // time spent waiting for ring space
+	u32  m_statWaits;
+	u32  m_statRingStalls;
+
 	Mutex     mtxBusy;
 	Semaphore semaEvent;
 	BaseVUmicroCPU*& vuCPU;
@@ -59,9 +85,16 @@ public:
 	// Used for assertions...
 	bool IsDone();
 
+	// Whether the VU thread is working through packets (for the block profiler, which
+	// samples it from another thread).
+	bool IsBusy() const { return isBusy.load(std::memory_order_relaxed); }
+
 	// Waits till MTVU is done processing
 	void WaitVU();
 
+	// Writes the EE stall counters to the dev console
+	void LogStallStats();
+
 	void ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop);
 
 	void VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32 size);
@@ -81,9 +114,11 @@ protected:
 
 private:
 	void ExecuteRingBuffer();
+	bool SpinForWork();
 
 	void WaitOnSize(s32 size);
 	void ReserveSpace(s32 size);
+	void ResetStats();
 
 	s32 GetReadPos();
 	s32 GetWritePos();
@@ -84,11 +84,14 @@ Pcsx2Config::RecompilerOptions::RecompilerOptions()
 
 	//StackFrameChecks	= false;
 	//PreBlockCheckEE	= false;
+	//ShadowCheckEE	= false;
 
 	// All recs are enabled by default.
 
 	EnableEE	= true;
 	EnableEECache = false;
+	EnableEETiering = false;
+	EnableFastmem = true;
 	EnableIOP	= true;
 	EnableVU0	= true;
 	EnableVU1	= true;
@@ -96,6 +99,8 @@ Pcsx2Config::RecompilerOptions::RecompilerOptions()
 	UseMicroVU0	= true;
 	UseMicroVU1	= true;
 
+	EnableVUProgCache = true;
+
 	// vu and fpu clamping default to standard overflow.
 	vuOverflow	= true;
 	//vuExtraOverflow = false;
@@ -147,11 +152,14 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( EnableEE );
 	IniBitBool( EnableIOP );
 	IniBitBool( EnableEECache );
+	IniBitBool( EnableEETiering );
+	IniBitBool( EnableFastmem );
 	IniBitBool( EnableVU0 );
 	IniBitBool( EnableVU1 );
 
 	IniBitBool( UseMicroVU0 );
 	IniBitBool( UseMicroVU1 );
+	IniBitBool( EnableVUProgCache );
 
 	IniBitBool( vuOverflow );
 	IniBitBool( vuExtraOverflow );
@@ -165,6 +173,7 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( StackFrameChecks );
 	IniBitBool( PreBlockCheckEE );
 	IniBitBool( PreBlockCheckIOP );
+	IniBitBool( ShadowCheckEE );
 }
 
 Pcsx2Config::CpuOptions::CpuOptions()
@@ -205,6 +214,7 @@ Pcsx2Config::GSOptions::GSOptions()
 
 	SynchronousMTGS			= false;
 	VsyncQueueSize			= 2;
+	MTGSSpinCount			= 1000;
 
 	FramesToDraw			= 2;
 	FramesToSkip			= 2;
@@ -220,6 +230,7 @@ void Pcsx2Config::GSOptions::LoadSave( IniInterface& ini )
 
 	IniEntry( SynchronousMTGS );
 	IniEntry( VsyncQueueSize );
+	IniEntry( MTGSSpinCount );
 
 	IniEntry( FrameLimitEnable );
 	IniEntry( FrameSkipEnable );
@@ -421,6 +432,9 @@ Pcsx2Config::Pcsx2Config()
 	McdFolderAutoManage = true;
 	EnablePatches = true;
 	BackupSavestate = true;
+	SavestateCompression = SavestateCompressionMethod::Zlib;
+	RewindInterval = 30;
+	RewindBufferSize = 256;
 }
 
 void Pcsx2Config::LoadSave( IniInterface& ini )
@@ -430,6 +444,7 @@ void Pcsx2Config::LoadSave( IniInterface& ini )
 	IniBitBool( CdvdVerboseReads );
 	IniBitBool( CdvdDumpBlocks );
 	IniBitBool( CdvdShareWrite );
+	IniBitBool( CdvdMemoryMap );
 	IniBitBool( EnablePatches );
 	IniBitBool( EnableCheats );
 	IniBitBool( EnableWideScreenPatches );
@@ -437,11 +452,16 @@ void Pcsx2Config::LoadSave( IniInterface& ini )
 	IniBitBool( HostFs );
 
 	IniBitBool( BackupSavestate );
+	IniBitBool( EnableRewind );
 	IniBitBool( McdEnableEjection );
 	IniBitBool( McdFolderAutoManage );
 	IniBitBool( MultitapPort0_Enabled );
 	IniBitBool( MultitapPort1_Enabled );
 
+	ini.EnumEntry( L"SavestateCompression", SavestateCompression, NULL, SavestateCompressionMethod::Zlib );
+	IniEntry( RewindInterval );
+	IniEntry( RewindBufferSize );
+
 	// Process various sub-components:
 
 	Speedhacks		.LoadSave( ini );
@@ -268,6 +268,15 @@ void intSetBranch();
 // parts of the Recs (namely COP0's branch codes and stuff).
 void __fastcall intDoBranch(u32 target);
 
+// Runs the instructions from cpuRegs.pc through the interpreter until the pc leaves the
+// sequential flow (taken branch, exception) or reaches endpc.  Used by the EE rec for
+// blocks which aren't worth recompiling yet.
+void intExecuteBlock(u32 endpc);
+
+// Same as intExecuteBlock, but taken branches don't run event tests: the block leaves no
+// trace other than its register and memory writes.  Used by the EE rec's shadow checks.
+void intShadowBlock(u32 endpc);
+
 // modules loaded at hardcoded addresses by the kernel
 const u32 EEKERNEL_START	= 0;
 const u32 EENULL_START		= 0x81FC0;
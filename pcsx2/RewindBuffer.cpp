@@ -0,0 +1,234 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "RewindBuffer.h"
+#include "System/SysThreads.h"
+#include "GS.h"
+#include "MTVU.h"
+
+#include "Utilities/SafeArray.inl"
+
+using namespace Threading;
+
+// Granularity of the snapshot deltas.
+static const uint PageSize = 0x1000;
+
+// Compares a full page 64 bytes at a time, without branching until the end of the page.
+// Most pages of consecutive snapshots are identical, so there's rarely an early out to
+// be had anyway.
+static __fi bool PageDiffers( const u8* a, const u8* b, uint size )
+{
+	__m128i acc = _mm_setzero_si128();
+	for( uint i=0; i<size; i+=64 )
+	{
+		__m128i d0 = _mm_xor_si128( _mm_loadu_si128((const __m128i*)(a+i)),    _mm_loadu_si128((const __m128i*)(b+i)) );
+		__m128i d1 = _mm_xor_si128( _mm_loadu_si128((const __m128i*)(a+i+16)), _mm_loadu_si128((const __m128i*)(b+i+16)) );
+		__m128i d2 = _mm_xor_si128( _mm_loadu_si128((const __m128i*)(a+i+32)), _mm_loadu_si128((const __m128i*)(b+i+32)) );
+		__m128i d3 = _mm_xor_si128( _mm_loadu_si128((const __m128i*)(a+i+48)), _mm_loadu_si128((const __m128i*)(b+i+48)) );
+		acc = _mm_or_si128( acc, _mm_or_si128( _mm_or_si128(d0, d1), _mm_or_si128(d2, d3) ) );
+	}
+	return _mm_movemask_epi8( _mm_cmpeq_epi8(acc, _mm_setzero_si128()) ) != 0xffff;
+}
+
+// --------------------------------------------------------------------------------------
+//  RewindBuffer  (implementations)
+// --------------------------------------------------------------------------------------
+RewindBuffer::RewindBuffer()
+{
+	m_currentSize	= 0;
+	m_deltaBytes	= 0;
+	m_frames		= 0;
+	m_snapshotTicks	= 0;
+	m_snapshots		= 0;
+	m_busySnapshots	= 0;
+	m_warnedMTVU	= false;
+}
+
+// Freezing the VM waits for the VU1 and GS threads to finish everything they were sent.
+static bool ThreadsIdle()
+{
+	return (!THREAD_VU1 || vu1Thread.IsDone()) && GetMTGS().IsRingEmpty();
+}
+
+void RewindBuffer::Clear()
+{
+	ScopedLock lock( m_lock );
+
+	m_current		= nullptr;
+	m_scratch		= nullptr;
+	m_currentSize	= 0;
+	m_deltas.clear();
+	m_deltaBytes	= 0;
+	m_frames		= 0;
+	m_snapshots		= 0;
+	m_busySnapshots	= 0;
+	m_warnedMTVU	= false;
+}
+
+void RewindBuffer::Vsync()
+{
+	if( !EmuConfig.EnableRewind )
+	{
+		// Give the memory back as soon as the option is turned off.
+		if( m_current ) Clear();
+		return;
+	}
+
+	const uint interval = std::max( 1u, EmuConfig.RewindInterval );
+	if( ++m_frames < interval ) return;
+
+	// Rather than stalling on the other threads, put the snapshot off to a vsync where they
+	// are done already, for up to one more interval.
+	const bool idle = ThreadsIdle();
+	if( !idle && m_frames < interval * 2 ) return;
+	m_frames = 0;
+
+	if( THREAD_VU1 && !m_warnedMTVU )
+	{
+		Console.Warning( "(Rewind) MTVU speedhack is enabled, rewinding may not be stable" );
+		m_warnedMTVU = true;
+	}
+
+	TakeSnapshot();
+
+	m_snapshots++;
+	if( !idle ) m_busySnapshots++;
+}
+
+void RewindBuffer::TakeSnapshot()
+{
+	ScopedLock lock( m_lock );
+
+	u64 startTicks = GetCPUTicks();
+
+	if( !m_scratch ) m_scratch = std::unique_ptr<VmStateBuffer>(new VmStateBuffer( L"Rewind Snapshot" ));
+
+	memSavingState saveme( m_scratch.get() );
+	saveme.SetQuiet();	// Warned about MTVU once in Vsync
+	saveme.FreezeAll();
+	const uint newSize = saveme.GetCurrentPos();
+
+	if( m_currentSize )
+	{
+		// Record what the previous snapshot looked like wherever the new one differs.
+		// Pages past the end of the new snapshot are always kept, as is the partial
+		// page at the end of either.
+		Delta delta;
+		delta.size = m_currentSize;
+
+		const u8* prev = m_current->GetPtr();
+		const u8* next = m_scratch->GetPtr();
+		const uint pageCount = (m_currentSize + PageSize - 1) / PageSize;
+
+		for( uint page=0; page<pageCount; ++page )
+		{
+			const uint offset = page * PageSize;
+			const uint size = std::min( PageSize, m_currentSize - offset );
+
+			bool differs;
+			if( offset + size > newSize )
+				differs = true;
+			else if( size == PageSize )
+				differs = PageDiffers( prev + offset, next + offset, PageSize );
+			else
+				differs = memcmp( prev + offset, next + offset, size ) != 0;
+
+			if( !differs ) continue;
+
+			delta.pages.push_back( page );
+			delta.data.insert( delta.data.end(), prev + offset, prev + offset + size );
+		}
+
+		m_deltaBytes += delta.data.size() + delta.pages.size() * sizeof(u32);
+		m_deltas.push_back( std::move(delta) );
+	}
+
+	std::swap( m_current, m_scratch );
+	m_currentSize = newSize;
+
+	TrimDeltas();
+
+	m_snapshotTicks = GetCPUTicks() - startTicks;
+}
+
+// Drops the oldest deltas until the buffer fits its budget.  The two full snapshots are
+// always kept, so the budget only applies to the history.
+void RewindBuffer::TrimDeltas()
+{
+	const size_t budget = (size_t)EmuConfig.RewindBufferSize * _1mb;
+
+	while( m_deltaBytes > budget && !m_deltas.empty() )
+	{
+		const Delta& oldest = m_deltas.front();
+		m_deltaBytes -= oldest.data.size() + oldest.pages.size() * sizeof(u32);
+		m_deltas.pop_front();
+	}
+}
+
+// Turns m_current back into the snapshot which preceded it.
+void RewindBuffer::ApplyDelta( const Delta& delta )
+{
+	m_current->MakeRoomFor( delta.size );
+
+	const u8* src = delta.data.data();
+	for( u32 page : delta.pages )
+	{
+		const uint offset = page * PageSize;
+		const uint size = std::min( PageSize, delta.size - offset );
+
+		memcpy( m_current->GetPtr( offset ), src, size );
+		src += size;
+	}
+
+	m_currentSize = delta.size;
+}
+
+bool RewindBuffer::Rewind()
+{
+	if( !pxAssertDev( GetCoreThread().IsPaused(), "CoreThread is not paused; cannot rewind." ) ) return false;
+
+	ScopedLock lock( m_lock );
+
+	if( !m_currentSize ) return false;
+
+	GetCoreThread().UploadStateCopy( *m_current );
+
+	DevCon.WriteLn( Color_Gray, "(Rewind) Restored snapshot, %u left (%u KB of history, last snapshot took %u us, %u of %u waited on VU1/GS).",
+		(u32)m_deltas.size(), (u32)(m_deltaBytes / 1024), (u32)((m_snapshotTicks * 1000000) / GetTickFrequency()),
+		m_busySnapshots, m_snapshots );
+
+	if( m_deltas.empty() )
+	{
+		m_currentSize = 0;
+	}
+	else
+	{
+		const Delta& delta = m_deltas.back();
+		ApplyDelta( delta );
+		m_deltaBytes -= delta.data.size() + delta.pages.size() * sizeof(u32);
+		m_deltas.pop_back();
+	}
+
+	// Start counting towards the next snapshot from the restored point.
+	m_frames = 0;
+	return true;
+}
+
+RewindBuffer& GetRewindBuffer()
+{
+	static RewindBuffer buffer;
+	return buffer;
+}
@@ -0,0 +1,90 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SaveState.h"
+#include "Utilities/Threading.h"
+#include <deque>
+#include <memory>
+
+// --------------------------------------------------------------------------------------
+//  RewindBuffer
+// --------------------------------------------------------------------------------------
+// Keeps the recent history of the virtual machine in memory, so that emulation can be
+// stepped back a few seconds at a time.
+//
+// Every EmuConfig.RewindInterval frames the whole VM is frozen with a memSavingState.  Only
+// the most recent snapshot is kept in full; for each older one we keep the pages which
+// differ from the snapshot that followed it (a backward delta).  Rewinding uploads the
+// most recent snapshot, and then rebuilds the one before it by copying its pages back.
+// The oldest deltas are dropped once they don't fit EmuConfig.RewindBufferSize anymore.
+//
+// Snapshots are taken by the core thread at vsync, rewinding must be done with the core
+// thread paused.  Freezing the VM waits for the VU1 (MTVU) and GS threads to drain their
+// rings, so a due snapshot is put off until a vsync where both are already idle, for up
+// to one more interval.  The time taken by the last snapshot and the number of them which
+// had to wait anyway are logged on rewind.
+//
+class RewindBuffer
+{
+	DeclareNoncopyableObject( RewindBuffer );
+
+protected:
+	struct Delta
+	{
+		uint				size;		// size of the snapshot this delta restores
+		std::vector<u32>	pages;		// pages which differ from the following snapshot
+		std::vector<u8>		data;		// and their contents in this one
+	};
+
+	Threading::Mutex				m_lock;
+
+	std::unique_ptr<VmStateBuffer>	m_current;		// most recent snapshot
+	std::unique_ptr<VmStateBuffer>	m_scratch;		// the snapshot being taken
+	uint							m_currentSize;	// bytes used in m_current, 0 if none
+
+	std::deque<Delta>				m_deltas;		// oldest first
+	size_t							m_deltaBytes;
+
+	uint							m_frames;		// frames since the last snapshot
+	u64								m_snapshotTicks;	// cost of the last snapshot
+	uint							m_snapshots;		// taken since the last Clear()
+	uint							m_busySnapshots;	// of which waited on the VU1/GS threads
+	bool							m_warnedMTVU;
+
+public:
+	RewindBuffer();
+	virtual ~RewindBuffer() = default;
+
+	// Called by the core thread once per frame.  Takes a snapshot when one is due.
+	void Vsync();
+
+	// Restores the most recent snapshot into the VM, and makes the one before it the next
+	// to be restored.  The core thread must be paused.  Returns false if there's nothing to
+	// rewind to.
+	bool Rewind();
+
+	void Clear();
+
+	uint GetSnapshotCount() const { return m_currentSize ? m_deltas.size() + 1 : 0; }
+
+protected:
+	void TakeSnapshot();
+	void ApplyDelta( const Delta& delta );
+	void TrimDeltas();
+};
+
+extern RewindBuffer& GetRewindBuffer();
@@ -79,6 +79,7 @@ void SaveStateBase::Init( SafeArray<u8>* memblock )
 	m_version	= g_SaveVersion;
 	m_idx		= 0;
 	m_DidBios	= false;
+	m_quiet		= false;
 }
 
 void SaveStateBase::PrepBlock( int size )
@@ -178,7 +179,7 @@ SaveStateBase& SaveStateBase::FreezeInternals()
 {
 	vu1Thread.WaitVU(); // Finish VU1 just in-case...
 	// Print this until the MTVU problem in gifPathFreeze is taken care of (rama)
-	if (THREAD_VU1) Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
+	if (THREAD_VU1 && !m_quiet) Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
 	
 	if (IsLoading()) PreLoadPrep();
 
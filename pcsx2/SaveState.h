@@ -24,7 +24,7 @@
 //  the lower 16 bit value.  IF the change is breaking of all compatibility with old
 //  states, increment the upper 16 bit value, and clear the lower 16 bits to 0.
 
-static const u32 g_SaveVersion = (0x9A0D << 16) | 0x0000;
+static const u32 g_SaveVersion = (0x9A0D << 16) | 0x0001;
 
 // this function is meant to be used in the place of GSfreeze, and provides a safe layer
 // between the GS saving function and the MTGS's needs. :)
@@ -106,6 +106,7 @@ protected:
 	int m_idx;			// current read/write index of the allocation
 
 	bool m_DidBios;
+	bool m_quiet;		// don't warn about MTVU (for snapshots taken many times over)
 
 public:
 	SaveStateBase( VmStateBuffer& memblock );
@@ -114,6 +115,8 @@ public:
 
 	static wxString GetFilename( int slot );
 
+	void SetQuiet( bool quiet=true ) { m_quiet = quiet; }
+
 	// Gets the version of savestate that this object is acting on.
 	// The version refers to the low 16 bits only (high 16 bits classifies Pcsx2 build types)
 	u32 GetVersion() const
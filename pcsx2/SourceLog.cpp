@@ -116,6 +116,8 @@ TLD_deci2 = {
 	pxDt("Shows DECI2 debugging logs (EE processor)")
 };
 
+FnType_VMConsoleCapture* VMConsoleCapture = NULL;
+
 SysConsoleLogPack::SysConsoleLogPack()
 	: ELF		(&TLD_ELF, Color_Gray)
 	, eeRecPerf	(&TLD_eeRecPerf, Color_Gray)
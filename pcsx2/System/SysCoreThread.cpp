@@ -22,6 +22,8 @@
 #include "GS.h"
 #include "Elfheader.h"
 #include "Patch.h"
+#include "RewindBuffer.h"
+#include "BlockProfiler.h"
 #include "SysThreads.h"
 #include "MTVU.h"
 
@@ -178,6 +180,9 @@ void SysCoreThread::_reset_stuff_as_needed()
 
 	GetVmMemory().CommitAll();
 
+	if( m_resetProfilers )
+		GetBlockProfiler().ApplySettings();
+
 	if( m_resetVirtualMachine || m_resetRecompilers || m_resetProfilers )
 	{
 		SysClearExecutionCache();
@@ -191,6 +196,7 @@ void SysCoreThread::_reset_stuff_as_needed()
 	if( m_resetVirtualMachine )
 	{
 		DoCpuReset();
+		GetRewindBuffer().Clear();
 
 		m_resetVirtualMachine	= false;
 		m_resetVsyncTimers		= false;
@@ -225,6 +231,7 @@ void SysCoreThread::DoCpuReset()
 void SysCoreThread::VsyncInThread()
 {
 	ApplyLoadedPatches(PPT_CONTINUOUSLY);
+	GetRewindBuffer().Vsync();
 }
 
 void SysCoreThread::GameStartingInThread()
@@ -287,6 +294,9 @@ void SysCoreThread::OnCleanupInThread()
 
 	m_hasActiveMachine		= false;
 	m_resetVirtualMachine	= true;
+	m_resetProfilers		= true;
+
+	GetBlockProfiler().Stop();
 
 	// FIXME: temporary workaround for deadlock on exit, which actually should be a crash
 	vu1Thread.WaitVU();
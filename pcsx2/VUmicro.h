@@ -313,6 +313,9 @@ extern void __fastcall vu1ExecMicro(u32 addr);
 extern void vu1Exec(VURegs* VU);
 extern void iDumpVU1Registers();
 
+// microVU program cache (see x86/microVU_ProgCache.h)
+extern void mVUsetProgCacheFolder(const wxDirName& folder);
+
 #ifdef VUM_LOG
 
 #define IdebugUPPER(VU) \
@@ -0,0 +1,164 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "ThreadedZipTools.h"
+#include "CDVD/DecompressionPool.h"
+#include <functional>
+#include <zlib.h>
+
+// --------------------------------------------------------------------------------------
+//  BlockCodecJob
+// --------------------------------------------------------------------------------------
+// Helper for ForEachBlock, run by the DecompressionPool workers the CDVD readers use, so
+// that no threads are started per entry.
+//
+class BlockCodecJob : public DecompressionJob
+{
+protected:
+	const std::function<void()>& m_task;
+
+public:
+	BlockCodecJob( const std::function<void()>& task )
+		: m_task( task )
+	{
+	}
+
+protected:
+	void Execute()
+	{
+		m_task();
+	}
+};
+
+// Runs func for every block index, on the calling thread and on the pool.  Blocks are
+// handed out one at a time so slow ones balance out.
+static void ForEachBlock( uint count, const std::function<void(uint)>& func )
+{
+	if( !count ) return;
+
+	std::atomic<uint> next( 0 );
+	std::function<void()> task = [&]()
+	{
+		for( uint i; (i = next++) < count; )
+			func( i );
+	};
+
+	// Waiting on a job no worker picked up yet just runs it here, where it finds nothing
+	// left to do.
+	std::vector<std::unique_ptr<BlockCodecJob>> jobs;
+	uint helpers = std::min( count, std::max( 1u, (uint)x86caps.LogicalCores ) ) - 1;
+	for( uint i=0; i<helpers; ++i )
+	{
+		jobs.push_back( std::unique_ptr<BlockCodecJob>( new BlockCodecJob( task ) ) );
+		DecompressionPool::Get().Submit( *jobs.back() );
+	}
+
+	task();
+
+	for( auto& job : jobs )
+		DecompressionPool::Get().Wait( *job );
+}
+
+// --------------------------------------------------------------------------------------
+//  BlockCompressor
+// --------------------------------------------------------------------------------------
+
+void BlockCompressor::Compress( std::vector<u8>& dest, const u8* src, uint size, int level )
+{
+	const uint blockSize = BlockSize;
+	const uint blockCount = (size + blockSize - 1) / blockSize;
+	const uint dataStart = sizeof(Header) + blockCount * sizeof(u32);
+	const uint slotSize = compressBound( blockSize );
+
+	// Every block gets a worst case sized slot, and is moved down next to the previous
+	// one once everything is compressed.
+	dest.resize( dataStart + (size_t)blockCount * slotSize );
+
+	Header& header = (Header&)dest[0];
+	header.magic = Magic;
+	header.rawSize = size;
+	header.blockSize = blockSize;
+	header.blockCount = blockCount;
+
+	u32* packedSizes = (u32*)&dest[sizeof(Header)];
+	u8* slots = &dest[dataStart];
+
+	ForEachBlock( blockCount, [&]( uint i )
+	{
+		uint rawSize = std::min( blockSize, size - i * blockSize );
+		uLongf packedSize = slotSize;
+
+		// Can't fail, the slot is big enough for any input.
+		compress2( slots + (size_t)i * slotSize, &packedSize, src + (size_t)i * blockSize, rawSize, level );
+		packedSizes[i] = packedSize;
+	});
+
+	size_t pos = dataStart;
+	for( uint i=0; i<blockCount; ++i )
+	{
+		memmove( &dest[pos], slots + (size_t)i * slotSize, packedSizes[i] );
+		pos += packedSizes[i];
+	}
+	dest.resize( pos );
+}
+
+s64 BlockCompressor::GetRawSize( const u8* src, uint size )
+{
+	if( size < sizeof(Header) ) return -1;
+
+	const Header& header = (const Header&)*src;
+	if( header.magic != Magic ) return -1;
+
+	return header.rawSize;
+}
+
+bool BlockCompressor::Decompress( u8* dest, uint destSize, const u8* src, uint size )
+{
+	if( GetRawSize( src, size ) != destSize ) return false;
+
+	const Header& header = (const Header&)*src;
+	if( !header.blockSize || header.blockCount != (destSize + header.blockSize - 1) / header.blockSize )
+		return false;
+
+	const uint blockCount = header.blockCount;
+	if( !blockCount && destSize ) return false;
+	if( (u64)sizeof(Header) + (u64)blockCount * sizeof(u32) > size ) return false;
+
+	// Find where each block starts, and make sure they're all within the entry.
+	const u32* packedSizes = (const u32*)(src + sizeof(Header));
+	std::vector<uint> offsets( blockCount );
+	u64 pos = sizeof(Header) + blockCount * sizeof(u32);
+	for( uint i=0; i<blockCount; ++i )
+	{
+		offsets[i] = (uint)pos;
+		pos += packedSizes[i];
+		if( pos > size ) return false;
+	}
+
+	std::atomic<bool> failed( false );
+	ForEachBlock( blockCount, [&]( uint i )
+	{
+		uint rawSize = std::min( header.blockSize, destSize - i * header.blockSize );
+		uLongf unpackedSize = rawSize;
+
+		int res = uncompress( dest + (size_t)i * header.blockSize, &unpackedSize, src + offsets[i], packedSizes[i] );
+		if( res != Z_OK || unpackedSize != rawSize )
+			failed = true;
+	});
+
+	return !failed;
+}
@@ -71,6 +71,39 @@ public:
 
 typedef SafeArray< u8 > ArchiveDataBuffer;
 
+// --------------------------------------------------------------------------------------
+//  BlockCompressor
+// --------------------------------------------------------------------------------------
+// Packs archive entries as independent zlib blocks, which (unlike a single deflate stream)
+// can be compressed and decompressed on all cores at once.  The packed entry is meant to
+// be stored uncompressed in the zip.
+//
+// Layout: Header, then the packed size of each block (u32), then the blocks themselves.
+//
+class BlockCompressor
+{
+public:
+	static const u32 Magic = 0x5a425850;	// "PXBZ"
+	static const uint BlockSize = 0x40000;
+
+	struct Header
+	{
+		u32 magic;
+		u32 rawSize;
+		u32 blockSize;
+		u32 blockCount;
+	};
+
+	// level is a zlib level (Z_BEST_SPEED .. Z_BEST_COMPRESSION, or Z_DEFAULT_COMPRESSION).
+	static void Compress( std::vector<u8>& dest, const u8* src, uint size, int level );
+
+	// Returns false if src is not a valid block stream, or doesn't unpack to destSize bytes.
+	static bool Decompress( u8* dest, uint destSize, const u8* src, uint size );
+
+	// Returns the unpacked size, or -1 if src doesn't start with a block stream header.
+	static s64 GetRawSize( const u8* src, uint size );
+};
+
 // --------------------------------------------------------------------------------------
 //  ArchiveEntryList
 // --------------------------------------------------------------------------------------
@@ -151,6 +184,8 @@ protected:
 	pxOutputStream*					m_gzfp;
 	ArchiveEntryList*				m_src_list;
 	bool							m_PendingSaveFlag;
+	bool							m_BlockCompress;
+	int								m_BlockLevel;
 	
 	wxString						m_final_filename;
 
@@ -181,6 +216,15 @@ public:
 		return *this;
 	}
 
+	// Entries of at least one block are packed by the BlockCompressor at the given zlib
+	// level, instead of being deflated by the zip stream.
+	BaseCompressThread& SetBlockCompression( int level )
+	{
+		m_BlockCompress = true;
+		m_BlockLevel = level;
+		return *this;
+	}
+
 	BaseCompressThread& SetFinishedPath( const wxString& path )
 	{
 		m_final_filename = path;
@@ -201,9 +245,12 @@ protected:
 		m_gzfp				= NULL;
 		m_src_list			= NULL;
 		m_PendingSaveFlag	= false;
+		m_BlockCompress		= false;
+		m_BlockLevel		= 0;
 	}
 
 	void SetPendingSave();
+	void WriteBlockEntry( const ArchiveEntry& entry );
 	void ExecuteTaskInThread();
 	void OnCleanupInThread();
 };
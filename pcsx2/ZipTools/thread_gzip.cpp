@@ -41,6 +41,21 @@ void BaseCompressThread::SetPendingSave()
 	m_PendingSaveFlag = true;
 }
 
+void BaseCompressThread::WriteBlockEntry( const ArchiveEntry& entry )
+{
+	std::vector<u8> packed;
+	BlockCompressor::Compress( packed, m_src_list->GetPtr( entry.GetDataIndex() ), entry.GetDataSize(), m_BlockLevel );
+
+	// Already compressed, so the zip only has to store it.
+	wxZipEntry* zentry = new wxZipEntry( entry.GetFilename() );
+	zentry->SetMethod( wxZIP_METHOD_STORE );
+
+	wxArchiveOutputStream& woot = *(wxArchiveOutputStream*)m_gzfp->GetWxStreamBase();
+	woot.PutNextEntry( zentry );
+	m_gzfp->Write( packed.data(), packed.size() );
+	woot.CloseEntry();
+}
+
 void BaseCompressThread::ExecuteTaskInThread()
 {
 	// TODO : Add an API to PersistentThread for this! :)  --air
@@ -55,12 +70,21 @@ void BaseCompressThread::ExecuteTaskInThread()
 	
 	Yield( 3 );
 
+	u64 startTicks = GetCPUTicks();
+
 	uint listlen = m_src_list->GetLength();
 	for( uint i=0; i<listlen; ++i )
 	{
 		const ArchiveEntry& entry = (*m_src_list)[i];
 		if (!entry.GetDataSize()) continue;
 
+		if( m_BlockCompress && entry.GetDataSize() >= BlockCompressor::BlockSize )
+		{
+			WriteBlockEntry( entry );
+			Yield( 2 );
+			continue;
+		}
+
 		wxArchiveOutputStream& woot = *(wxArchiveOutputStream*)m_gzfp->GetWxStreamBase();
 		woot.PutNextEntry( entry.GetFilename() );
 
@@ -84,7 +108,8 @@ void BaseCompressThread::ExecuteTaskInThread()
 		.SetDiagMsg(L"Failed to move or copy the temporary archive to the destination filename.")
 		.SetUserMsg(_("The savestate was not properly saved. The temporary file was created successfully but could not be moved to its final resting place."));
 
-	Console.WriteLn( "(gzipThread) Data saved to disk without error." );
+	Console.WriteLn( "(gzipThread) Data saved to disk without error (%u ms).",
+		(u32)(((GetCPUTicks() - startTicks) * 1000) / GetTickFrequency()) );
 }
 
 void BaseCompressThread::OnCleanupInThread()
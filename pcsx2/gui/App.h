@@ -25,6 +25,7 @@
 
 #include "AppCommon.h"
 #include "AppCoreThread.h"
+#include "AutoTest.h"
 #include "RecentIsoList.h"
 
 class DisassemblyDialog;
@@ -297,6 +298,9 @@ public:
 	bool			SysAutoRunElf;
 	bool			SysAutoRunIrx;
 
+	// Runs the ps2autotests suite instead (headless), see AutoTest.h
+	AutoTestOptions	AutoTest;
+
 	StartupOptions()
 	{
 		ForceWizard				= false;
@@ -578,6 +582,7 @@ public:
 	// --------------------------------------------------------------------------
 	wxAppTraits* CreateTraits();
 	bool OnInit();
+	int  OnRun();
 	int  OnExit();
 	void CleanUp();
 
@@ -32,6 +32,7 @@
 #include "Patch.h"
 #include "R5900Exceptions.h"
 #include "Sio.h"
+#include "VUmicro.h"
 
 __aligned16 SysMtgsThread mtgsThread;
 __aligned16 AppCoreThread CoreThread;
@@ -415,6 +416,8 @@ static void _ApplySettings( const Pcsx2Config& src, Pcsx2Config& fixup )
 		}
 	}
 
+	mVUsetProgCacheFolder(PathDefs::GetDocuments() + wxDirName(L"cache"));
+
 	if (!gameMemCardFilter.IsEmpty())
 		sioSetGameSerial(gameMemCardFilter);
 	else
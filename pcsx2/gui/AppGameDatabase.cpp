@@ -150,6 +150,11 @@ void DBLoaderHelper::ReadGames()
 //  AppGameDatabase  (implementations)
 // --------------------------------------------------------------------------------------
 
+static wxDirName GetIndexFolder()
+{
+	return PathDefs::GetDocuments() + wxDirName(L"cache");
+}
+
 AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxString& key )
 {
 	wxString file(_file);
@@ -176,6 +181,24 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 		return *this;
 	}
 
+	// The compiled index is only used while it matches the database; whenever the .dbf is
+	// edited (or updated by a new release) it's parsed again, and the index recompiled.
+	const wxFileName srcName( file );
+	const u64 srcSize = srcName.GetSize().GetValue();
+	const s64 srcTime = srcName.GetModificationTime().GetValue().GetValue();
+	const wxString indexFile( (GetIndexFolder() + wxFileName(L"GameIndex.bin")).GetFullPath() );
+
+	u64 qpc_Start = GetCPUTicks();
+	if (m_index.Load(indexFile, srcSize, srcTime))
+	{
+		header = m_index.GetHeader();
+		u64 qpc_end = GetCPUTicks();
+
+		Console.WriteLn( "(GameDB) %u games on record (index loaded in %ums)",
+			m_index.GetGameCount(), (u32)(((qpc_end-qpc_Start)*1000) / GetTickFrequency()) );
+		return *this;
+	}
+
 	wxFFileInputStream reader( file );
 
 	if (!reader.IsOk())
@@ -186,7 +209,6 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 
 	DBLoaderHelper loader( reader, *this );
 
-	u64 qpc_Start = GetCPUTicks();
 	header = loader.ReadHeader();
 	loader.ReadGames();
 	u64 qpc_end = GetCPUTicks();
@@ -194,12 +216,21 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 	Console.WriteLn( "(GameDB) %d games on record (loaded in %ums)",
 		gHash.size(), (u32)(((qpc_end-qpc_Start)*1000) / GetTickFrequency()) );
 
+	// The loader reads up to the end of the file: EOF is where a good read stops.
+	const wxStreamError readError = reader.GetLastError();
+	const bool readAll = (readError == wxSTREAM_NO_ERROR) || (readError == wxSTREAM_EOF);
+
+	if (readAll && (!GetIndexFolder().Mkdir() || !GameIndexImage::Save(indexFile, srcSize, srcTime, header, GetGameList())))
+		Console.Warning(L"(GameDB) Could not write the compiled index [%s]", WX_STR(indexFile));
+
 	return *this;
 }
 
 // Saves changes to the database
 
 void AppGameDatabase::SaveToFile(const wxString& file) {
+	ExpandIndex();
+
 	wxFFileOutputStream writer( file );
 	pxWriteMultiline(writer, header);
 
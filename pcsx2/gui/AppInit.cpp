@@ -251,6 +251,14 @@ void Pcsx2App::OnInitCmdLine( wxCmdLineParser& parser )
 
 	parser.AddSwitch( wxEmptyString,L"profiling",	_("update options to ease profiling (debug)") );
 
+	parser.AddOption( wxEmptyString,L"autotest",	_("runs the ps2autotests ELF, or all of those in a folder, without GUI; then exits"), wxCMD_LINE_VAL_STRING );
+	parser.AddOption( wxEmptyString,L"testfilter",	_("only runs the tests whose name matches the given regular expression"), wxCMD_LINE_VAL_STRING );
+	parser.AddOption( wxEmptyString,L"testresults",	_("writes the test results to the given JUnit (.xml) or JSON (.json) file"), wxCMD_LINE_VAL_STRING );
+	parser.AddOption( wxEmptyString,L"testtimeout",	_("seconds a test may run before it is failed (default 30)"), wxCMD_LINE_VAL_NUMBER );
+	parser.AddOption( wxEmptyString,L"testjobs",	_("number of worker processes running tests in parallel (default 1)"), wxCMD_LINE_VAL_NUMBER );
+	parser.AddSwitch( wxEmptyString,L"testcompare",	_("also runs the tests with the interpreters, and compares them to the recompilers") );
+	parser.AddOption( wxEmptyString,L"testshard",	wxEmptyString, wxCMD_LINE_VAL_STRING, wxCMD_LINE_HIDDEN );
+
 	const PluginInfo* pi = tbl_PluginInfo; do {
 		parser.AddOption( wxEmptyString, pi->GetShortname().Lower(),
 			pxsFmt( _("specify the file to use as the %s plugin"), WX_STR(pi->GetShortname()) )
@@ -325,6 +333,32 @@ bool Pcsx2App::ParseOverrides( wxCmdLineParser& parser )
 	return true;
 }
 
+// The tests only look at what the VM prints: unless other plugins were given, run them with
+// the null GS, PAD and SPU2 plugins, when those are in the default plugins folder.
+static void AutoTest_UseNullPlugins( AppConfig::FilenameOptions& plugins )
+{
+	static const PluginsEnum_t ids[] = { PluginId_GS, PluginId_PAD, PluginId_SPU2 };
+	static const wxChar* names[] = { L"gsnull", L"padnull", L"spu2null" };
+
+	wxArrayString found;
+	EnumeratePluginsInFolder( PathDefs::GetPlugins(), &found );
+
+	for( uint i=0; i<ArraySize(ids); ++i )
+	{
+		if( plugins.Plugins[ids[i]].IsOk() ) continue;
+
+		for( uint j=0; j<found.GetCount(); ++j )
+		{
+			if( !wxFileName( found[j] ).GetName().Lower().Contains( names[i] ) ) continue;
+			plugins.Plugins[ids[i]] = found[j];
+			break;
+		}
+
+		if( !plugins.Plugins[ids[i]].IsOk() )
+			Console.Warning( L"(AutoTest) No %s plugin found, the configured plugin is used.", names[i] );
+	}
+}
+
 bool Pcsx2App::OnCmdLineParsed( wxCmdLineParser& parser )
 {
 	if( parser.Found(L"console") )
@@ -365,6 +399,33 @@ bool Pcsx2App::OnCmdLineParsed( wxCmdLineParser& parser )
 		}
 	}
 
+	wxString testPath;
+	if (parser.Found(L"autotest", &testPath) && !testPath.IsEmpty())
+	{
+		AutoTestOptions& test( Startup.AutoTest );
+		test.Path = testPath;
+		parser.Found(L"testfilter", &test.Filter);
+		parser.Found(L"testresults", &test.Results);
+		test.Compare = parser.Found(L"testcompare");
+
+		long value;
+		if (parser.Found(L"testtimeout", &value) && value > 0) test.Timeout = value;
+		if (parser.Found(L"testjobs", &value) && value > 0) test.Jobs = value;
+
+		// k/n, given by the scheduler to its workers
+		wxString shard;
+		unsigned long index, count;
+		if (parser.Found(L"testshard", &shard) && shard.BeforeFirst(L'/').ToULong(&index) && shard.AfterFirst(L'/').ToULong(&count) && index < count)
+		{
+			test.ShardIndex = index;
+			test.ShardCount = count;
+		}
+
+		AutoTest_UseNullPlugins( Overrides.Filenames );
+
+		m_UseGUI = false;
+	}
+
 	if( parser.Found(L"usecd") )
 	{
 		Startup.CdvdSource	= CDVD_SourceType::Plugin;
@@ -500,7 +561,11 @@ bool Pcsx2App::OnInit()
 		// By default no IRX injection
 		g_Conf->CurrentIRX = "";
 
-		if( Startup.SysAutoRun )
+		if( Startup.AutoTest.IsEnabled() )
+		{
+			AutoTest_Start( Startup.AutoTest );
+		}
+		else if( Startup.SysAutoRun )
 		{
 			g_Conf->EmuOptions.UseBOOT2Injection = !Startup.NoFastBoot;
 			g_Conf->CdvdSource = Startup.CdvdSource;
@@ -664,6 +729,14 @@ void Pcsx2App::CleanupResources()
 	m_Resources = NULL;
 }
 
+int Pcsx2App::OnRun()
+{
+	const int retval = wxApp::OnRun();
+
+	// Test runs tell the outcome through the exit code.
+	return Startup.AutoTest.IsEnabled() ? AutoTest_GetExitCode() : retval;
+}
+
 int Pcsx2App::OnExit()
 {
 	CleanupOnExit();
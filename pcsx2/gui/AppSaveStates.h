@@ -66,6 +66,7 @@ extern void States_registerLoadBackupMenuItem( wxMenuItem* loadBackupMenuItem );
 extern bool States_isSlotUsed(int num);
 extern void States_DefrostCurrentSlotBackup();
 extern void States_DefrostCurrentSlot();
+extern void States_Rewind();
 extern void States_FreezeCurrentSlot();
 extern void States_CycleSlotForward();
 extern void States_CycleSlotBackward();
@@ -0,0 +1,769 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "App.h"
+#include "AutoTest.h"
+#include "CDVD/CDVDaccess.h"
+#include "DebugTools/SymbolMap.h"
+
+#include <wx/dir.h>
+#include <wx/ffile.h>
+#include <wx/process.h>
+#include <wx/regex.h>
+#include <wx/stdpaths.h>
+
+using namespace Threading;
+
+static const wxChar* const TestBegin	= L"-- TEST BEGIN";
+static const wxChar* const TestEnd		= L"-- TEST END";
+
+enum AutoTestMode
+{
+	AutoTest_Recompilers,
+	AutoTest_Interpreters,
+	AutoTest_Comparison,		// recompilers against interpreters
+	AutoTest_ModeCount
+};
+
+enum AutoTestStatus
+{
+	AutoTest_Passed,
+	AutoTest_Failed,
+	AutoTest_Timeout,
+	AutoTest_Error,				// couldn't be run, or nothing to compare against
+	AutoTest_StatusCount
+};
+
+static const wxChar* const AutoTestModeNames[AutoTest_ModeCount] = { L"rec", L"interp", L"compare" };
+static const wxChar* const AutoTestStatusNames[AutoTest_StatusCount] = { L"passed", L"failed", L"timeout", L"error" };
+
+struct AutoTestCase
+{
+	wxString	Name;			// Path relative to the suite, without extension
+	wxString	Elf;
+	wxString	Expected;
+};
+
+struct AutoTestResult
+{
+	wxString		Name;
+	AutoTestMode	Mode;
+	AutoTestStatus	Status;
+	u32				Time;		// milliseconds
+	wxString		Message;
+
+	AutoTestResult( const wxString& name = wxEmptyString, AutoTestMode mode = AutoTest_Recompilers )
+		: Name( name )
+	{
+		Mode	= mode;
+		Status	= AutoTest_Passed;
+		Time	= 0;
+	}
+};
+
+typedef std::vector<AutoTestResult> AutoTestResults;
+
+static int s_exitCode = 0;
+
+// --------------------------------------------------------------------------------------
+//  Helpers
+// --------------------------------------------------------------------------------------
+static std::vector<AutoTestCase> AutoTest_FindTests( const AutoTestOptions& opts )
+{
+	std::vector<AutoTestCase> tests;
+
+	wxArrayString elfs;
+	wxString root;
+	if( wxDirExists( opts.Path ) )
+	{
+		root = wxFileName::DirName( opts.Path ).GetFullPath();
+		wxDir::GetAllFiles( opts.Path, &elfs, L"*.elf" );
+	}
+	else
+	{
+		root = wxFileName( opts.Path ).GetPath( wxPATH_GET_SEPARATOR );
+		elfs.Add( opts.Path );
+	}
+	elfs.Sort();
+
+	wxRegEx filter;
+	if( !opts.Filter.IsEmpty() && !filter.Compile( opts.Filter, wxRE_EXTENDED | wxRE_ICASE ) )
+		Console.Error( L"(AutoTest) Invalid test filter, running all tests: %s", WX_STR(opts.Filter) );
+
+	for( uint i=0; i<elfs.GetCount(); ++i )
+	{
+		wxFileName elf( elfs[i] );
+		elf.MakeAbsolute();
+
+		AutoTestCase test;
+		test.Elf = elf.GetFullPath();
+
+		wxFileName name( elf );
+		name.MakeRelativeTo( root );
+		name.ClearExt();
+		test.Name = name.GetFullPath( wxPATH_UNIX );
+
+		wxFileName expected( elf );
+		expected.SetExt( L"expected" );
+		test.Expected = expected.GetFullPath();
+
+		if( filter.IsValid() && !filter.Matches( test.Name ) ) continue;
+		tests.push_back( test );
+	}
+
+	return tests;
+}
+
+// Tests run by a worker; tests.size() and the shards must be the same in every process.
+static bool AutoTest_InShard( const AutoTestOptions& opts, uint testIndex )
+{
+	return !opts.ShardCount || (testIndex % opts.ShardCount) == opts.ShardIndex;
+}
+
+static wxArrayString AutoTest_SplitLines( const wxString& text )
+{
+	wxArrayString lines;
+	size_t start = 0;
+	while( start < text.length() )
+	{
+		size_t end = text.find( L'\n', start );
+		if( end == wxString::npos ) end = text.length();
+
+		wxString line( text.Mid( start, end - start ) );
+		if( line.EndsWith( L"\r" ) ) line.RemoveLast();
+		lines.Add( line );
+
+		start = end + 1;
+	}
+	return lines;
+}
+
+// The lines from "-- TEST BEGIN" to "-- TEST END", which is what .expected files hold.
+static wxArrayString AutoTest_ExtractLog( const wxString& captured )
+{
+	const wxArrayString all( AutoTest_SplitLines( captured ) );
+	wxArrayString lines;
+
+	bool dump = false;
+	for( uint i=0; i<all.GetCount(); ++i )
+	{
+		if( all[i].Contains( TestBegin ) ) dump = true;
+		if( dump ) lines.Add( all[i] );
+		if( dump && all[i].Contains( TestEnd ) ) break;
+	}
+	return lines;
+}
+
+// Empty if both match, or where they first differ.
+static wxString AutoTest_Diff( const wxArrayString& expected, const wxArrayString& actual, const wxChar* expectedName, const wxChar* actualName )
+{
+	const uint count = std::min( expected.GetCount(), actual.GetCount() );
+	for( uint i=0; i<count; ++i )
+	{
+		if( expected[i] != actual[i] )
+			return pxsFmt( L"line %u: %s \"%s\", %s \"%s\"", i + 1, expectedName, WX_STR(expected[i]), actualName, WX_STR(actual[i]) );
+	}
+
+	if( expected.GetCount() != actual.GetCount() )
+		return pxsFmt( L"%s has %u lines, %s has %u", expectedName, (u32)expected.GetCount(), actualName, (u32)actual.GetCount() );
+
+	return wxEmptyString;
+}
+
+static wxString AutoTest_EscapeXml( const wxString& src )
+{
+	wxString dest;
+	for( wxString::const_iterator it = src.begin(); it != src.end(); ++it )
+	{
+		switch( (wxChar)*it )
+		{
+			case L'&':	dest += L"&amp;";	break;
+			case L'<':	dest += L"&lt;";	break;
+			case L'>':	dest += L"&gt;";	break;
+			case L'"':	dest += L"&quot;";	break;
+			default:	dest += *it;		break;
+		}
+	}
+	return dest;
+}
+
+static wxString AutoTest_EscapeJson( const wxString& src )
+{
+	wxString dest;
+	for( wxString::const_iterator it = src.begin(); it != src.end(); ++it )
+	{
+		const wxChar c = *it;
+		switch( c )
+		{
+			case L'"':	dest += L"\\\"";	break;
+			case L'\\':	dest += L"\\\\";	break;
+			case L'\n':	dest += L"\\n";		break;
+			case L'\r':	dest += L"\\r";		break;
+			case L'\t':	dest += L"\\t";		break;
+			default:
+				if( (u32)c < 0x20 )
+					dest += pxsFmt( L"\\u%04x", (u32)c );
+				else
+					dest += c;
+			break;
+		}
+	}
+	return dest;
+}
+
+// Tab separated lines, used by the workers to hand their results over to the scheduler.
+static wxString AutoTest_FlattenField( const wxString& src )
+{
+	wxString dest( src );
+	dest.Replace( L"\t", L" " );
+	dest.Replace( L"\r", L" " );
+	dest.Replace( L"\n", L" " );
+	return dest;
+}
+
+static wxString AutoTest_FormatTsv( const AutoTestResults& results )
+{
+	wxString out;
+	for( const AutoTestResult& result : results )
+	{
+		out += pxsFmt( L"%s\t%s\t%u\t%s\t%s\n", AutoTestModeNames[result.Mode], AutoTestStatusNames[result.Status],
+			result.Time, WX_STR(AutoTest_FlattenField( result.Name )), WX_STR(AutoTest_FlattenField( result.Message )) );
+	}
+	return out;
+}
+
+static bool AutoTest_ParseTsv( const wxString& text, AutoTestResults& results )
+{
+	const wxArrayString lines( AutoTest_SplitLines( text ) );
+	for( uint i=0; i<lines.GetCount(); ++i )
+	{
+		if( lines[i].IsEmpty() ) continue;
+
+		const wxArrayString fields( wxSplit( lines[i], L'\t', 0 ) );
+		if( fields.GetCount() != 5 ) return false;
+
+		AutoTestResult result( fields[3] );
+		unsigned long time;
+		if( !fields[2].ToULong( &time ) ) return false;
+		result.Time = time;
+		result.Message = fields[4];
+
+		int mode = 0, status = 0;
+		while( mode < AutoTest_ModeCount && fields[0] != AutoTestModeNames[mode] ) ++mode;
+		while( status < AutoTest_StatusCount && fields[1] != AutoTestStatusNames[status] ) ++status;
+		if( mode == AutoTest_ModeCount || status == AutoTest_StatusCount ) return false;
+
+		result.Mode = (AutoTestMode)mode;
+		result.Status = (AutoTestStatus)status;
+		results.push_back( result );
+	}
+	return true;
+}
+
+static wxString AutoTest_FormatJUnit( const AutoTestResults& results, const uint (&counts)[AutoTest_StatusCount], u64 totalTime )
+{
+	wxString out;
+	out += L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	out += pxsFmt( L"<testsuite name=\"ps2autotests\" tests=\"%u\" failures=\"%u\" errors=\"%u\" time=\"%.3f\">\n",
+		(u32)results.size(), counts[AutoTest_Failed] + counts[AutoTest_Timeout], counts[AutoTest_Error], totalTime / 1000.0 );
+
+	for( const AutoTestResult& result : results )
+	{
+		out += pxsFmt( L"\t<testcase classname=\"%s\" name=\"%s\" time=\"%.3f\"", AutoTestModeNames[result.Mode],
+			WX_STR(AutoTest_EscapeXml( result.Name )), result.Time / 1000.0 );
+
+		if( result.Status == AutoTest_Passed )
+		{
+			out += L"/>\n";
+			continue;
+		}
+
+		const wxChar* tag = (result.Status == AutoTest_Error) ? L"error" : L"failure";
+		out += pxsFmt( L">\n\t\t<%s type=\"%s\" message=\"%s\"/>\n\t</testcase>\n", tag, AutoTestStatusNames[result.Status],
+			WX_STR(AutoTest_EscapeXml( result.Message )) );
+	}
+
+	out += L"</testsuite>\n";
+	return out;
+}
+
+static wxString AutoTest_FormatJson( const AutoTestResults& results, const uint (&counts)[AutoTest_StatusCount], u64 totalTime )
+{
+	wxString out;
+	out += L"{\n\t\"suite\": \"ps2autotests\",\n";
+	out += pxsFmt( L"\t\"time_ms\": %llu,\n", totalTime );
+	for( int i=0; i<AutoTest_StatusCount; ++i )
+		out += pxsFmt( L"\t\"%s\": %u,\n", AutoTestStatusNames[i], counts[i] );
+
+	out += L"\t\"tests\": [";
+	for( size_t i=0; i<results.size(); ++i )
+	{
+		const AutoTestResult& result = results[i];
+		out += pxsFmt( L"%s\n\t\t{ \"name\": \"%s\", \"mode\": \"%s\", \"status\": \"%s\", \"time_ms\": %u, \"message\": \"%s\" }",
+			i ? L"," : L"", WX_STR(AutoTest_EscapeJson( result.Name )), AutoTestModeNames[result.Mode],
+			AutoTestStatusNames[result.Status], result.Time, WX_STR(AutoTest_EscapeJson( result.Message )) );
+	}
+	out += L"\n\t]\n}\n";
+	return out;
+}
+
+static bool AutoTest_WriteFile( const wxString& filename, const wxString& text )
+{
+	wxFFile file( filename, L"wb" );
+	return file.IsOpened() && file.Write( text, wxConvUTF8 ) && file.Close();
+}
+
+static bool AutoTest_ReadFile( const wxString& filename, wxString& text )
+{
+	if( !wxFileExists( filename ) ) return false;
+
+	wxFFile file( filename, L"rb" );
+	return file.IsOpened() && file.ReadAll( &text, wxConvUTF8 );
+}
+
+static bool AutoTest_SortResults( const AutoTestResult& a, const AutoTestResult& b )
+{
+	const int cmp = a.Name.Cmp( b.Name );
+	return cmp ? (cmp < 0) : (a.Mode < b.Mode);
+}
+
+// Reports the results, and has the app exit.
+static void AutoTest_Finish( const AutoTestOptions& opts, AutoTestResults& results, u64 totalTime )
+{
+	std::stable_sort( results.begin(), results.end(), AutoTest_SortResults );
+
+	uint counts[AutoTest_StatusCount] = {};
+	for( const AutoTestResult& result : results )
+		++counts[result.Status];
+
+	// Workers only hand their results over; the scheduler does the talking.
+	if( !opts.ShardCount )
+	{
+		for( const AutoTestResult& result : results )
+		{
+			if( result.Status == AutoTest_Passed ) continue;
+			Console.Error( L"(AutoTest) %-7s %-7s %s: %s", AutoTestStatusNames[result.Status], AutoTestModeNames[result.Mode],
+				WX_STR(result.Name), WX_STR(result.Message) );
+		}
+
+		Console.WriteLn( Color_StrongBlack, "(AutoTest) %u passed, %u failed, %u timed out, %u errors (%u ms).",
+			counts[AutoTest_Passed], counts[AutoTest_Failed], counts[AutoTest_Timeout], counts[AutoTest_Error], (u32)totalTime );
+	}
+
+	if( !opts.Results.IsEmpty() )
+	{
+		const wxString ext( wxFileName( opts.Results ).GetExt().Lower() );
+		wxString report;
+		if( ext == L"xml" )
+			report = AutoTest_FormatJUnit( results, counts, totalTime );
+		else if( ext == L"json" )
+			report = AutoTest_FormatJson( results, counts, totalTime );
+		else
+			report = AutoTest_FormatTsv( results );
+
+		if( !AutoTest_WriteFile( opts.Results, report ) )
+			Console.Error( L"(AutoTest) Could not write the results [%s]", WX_STR(opts.Results) );
+	}
+
+	// A path or filter which matches no test is a mistake, not a pass.
+	if( results.empty() && !opts.ShardCount )
+		Console.Error( L"(AutoTest) No tests were run." );
+
+	s_exitCode = (!results.empty() && counts[AutoTest_Passed] == results.size()) ? 0 : 1;
+	sApp.PostAppMethod( &Pcsx2App::PrepForExit );
+}
+
+// --------------------------------------------------------------------------------------
+//  VM console capture
+// --------------------------------------------------------------------------------------
+// Only one test runs at a time, so a single buffer does.  The end semaphore is posted once
+// "-- TEST END" shows up, after which the rest of the output is ignored.
+
+static Mutex		s_captureLock;
+static wxString		s_captured;
+static bool			s_captureEnded = true;
+static Semaphore	s_captureEnd;
+
+static void AutoTest_Capture( const wxChar* msg )
+{
+	ScopedLock lock( s_captureLock );
+	if( s_captureEnded ) return;
+
+	const size_t tail = s_captured.length();
+	s_captured += msg;
+
+	// Only look where the marker could have been completed.
+	const size_t markerLen = wxStrlen( TestEnd );
+	if( s_captured.find( TestEnd, (tail > markerLen) ? tail - markerLen : 0 ) != wxString::npos )
+	{
+		s_captureEnded = true;
+		s_captureEnd.Post();
+	}
+}
+
+static void AutoTest_BeginCapture()
+{
+	ScopedLock lock( s_captureLock );
+	s_captured.clear();
+	s_captureEnded = false;
+	s_captureEnd.Reset();
+}
+
+static wxString AutoTest_EndCapture()
+{
+	ScopedLock lock( s_captureLock );
+	s_captureEnded = true;
+
+	wxString captured;
+	captured.swap( s_captured );
+	return captured;
+}
+
+// --------------------------------------------------------------------------------------
+//  SysExecEvent_AutoTestBoot
+// --------------------------------------------------------------------------------------
+// Boots an ELF like SysExecute does, minus saving the settings every time (several workers
+// share the same ini files).
+class SysExecEvent_AutoTestBoot : public SysExecEvent
+{
+protected:
+	wxString		m_elf;
+	bool			m_interpreters;
+
+public:
+	virtual ~SysExecEvent_AutoTestBoot() = default;
+	SysExecEvent_AutoTestBoot* Clone() const { return new SysExecEvent_AutoTestBoot(*this); }
+
+	wxString GetEventName() const
+	{
+		return L"AutoTestBoot";
+	}
+
+	wxString GetEventMessage() const
+	{
+		return _("Booting test ELF...");
+	}
+
+	SysExecEvent_AutoTestBoot( const wxString& elf = wxEmptyString, bool interpreters = false )
+		: m_elf( elf )
+	{
+		m_interpreters = interpreters;
+	}
+
+protected:
+	void InvokeEvent()
+	{
+		LoadPluginsImmediate();
+
+		CoreThread.ResetQuick();
+		symbolMap.Clear();
+
+		// Applied from g_Conf when the VM resumes.
+		Pcsx2Config::RecompilerOptions& recs = g_Conf->EmuOptions.Cpu.Recompiler;
+		const Pcsx2Config::RecompilerOptions& defaults = GetDefaultRecompilers();
+		recs.EnableEE	= !m_interpreters && defaults.EnableEE;
+		recs.EnableIOP	= !m_interpreters && defaults.EnableIOP;
+		recs.EnableVU0	= !m_interpreters && defaults.EnableVU0;
+		recs.EnableVU1	= !m_interpreters && defaults.EnableVU1;
+		g_Conf->EmuOptions.UseBOOT2Injection = true;
+
+		CDVDsys_ChangeSource( CDVD_SourceType::NoDisc );
+		CoreThread.SetElfOverride( m_elf );
+		CoreThread.Resume();
+	}
+
+public:
+	// The recompiler settings from the ini, which the recompiler runs use (and which are
+	// put back once the tests are done).
+	static Pcsx2Config::RecompilerOptions& GetDefaultRecompilers()
+	{
+		static Pcsx2Config::RecompilerOptions recs;
+		return recs;
+	}
+};
+
+// --------------------------------------------------------------------------------------
+//  AutoTestThread
+// --------------------------------------------------------------------------------------
+// Runs the tests of this process, one after the other.
+class AutoTestThread : public pxThread
+{
+	typedef pxThread _parent;
+
+protected:
+	AutoTestOptions		m_opts;
+
+public:
+	AutoTestThread( const AutoTestOptions& opts )
+		: pxThread( L"AutoTest" )
+		, m_opts( opts )
+	{
+	}
+
+	virtual ~AutoTestThread()
+	{
+		try {
+			_parent::Cancel();
+		}
+		DESTRUCTOR_CATCHALL
+	}
+
+protected:
+	void ExecuteTaskInThread();
+	void OnCleanupInThread();
+
+	AutoTestResult RunTest( const AutoTestCase& test, AutoTestMode mode, wxArrayString& output );
+};
+
+AutoTestResult AutoTestThread::RunTest( const AutoTestCase& test, AutoTestMode mode, wxArrayString& output )
+{
+	AutoTestResult result( test.Name, mode );
+	output.Clear();
+
+	Console.WriteLn( Color_StrongBlack, L"(AutoTest) Running %s [%s]", WX_STR(test.Name), AutoTestModeNames[mode] );
+
+	AutoTest_BeginCapture();
+	const u64 start = GetCPUTicks();
+	bool ended = false;
+
+	try {
+		GetSysExecutorThread().ProcessEvent( new SysExecEvent_AutoTestBoot( test.Elf, mode == AutoTest_Interpreters ) );
+		ended = s_captureEnd.WaitWithoutYield( wxTimeSpan( 0, 0, m_opts.Timeout ) );
+	}
+	catch( BaseException& ex )
+	{
+		result.Status = AutoTest_Error;
+		result.Message = ex.FormatDiagnosticMessage();
+	}
+
+	result.Time = (u32)(((GetCPUTicks() - start) * 1000) / GetTickFrequency());
+	CoreThread.Suspend();
+
+	output = AutoTest_ExtractLog( AutoTest_EndCapture() );
+	if( result.Status != AutoTest_Passed ) return result;
+
+	if( !ended )
+	{
+		result.Status = AutoTest_Timeout;
+		result.Message = pxsFmt( L"no \"%s\" after %u seconds", TestEnd, m_opts.Timeout );
+		return result;
+	}
+
+	wxString expected;
+	if( !AutoTest_ReadFile( test.Expected, expected ) )
+	{
+		// Still worth running for the comparison.
+		result.Status = AutoTest_Error;
+		result.Message = L"missing .expected file";
+		return result;
+	}
+
+	result.Message = AutoTest_Diff( AutoTest_ExtractLog( expected ), output, L"expected", L"got" );
+	if( !result.Message.IsEmpty() ) result.Status = AutoTest_Failed;
+	return result;
+}
+
+void AutoTestThread::ExecuteTaskInThread()
+{
+	const std::vector<AutoTestCase> tests( AutoTest_FindTests( m_opts ) );
+	const u64 start = GetCPUTicks();
+
+	AutoTestResults results;
+	for( uint i=0; i<tests.size(); ++i )
+	{
+		if( !AutoTest_InShard( m_opts, i ) ) continue;
+
+		wxArrayString recOutput;
+		const AutoTestResult rec( RunTest( tests[i], AutoTest_Recompilers, recOutput ) );
+		results.push_back( rec );
+
+		if( !m_opts.Compare ) continue;
+
+		wxArrayString interpOutput;
+		const AutoTestResult interp( RunTest( tests[i], AutoTest_Interpreters, interpOutput ) );
+		results.push_back( interp );
+
+		AutoTestResult compare( tests[i].Name, AutoTest_Comparison );
+		compare.Time = rec.Time + interp.Time;
+		compare.Message = AutoTest_Diff( recOutput, interpOutput, L"rec", L"interp" );
+		if( !compare.Message.IsEmpty() ) compare.Status = AutoTest_Failed;
+		results.push_back( compare );
+	}
+
+	g_Conf->EmuOptions.Cpu.Recompiler = SysExecEvent_AutoTestBoot::GetDefaultRecompilers();
+
+	AutoTest_Finish( m_opts, results, ((GetCPUTicks() - start) * 1000) / GetTickFrequency() );
+}
+
+void AutoTestThread::OnCleanupInThread()
+{
+	_parent::OnCleanupInThread();
+	wxGetApp().DeleteThread(this);
+}
+
+// --------------------------------------------------------------------------------------
+//  AutoTestScheduler
+// --------------------------------------------------------------------------------------
+// Spreads the tests over worker processes, and merges their results.  Lives on the main
+// thread, where wxProcess termination is reported.
+class AutoTestScheduler;
+
+class AutoTestWorker : public wxProcess
+{
+protected:
+	AutoTestScheduler&	m_scheduler;
+	uint				m_shard;
+
+public:
+	AutoTestWorker( AutoTestScheduler& scheduler, uint shard )
+		: m_scheduler( scheduler )
+	{
+		m_shard = shard;
+	}
+
+	void OnTerminate( int pid, int status );
+};
+
+class AutoTestScheduler
+{
+	DeclareNoncopyableObject( AutoTestScheduler );
+
+protected:
+	AutoTestOptions				m_opts;
+	std::vector<AutoTestCase>	m_tests;
+	wxArrayString				m_resultFiles;		// per worker
+	std::vector<std::unique_ptr<AutoTestWorker>> m_workers;
+	AutoTestResults				m_results;
+	uint						m_jobs;
+	uint						m_running;
+	u64							m_start;
+
+public:
+	AutoTestScheduler( const AutoTestOptions& opts )
+		: m_opts( opts )
+	{
+		m_jobs = 0;
+		m_running = 0;
+		m_start = 0;
+	}
+
+	virtual ~AutoTestScheduler() = default;
+
+	void Start();
+	void OnWorkerDone( uint shard, int status );
+};
+
+void AutoTestWorker::OnTerminate( int pid, int status )
+{
+	m_scheduler.OnWorkerDone( m_shard, status );
+}
+
+void AutoTestScheduler::Start()
+{
+	m_tests = AutoTest_FindTests( m_opts );
+	m_start = GetCPUTicks();
+
+	// Set before any worker starts: it's the stride of the shards in OnWorkerDone.
+	m_jobs = std::min<uint>( m_opts.Jobs, std::max<uint>( 1, m_tests.size() ) );
+	const uint jobs = m_jobs;
+	Console.WriteLn( Color_StrongBlack, "(AutoTest) Running %u tests in %u workers.", (u32)m_tests.size(), jobs );
+
+	// Workers get the same command line, minus the options only the scheduler deals with.
+	wxString baseCmd( L"\"" + wxStandardPaths::Get().GetExecutablePath() + L"\"" );
+	const wxArrayString& args = wxTheApp->argv.GetArguments();
+	for( uint i=1; i<args.GetCount(); ++i )
+	{
+		if( args[i].StartsWith( L"--testjobs" ) || args[i].StartsWith( L"--testresults" ) )
+		{
+			// "--option value" rather than "--option=value"
+			if( !args[i].Contains( L"=" ) ) ++i;
+			continue;
+		}
+		baseCmd += L" \"" + args[i] + L"\"";
+	}
+
+	m_running = jobs;
+	for( uint shard=0; shard<jobs; ++shard )
+	{
+		m_resultFiles.Add( wxFileName::CreateTempFileName( L"pcsx2test" ) );
+		m_workers.push_back( std::unique_ptr<AutoTestWorker>( new AutoTestWorker( *this, shard ) ) );
+
+		const wxString cmd( baseCmd + pxsFmt( L" --nogui \"--testshard=%u/%u\" \"--testresults=%s\"", shard, jobs, WX_STR(m_resultFiles[shard]) ) );
+		if( !wxExecute( cmd, wxEXEC_ASYNC, m_workers[shard].get() ) )
+			OnWorkerDone( shard, -1 );
+	}
+}
+
+void AutoTestScheduler::OnWorkerDone( uint shard, int status )
+{
+	AutoTestResults results;
+	wxString text;
+	if( !AutoTest_ReadFile( m_resultFiles[shard], text ) || !AutoTest_ParseTsv( text, results ) )
+		results.clear();
+	wxRemoveFile( m_resultFiles[shard] );
+
+	// Whatever the worker didn't get to (it crashed, or couldn't start).
+	for( uint i=shard; i<m_tests.size(); i+=m_jobs )
+	{
+		bool found = false;
+		for( const AutoTestResult& result : results )
+			found |= (result.Name == m_tests[i].Name);
+		if( found ) continue;
+
+		AutoTestResult missing( m_tests[i].Name );
+		missing.Status = AutoTest_Error;
+		missing.Message = pxsFmt( L"no result (worker %u exited with status %d)", shard, status );
+		results.push_back( missing );
+	}
+
+	m_results.insert( m_results.end(), results.begin(), results.end() );
+
+	if( --m_running ) return;
+
+	AutoTest_Finish( m_opts, m_results, ((GetCPUTicks() - m_start) * 1000) / GetTickFrequency() );
+}
+
+// --------------------------------------------------------------------------------------
+//  AutoTest  (public API)
+// --------------------------------------------------------------------------------------
+static std::unique_ptr<AutoTestScheduler> s_scheduler;
+
+void AutoTest_Start( const AutoTestOptions& opts )
+{
+	AffinityAssert_AllowFrom_MainUI();
+
+	if( opts.Jobs > 1 && !opts.ShardCount )
+	{
+		s_scheduler = std::unique_ptr<AutoTestScheduler>( new AutoTestScheduler( opts ) );
+		s_scheduler->Start();
+		return;
+	}
+
+	// The test output comes over the VM consoles, whatever the log settings say.
+	SysConsole.eeConsole.Enabled	= true;
+	SysConsole.iopConsole.Enabled	= true;
+	SysConsole.deci2.Enabled		= true;
+	VMConsoleCapture = AutoTest_Capture;
+
+	SysExecEvent_AutoTestBoot::GetDefaultRecompilers() = g_Conf->EmuOptions.Cpu.Recompiler;
+
+	(new AutoTestThread( opts ))->Start();
+}
+
+int AutoTest_GetExitCode()
+{
+	return s_exitCode;
+}
@@ -0,0 +1,64 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  AutoTestOptions
+// --------------------------------------------------------------------------------------
+// Headless runner for the ps2autotests suite (https://github.com/unknownbrackets/ps2autotests),
+// enabled with --autotest on the command line.  Without any GUI, every test ELF found is
+// booted in turn, what the EE and IOP print between "-- TEST BEGIN" and "-- TEST END" is
+// captured straight from the VM consoles, and compared against the .expected file next to
+// the ELF.  PCSX2 exits once all tests ran; the exit code is 0 only if all of them passed
+// (and there was at least one).  Unless --gs, --pad or --spu2 say otherwise, the null
+// plugins of the default plugins folder are used.
+//
+// The VM is a singleton, so tests run one at a time within a process.  With --testjobs=n,
+// the process becomes a scheduler instead: it starts n copies of itself, each running a
+// share of the tests (--testshard), and merges what they report.
+//
+// With --testcompare, every test also runs with all interpreters, and the output of both
+// runs is compared, whether or not the test has an .expected file.
+//
+struct AutoTestOptions
+{
+	wxString	Path;			// ELF, or folder searched for ELFs (empty: not testing)
+	wxString	Filter;			// Regular expression test names must match (case insensitive)
+	wxString	Results;		// Report: JUnit (.xml), JSON (.json), or tab separated lines
+	uint		Timeout;		// Seconds a test may run
+	uint		Jobs;			// Worker processes
+	uint		ShardIndex;		// Part of the tests run by a worker
+	uint		ShardCount;		//   (0: not a worker)
+	bool		Compare;		// Also run the interpreters, and compare
+
+	AutoTestOptions()
+	{
+		Timeout		= 30;
+		Jobs		= 1;
+		ShardIndex	= 0;
+		ShardCount	= 0;
+		Compare		= false;
+	}
+
+	bool IsEnabled() const { return !Path.IsEmpty(); }
+};
+
+// Starts running the tests; must be called from the main thread, once the core stuff is
+// allocated.  The app exits when they're done.
+extern void AutoTest_Start( const AutoTestOptions& opts );
+
+// Process exit code for the test run: 0 if every test passed.
+extern int AutoTest_GetExitCode();
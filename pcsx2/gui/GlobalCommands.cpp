@@ -493,6 +493,13 @@ static const GlobalCommandDescriptor CommandDeclarations[] =
 		false,
 	},
 
+	{	"States_Rewind",
+		States_Rewind,
+		pxL( "Rewind" ),
+		pxL( "Steps the virtual machine back to the most recent rewind snapshot." ),
+		false,
+	},
+
 	{	"States_CycleSlotForward",
 		States_CycleSlotForward,
 		pxL( "Cycle to next slot" ),
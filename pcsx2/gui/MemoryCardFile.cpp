@@ -40,6 +40,16 @@ struct Component_FileMcd;
 
 #include <wx/ffile.h>
 #include <map>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Threading;
 
 static const int MCD_SIZE	= 1024 *  8  * 16;		// Legacy PSX card default size
 
@@ -49,11 +59,40 @@ static const int MC2_SIZE	= MC2_MBSIZE * 8;		// PS2 card default size (8MB)
 // --------------------------------------------------------------------------------------
 //  FileMemoryCard
 // --------------------------------------------------------------------------------------
-// Provides thread-safe direct file IO mapping.
+// Keeps the whole card image of each slot in memory.  Reads and writes from the SIO are
+// served from there; the erase blocks they dirty are written back to the file by a helper
+// thread, FramesAfterWriteUntilFlush frames after the last write (and on Close).
 //
 class FileMemoryCard
 {
+public:
+	static const int FramesAfterWriteUntilFlush = 2;
+
+	// Granularity of the dirty tracking: an erase block (16 sectors of 528 bytes).
+	static const uint DirtyBlockSize = 528*16;
+
 protected:
+	class Flusher : public pxThread
+	{
+		typedef pxThread _parent;
+
+	public:
+		Flusher( FileMemoryCard& parent );
+		virtual ~Flusher();
+
+		void Post() { m_sem.Post(); }
+
+		// Finishes the flush in progress, if any, and exits the thread.
+		void Quit();
+
+	protected:
+		void ExecuteTaskInThread();
+
+		FileMemoryCard&		m_parent;
+		Semaphore			m_sem;
+		std::atomic<bool>	m_quit;
+	};
+
 	wxFFile			m_file[8];
 	u8				m_effeffs[528*16];
 	SafeArray<u8>	m_currentdata;
@@ -61,6 +100,23 @@ protected:
 	bool			m_ispsx[8];
 	u32				m_chkaddr;
 
+	// Contents of each card file, and where the card data starts in it (see GetDataOffset).
+	std::vector<u8>	m_image[8];
+	u32				m_offset[8];
+
+	// Erase blocks of the file changed since they were last written.  Guarded by m_lock,
+	// as the flusher takes its snapshot of the dirty data from there.
+	std::vector<bool> m_dirty[8];
+	bool			m_flushRequested[8];
+	int				m_framesUntilFlush[8];
+
+	// Xor of the 64 bit words of PSX cards, kept up to date by WriteImage (see GetCRC).
+	u64				m_crc[8];
+	u32				m_crcEnd[8];
+
+	Mutex			m_lock;
+	std::unique_ptr<Flusher> m_flusher;
+
 public:
 	FileMemoryCard();
 	virtual ~FileMemoryCard() = default;
@@ -78,9 +134,15 @@ public:
 	s32  Save		( uint slot, const u8 *src, u32 adr, int size );
 	s32  EraseBlock	( uint slot, u32 adr );
 	u64  GetCRC		( uint slot );
+	void NextFrame	( uint slot );
 
 protected:
-	bool Seek( wxFFile& f, u32 adr );
+	static u32 GetDataOffset( u32 fileSize );
+	bool Load( uint slot );
+	bool InRange( uint slot, u32 adr, int size ) const;
+	void WriteImage( uint slot, u32 fileOffset, const u8* src, int size );
+	void FlushSlot( uint slot );
+	void StopFlusher();
 	bool Create( const wxString& mcdFile, uint sizeInMB );
 
 	wxString GetDisabledMessage( uint slot ) const
@@ -144,10 +206,73 @@ wxString FileMcd_GetDefaultName(uint slot)
 		return wxsFormat( L"Mcd%03u.ps2", slot+1 );
 }
 
+// --------------------------------------------------------------------------------------
+//  FileMemoryCard::Flusher
+// --------------------------------------------------------------------------------------
+FileMemoryCard::Flusher::Flusher( FileMemoryCard& parent )
+	: _parent( L"FileMcd Flush" )
+	, m_parent( parent )
+	, m_quit( false )
+{
+}
+
+FileMemoryCard::Flusher::~Flusher()
+{
+	try {
+		Quit();
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+void FileMemoryCard::Flusher::Quit()
+{
+	// Cancel() could stop the thread in the middle of a write, so let it finish instead.
+	if( !IsRunning() ) return;
+	m_quit = true;
+	m_sem.Post();
+	Block();
+}
+
+void FileMemoryCard::Flusher::ExecuteTaskInThread()
+{
+	for(;;)
+	{
+		m_sem.WaitWithoutYield();
+		if( m_quit ) return;
+
+		for( uint slot=0; slot<8; ++slot )
+			m_parent.FlushSlot( slot );
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  FileMemoryCard  (implementations)
+// --------------------------------------------------------------------------------------
 FileMemoryCard::FileMemoryCard()
 {
 	memset8<0xff>( m_effeffs );
 	m_chkaddr = 0;
+
+	for( int slot=0; slot<8; ++slot )
+	{
+		m_chksum[slot]				= 0;
+		m_ispsx[slot]				= false;
+		m_offset[slot]				= 0;
+		m_flushRequested[slot]		= false;
+		m_framesUntilFlush[slot]	= 0;
+		m_crc[slot]					= 0;
+		m_crcEnd[slot]				= 0;
+	}
+}
+
+void FileMemoryCard::Lock()
+{
+	m_lock.Acquire();
+}
+
+void FileMemoryCard::Unlock()
+{
+	m_lock.Release();
 }
 
 void FileMemoryCard::Open()
@@ -216,52 +341,240 @@ void FileMemoryCard::Open()
 				GetDisabledMessage( slot )
 			);
 		}
-		else // Load checksum
+		else if( !Load( slot ) )
 		{
-			m_ispsx[slot] = m_file[slot].Length() == 0x20000;
-			m_chkaddr = 0x210;
-
-			if(!m_ispsx[slot] && !!m_file[slot].Seek( m_chkaddr ))
-				m_file[slot].Read( &m_chksum[slot], 8 );
+			Msgbox::Alert(
+				wxsFormat(_( "Could not read memory card: \n\n%s\n\n" ), str.c_str()) +
+				GetDisabledMessage( slot )
+			);
+			m_file[slot].Close();
 		}
 	}
 }
 
 void FileMemoryCard::Close()
 {
+	// Whatever the flusher didn't get to yet is written here.
+	StopFlusher();
+
 	for( int slot=0; slot<8; ++slot )
 	{
 		if (m_file[slot].IsOpened()) {
 			// Store checksum
-			if(!m_ispsx[slot] && !!m_file[slot].Seek(  m_chkaddr ))
-				m_file[slot].Write( &m_chksum[slot], 8 );
+			if(!m_ispsx[slot] && InRange( slot, m_chkaddr, 8 ))
+				WriteImage( slot, m_offset[slot] + m_chkaddr, (u8*)&m_chksum[slot], 8 );
+
+			{
+				ScopedLock lock( m_lock );
+				m_flushRequested[slot] = true;
+			}
+			FlushSlot( slot );
 
 			m_file[slot].Close();
 		}
+
+		m_image[slot].clear();
+		m_image[slot].shrink_to_fit();
+		m_dirty[slot].clear();
+		m_framesUntilFlush[slot] = 0;
 	}
 }
 
-// Returns FALSE if the seek failed (is outside the bounds of the file).
-bool FileMemoryCard::Seek( wxFFile& f, u32 adr )
+// Returns the offset of the card data in a card file of the given size.
+u32 FileMemoryCard::GetDataOffset( u32 fileSize )
 {
-	const u32 size = f.Length();
-
 	// If anyone knows why this filesize logic is here (it appears to be related to legacy PSX
 	// cards, perhaps hacked support for some special emulator-specific memcard formats that
 	// had header info?), then please replace this comment with something useful.  Thanks!  -- air
 
 	u32 offset = 0;
 
-	if( size == MCD_SIZE + 64 )
+	if( fileSize == MCD_SIZE + 64 )
 		offset = 64;
-	else if( size == MCD_SIZE + 3904 )
+	else if( fileSize == MCD_SIZE + 3904 )
 		offset = 3904;
 	else
 	{
 		// perform sanity checks here?
 	}
 
-	return f.Seek( adr + offset );
+	return offset;
+}
+
+// Reads the whole card file of the slot into memory.  Returns false on read errors.
+bool FileMemoryCard::Load( uint slot )
+{
+	wxFFile& mcfp( m_file[slot] );
+	const u32 size = mcfp.Length();
+
+	m_image[slot].resize( size );
+	if( size && (!mcfp.Seek( 0 ) || mcfp.Read( &m_image[slot][0], size ) != size) )
+	{
+		m_image[slot].clear();
+		return false;
+	}
+
+	m_offset[slot] = GetDataOffset( size );
+	m_dirty[slot].assign( (size + DirtyBlockSize - 1) / DirtyBlockSize, false );
+	m_flushRequested[slot] = false;
+	m_framesUntilFlush[slot] = 0;
+
+	// Load checksum
+	m_ispsx[slot] = size == 0x20000;
+	m_chkaddr = 0x210;
+
+	if(!m_ispsx[slot] && InRange( slot, m_chkaddr, 8 ))
+		memcpy( &m_chksum[slot], &m_image[slot][m_offset[slot] + m_chkaddr], 8 );
+
+	// The CRC of PSX cards is the xor of the words of as many 33792 byte chunks as the file
+	// size holds, starting at the card data.
+	const u32 chunks = (size / (528*8*8)) * (528*8*8);
+	m_crcEnd[slot] = m_offset[slot] + std::min( chunks, (size - m_offset[slot]) & ~7 );
+	m_crc[slot] = 0;
+
+	if( m_ispsx[slot] )
+	{
+		for( u32 pos = m_offset[slot]; pos < m_crcEnd[slot]; pos += 8 )
+		{
+			u64 word;
+			memcpy( &word, &m_image[slot][pos], 8 );
+			m_crc[slot] ^= word;
+		}
+	}
+
+	return true;
+}
+
+// Returns FALSE if the access is outside the bounds of the card.
+bool FileMemoryCard::InRange( uint slot, u32 adr, int size ) const
+{
+	return (u64)m_offset[slot] + adr + size <= m_image[slot].size();
+}
+
+// Stores data to the card image, and schedules it for writing to the file.
+void FileMemoryCard::WriteImage( uint slot, u32 fileOffset, const u8* src, int size )
+{
+	if( size <= 0 ) return;
+
+	u8* image = &m_image[slot][0];
+
+	// The 64 bit words touched by the write are taken out of the CRC before the write, and
+	// put back in after it.
+	u32 crcStart = 0, crcEnd = 0;
+	if( m_ispsx[slot] )
+	{
+		const u32 base = m_offset[slot];
+		crcStart = base + ((fileOffset - base) & ~7);
+		crcEnd = std::min( base + ((fileOffset + size - base + 7) & ~7), m_crcEnd[slot] );
+	}
+
+	for( u32 pos = crcStart; pos < crcEnd; pos += 8 )
+	{
+		u64 word;
+		memcpy( &word, &image[pos], 8 );
+		m_crc[slot] ^= word;
+	}
+
+	ScopedLock lock( m_lock );
+
+	memcpy( &image[fileOffset], src, size );
+
+	for( u32 block = fileOffset / DirtyBlockSize; block <= (fileOffset + size - 1) / DirtyBlockSize; ++block )
+		m_dirty[slot][block] = true;
+
+	lock.Release();
+
+	for( u32 pos = crcStart; pos < crcEnd; pos += 8 )
+	{
+		u64 word;
+		memcpy( &word, &image[pos], 8 );
+		m_crc[slot] ^= word;
+	}
+
+	m_framesUntilFlush[slot] = FramesAfterWriteUntilFlush;
+}
+
+// Writes the dirty blocks of the slot to its file, if a flush was requested.  Only the copy
+// of the dirty data is made with the lock held, the file is written without it.
+void FileMemoryCard::FlushSlot( uint slot )
+{
+	struct DirtyRun
+	{
+		u32 offset;
+		u32 size;
+	};
+
+	std::vector<DirtyRun> runs;
+	std::vector<u8> data;
+	{
+		ScopedLock lock( m_lock );
+		if( !m_flushRequested[slot] ) return;
+		m_flushRequested[slot] = false;
+
+		std::vector<bool>& dirty( m_dirty[slot] );
+		const u32 imageSize = m_image[slot].size();
+		for( u32 block = 0; block < dirty.size(); ++block )
+		{
+			if( !dirty[block] ) continue;
+
+			// Neighbouring dirty blocks are written together.
+			u32 end = block;
+			while( end < dirty.size() && dirty[end] )
+				dirty[end++] = false;
+
+			const u32 offset = block * DirtyBlockSize;
+			DirtyRun run = { offset, std::min( end * DirtyBlockSize, imageSize ) - offset };
+			data.insert( data.end(), m_image[slot].begin() + run.offset, m_image[slot].begin() + run.offset + run.size );
+			runs.push_back( run );
+
+			block = end;
+		}
+	}
+
+	if( runs.empty() ) return;
+
+	wxFFile& mcfp( m_file[slot] );
+	const u8* src = data.data();
+	bool failed = false;
+	for( const DirtyRun& run : runs )
+	{
+		if( !mcfp.Seek( run.offset ) || mcfp.Write( src, run.size ) != run.size )
+			failed = true;
+		src += run.size;
+	}
+
+	mcfp.Flush();
+#ifdef _WIN32
+	_commit( _fileno( mcfp.fp() ) );
+#else
+	fsync( fileno( mcfp.fp() ) );
+#endif
+
+	if( failed )
+		Console.Error( L"(FileMcd) Failed to write memory card: " + mcfp.GetName() );
+}
+
+void FileMemoryCard::StopFlusher()
+{
+	m_flusher = nullptr;
+}
+
+void FileMemoryCard::NextFrame( uint slot )
+{
+	if( m_framesUntilFlush[slot] > 0 && --m_framesUntilFlush[slot] == 0 )
+	{
+		{
+			ScopedLock lock( m_lock );
+			m_flushRequested[slot] = true;
+		}
+
+		if( !m_flusher )
+		{
+			m_flusher = std::unique_ptr<Flusher>( new Flusher( *this ) );
+			m_flusher->Start();
+		}
+		m_flusher->Post();
+	}
 }
 
 // returns FALSE if an error occurred (either permission denied or disk full)
@@ -294,7 +607,7 @@ void FileMemoryCard::GetSizeInfo( uint slot, PS2E_McdSizeInfo& outways )
 	outways.Xor						= 18;  // 0x12, XOR 02 00 00 10
 
 	if( pxAssert( m_file[slot].IsOpened() ) )
-		outways.McdSizeInSectors	= m_file[slot].Length() / (outways.SectorSize + outways.EraseBlockSizeInSectors);
+		outways.McdSizeInSectors	= m_image[slot].size() / (outways.SectorSize + outways.EraseBlockSizeInSectors);
 	else
 		outways.McdSizeInSectors	= 0x4000;
 
@@ -316,8 +629,9 @@ s32 FileMemoryCard::Read( uint slot, u8 *dest, u32 adr, int size )
 		memset(dest, 0, size);
 		return 1;
 	}
-	if( !Seek(mcfp, adr) ) return 0;
-	return mcfp.Read( dest, size ) != 0;
+	if( !InRange(slot, adr, size) ) return 0;
+	memcpy( dest, &m_image[slot][m_offset[slot] + adr], size );
+	return 1;
 }
 
 s32 FileMemoryCard::Save( uint slot, const u8 *src, u32 adr, int size )
@@ -330,6 +644,8 @@ s32 FileMemoryCard::Save( uint slot, const u8 *src, u32 adr, int size )
 		return 1;
 	}
 
+	if( !InRange(slot, adr, size) ) return 0;
+
 	if(m_ispsx[slot])
 	{
 		m_currentdata.MakeRoomFor( size );
@@ -337,9 +653,8 @@ s32 FileMemoryCard::Save( uint slot, const u8 *src, u32 adr, int size )
 	}
 	else
 	{
-		if( !Seek(mcfp, adr) ) return 0;
 		m_currentdata.MakeRoomFor( size );
-		mcfp.Read( m_currentdata.GetPtr(), size);
+		memcpy( m_currentdata.GetPtr(), &m_image[slot][m_offset[slot] + adr], size );
 		
 
 		for (int i=0; i<size; i++)
@@ -362,24 +677,18 @@ s32 FileMemoryCard::Save( uint slot, const u8 *src, u32 adr, int size )
 		}
 	}
 
-	if( !Seek(mcfp, adr) ) return 0;
-
-	int status = mcfp.Write( m_currentdata.GetPtr(), size );
+	WriteImage( slot, m_offset[slot] + adr, m_currentdata.GetPtr(), size );
 
-	if( status ) {
-		static auto last = std::chrono::time_point<std::chrono::system_clock>();
+	static auto last = std::chrono::time_point<std::chrono::system_clock>();
 
-		std::chrono::duration<float> elapsed = std::chrono::system_clock::now() - last;
-		if(elapsed > std::chrono::seconds(5)) {
-			wxString name, ext;
-			wxFileName::SplitPath(m_file[slot].GetName(), NULL, NULL, &name, &ext);
-			OSDlog( Color_StrongYellow, false, "Memory Card %s written.", (const char *)(name + "." + ext).c_str() );
-			last = std::chrono::system_clock::now();
-		}
-		return 1;
+	std::chrono::duration<float> elapsed = std::chrono::system_clock::now() - last;
+	if(elapsed > std::chrono::seconds(5)) {
+		wxString name, ext;
+		wxFileName::SplitPath(m_file[slot].GetName(), NULL, NULL, &name, &ext);
+		OSDlog( Color_StrongYellow, false, "Memory Card %s written.", (const char *)(name + "." + ext).c_str() );
+		last = std::chrono::system_clock::now();
 	}
-
-	return 0;
+	return 1;
 }
 
 s32 FileMemoryCard::EraseBlock( uint slot, u32 adr )
@@ -392,8 +701,9 @@ s32 FileMemoryCard::EraseBlock( uint slot, u32 adr )
 		return 1;
 	}
 
-	if( !Seek(mcfp, adr) ) return 0;
-	return mcfp.Write( m_effeffs, sizeof(m_effeffs) ) != 0;
+	if( !InRange(slot, adr, sizeof(m_effeffs)) ) return 0;
+	WriteImage( slot, m_offset[slot] + adr, m_effeffs, sizeof(m_effeffs) );
+	return 1;
 }
 
 u64 FileMemoryCard::GetCRC( uint slot )
@@ -401,30 +711,8 @@ u64 FileMemoryCard::GetCRC( uint slot )
 	wxFFile& mcfp( m_file[slot] );
 	if( !mcfp.IsOpened() ) return 0;
 
-	u64 retval = 0;
-
-	if(m_ispsx[slot])
-	{
-		if( !Seek( mcfp, 0 ) ) return 0;
-
-		// Process the file in 4k chunks.  Speeds things up significantly.
-	
-		u64 buffer[528*8];		// use 528 (sector size), ensures even divisibility
-	
-		const uint filesize = mcfp.Length() / sizeof(buffer);
-		for( uint i=filesize; i; --i )
-		{
-			mcfp.Read( &buffer, sizeof(buffer) );
-			for( uint t=0; t<ArraySize(buffer); ++t )
-				retval ^= buffer[t];
-		}
-	}
-	else
-	{
-		retval = m_chksum[slot];
-	}
-
-	return retval;
+	// PSX cards: the xor of all the words of the card, updated on every write.
+	return m_ispsx[slot] ? m_crc[slot] : m_chksum[slot];
 }
 
 // --------------------------------------------------------------------------------------
@@ -572,9 +860,9 @@ static u64 PS2E_CALLBACK FileMcd_GetCRC( PS2E_THISPTR thisptr, uint port, uint s
 static void PS2E_CALLBACK FileMcd_NextFrame( PS2E_THISPTR thisptr, uint port, uint slot ) {
 	const uint combinedSlot = FileMcd_ConvertToSlot( port, slot );
 	switch ( g_Conf->Mcd[combinedSlot].Type ) {
-	//case MemoryCardType::MemoryCard_File:
-	//	thisptr->impl.NextFrame( combinedSlot );
-	//	break;
+	case MemoryCardType::MemoryCard_File:
+		thisptr->impl.NextFrame( combinedSlot );
+		break;
 	case MemoryCardType::MemoryCard_Folder:
 		thisptr->implFolder.NextFrame( combinedSlot );
 		break;
@@ -24,13 +24,83 @@
 
 #include "svnrev.h"
 
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Threading;
+
 bool RemoveDirectory( const wxString& dirname );
 
+void MemoryCardPageCache::Resize( const u32 pageCount ) {
+	if ( pageCount > m_index.size() ) {
+		m_index.resize( pageCount, 0 );
+	}
+}
+
+void MemoryCardPageCache::Clear() {
+	for ( auto it = m_entries.cbegin(); it != m_entries.cend(); ++it ) {
+		m_index[it->page] = 0;
+	}
+	m_entries.clear();
+}
+
+MemoryCardPage* MemoryCardPageCache::Find( const u32 page ) {
+	if ( page >= m_index.size() || m_index[page] == 0 ) { return nullptr; }
+	return &m_entries[m_index[page] - 1].data;
+}
+
+const MemoryCardPage* MemoryCardPageCache::FindOld( const u32 page ) const {
+	if ( page >= m_index.size() || m_index[page] == 0 ) { return nullptr; }
+	return &m_entries[m_index[page] - 1].oldData;
+}
+
+MemoryCardPage* MemoryCardPageCache::Insert( const u32 page, const u8* data ) {
+	Resize( page + 1 );
+	pxAssert( m_index[page] == 0 );
+
+	m_entries.emplace_back();
+	Entry& entry = m_entries.back();
+	entry.page = page;
+	memcpy( &entry.data.raw[0], data, MemoryCardPage::PageSize );
+	memcpy( &entry.oldData.raw[0], data, MemoryCardPage::PageSize );
+	m_index[page] = (u32)m_entries.size();
+
+	return &entry.data;
+}
+
+void MemoryCardPageCache::Erase( const u32 page ) {
+	if ( page >= m_index.size() || m_index[page] == 0 ) { return; }
+
+	// move the last entry into the hole, so the entries stay packed
+	const u32 slot = m_index[page] - 1;
+	m_index[page] = 0;
+	if ( slot != m_entries.size() - 1 ) {
+		m_entries[slot] = m_entries.back();
+		m_index[m_entries[slot].page] = slot + 1;
+	}
+	m_entries.pop_back();
+}
+
+void MemoryCardPageCache::GetPages( std::vector<u32>* pages ) const {
+	pages->clear();
+	pages->reserve( m_entries.size() );
+	for ( auto it = m_entries.cbegin(); it != m_entries.cend(); ++it ) {
+		pages->push_back( it->page );
+	}
+	std::sort( pages->begin(), pages->end() );
+}
+
 FolderMemoryCard::FolderMemoryCard() {
 	m_slot = 0;
 	m_isEnabled = false;
 	m_performFileWrites = false;
 	m_framesUntilFlush = 0;
+	m_flushRequested = false;
 	m_timeLastWritten = 0;
 	m_filteringEnabled = false;
 	m_filteringString = L"";
@@ -42,13 +112,13 @@ void FolderMemoryCard::InitializeInternalData() {
 	memset( &m_fat, 0xFF, sizeof( m_fat ) );
 	memset( &m_backupBlock1, 0xFF, sizeof( m_backupBlock1 ) );
 	memset( &m_backupBlock2, 0xFF, sizeof( m_backupBlock2 ) );
-	m_cache.clear();
-	m_oldDataCache.clear();
+	m_cache.Clear();
 	m_lastAccessedFile.CloseAll();
 	m_fileMetadataQuickAccess.clear();
 	m_timeLastWritten = 0;
 	m_isEnabled = false;
 	m_framesUntilFlush = 0;
+	m_flushRequested = false;
 	m_performFileWrites = true;
 	m_filteringEnabled = false;
 	m_filteringString = L"";
@@ -63,7 +133,17 @@ void FolderMemoryCard::Open( const bool enableFiltering, const wxString& filter
 	Open( g_Conf->FullpathToMcd( m_slot ), g_Conf->Mcd[m_slot], 0, enableFiltering, filter, false );
 }
 
+void FolderMemoryCard::Lock() {
+	m_lock.Acquire();
+}
+
+void FolderMemoryCard::Unlock() {
+	m_lock.Release();
+}
+
 void FolderMemoryCard::Open( const wxString& fullPath, const AppConfig::McdOptions& mcdOptions, const u32 sizeInClusters, const bool enableFiltering, const wxString& filter, bool simulateFileWrites ) {
+	ScopedLock lock( m_lock );
+
 	InitializeInternalData();
 	m_performFileWrites = !simulateFileWrites;
 
@@ -107,19 +187,23 @@ void FolderMemoryCard::Open( const wxString& fullPath, const AppConfig::McdOptio
 }
 
 void FolderMemoryCard::Close( bool flush ) {
+	ScopedLock lock( m_lock );
+
 	if ( !m_isEnabled ) { return; }
 
+	m_flushRequested = false;
 	if ( flush ) {
 		Flush();
 	}
 
-	m_cache.clear();
-	m_oldDataCache.clear();
+	m_cache.Clear();
 	m_lastAccessedFile.CloseAll();
 	m_fileMetadataQuickAccess.clear();
 }
 
 bool FolderMemoryCard::ReIndex( bool enableFiltering, const wxString& filter ) {
+	ScopedLock lock( m_lock );
+
 	if ( !m_isEnabled ) { return false; }
 
 	if ( m_filteringEnabled != enableFiltering || m_filteringString != filter ) {
@@ -148,6 +232,9 @@ void FolderMemoryCard::LoadMemoryCardData( const u32 sizeInClusters, const bool
 		FlushBlock( 0 );
 	}
 
+	m_cache.Resize( GetSizeInClusters() * 2 );
+	m_fileMetadataQuickAccess.assign( MaxFatClusters, MemoryCardFileMetadataReference() );
+
 	// if superblock was valid, load folders and files
 	if ( formatted ) {
 		if ( enableFiltering ) {
@@ -536,7 +623,14 @@ u32 FolderMemoryCard::CalculateRequiredClustersOfDirectory( const wxString& dirP
 	return requiredClusters + requiredFileEntryPages / 2 + ( requiredFileEntryPages % 2 == 0 ? 0 : 1 );
 }
 
+MemoryCardFileMetadataReference* FolderMemoryCard::FindMetadataQuickAccess( const u32 fatCluster ) {
+	if ( fatCluster >= m_fileMetadataQuickAccess.size() ) { return nullptr; }
+	MemoryCardFileMetadataReference* ref = &m_fileMetadataQuickAccess[fatCluster];
+	return ref->entry != nullptr ? ref : nullptr;
+}
+
 MemoryCardFileMetadataReference* FolderMemoryCard::AddDirEntryToMetadataQuickAccess( MemoryCardFileEntry* const entry, MemoryCardFileMetadataReference* const parent ) {
+	pxAssert( entry->entry.data.cluster < m_fileMetadataQuickAccess.size() );
 	MemoryCardFileMetadataReference* ref = &m_fileMetadataQuickAccess[entry->entry.data.cluster];
 	ref->parent = parent;
 	ref->entry = entry;
@@ -555,6 +649,7 @@ MemoryCardFileMetadataReference* FolderMemoryCard::AddFileEntryToMetadataQuickAc
 
 	u32 clusterNumber = 0;
 	do {
+		pxAssert( ( fileCluster & NextDataClusterMask ) < m_fileMetadataQuickAccess.size() );
 		MemoryCardFileMetadataReference* ref = &m_fileMetadataQuickAccess[fileCluster & NextDataClusterMask];
 		ref->parent = parent;
 		ref->entry = entry;
@@ -570,6 +665,8 @@ s32 FolderMemoryCard::IsPresent() const {
 }
 
 void FolderMemoryCard::GetSizeInfo( PS2E_McdSizeInfo& outways ) const {
+	ScopedLock lock( m_lock );
+
 	outways.SectorSize = PageSize;
 	outways.EraseBlockSizeInSectors = BlockSize / PageSize;
 	outways.McdSizeInSectors = GetSizeInClusters() * 2;
@@ -580,6 +677,8 @@ void FolderMemoryCard::GetSizeInfo( PS2E_McdSizeInfo& outways ) const {
 }
 
 bool FolderMemoryCard::IsPSX() const {
+	ScopedLock lock( m_lock );
+
 	return false;
 }
 
@@ -723,10 +822,10 @@ bool FolderMemoryCard::ReadFromFile( u8 *dest, u32 adr, u32 dataLength ) {
 	}
 
 	// figure out which file to read from
-	auto it = m_fileMetadataQuickAccess.find( fatCluster );
-	if ( it != m_fileMetadataQuickAccess.end() ) {
-		const u32 clusterNumber = it->second.consecutiveCluster;
-		wxFFile* file = m_lastAccessedFile.ReOpen( m_folderName, &it->second );
+	MemoryCardFileMetadataReference* ref = FindMetadataQuickAccess( fatCluster );
+	if ( ref != nullptr ) {
+		const u32 clusterNumber = ref->consecutiveCluster;
+		wxFFile* file = m_lastAccessedFile.ReOpen( m_folderName, ref );
 		if ( file->IsOpened() ) {
 			const u32 clusterOffset = ( page % 2 ) * PageSize + offset;
 			const u32 fileOffset = clusterNumber * ClusterSize + clusterOffset;
@@ -749,6 +848,8 @@ bool FolderMemoryCard::ReadFromFile( u8 *dest, u32 adr, u32 dataLength ) {
 }
 
 s32 FolderMemoryCard::Read( u8 *dest, u32 adr, int size ) {
+	ScopedLock lock( m_lock );
+
 	//const u32 block = adr / BlockSizeRaw;
 	const u32 page = adr / PageSizeRaw;
 	const u32 offset = adr % PageSizeRaw;
@@ -768,9 +869,9 @@ s32 FolderMemoryCard::Read( u8 *dest, u32 adr, int size ) {
 		const u32 dataLength = std::min( (u32)size, (u32)( PageSize - offset ) );
 
 		// if we have a cache for this page, just load from that
-		auto it = m_cache.find( page );
-		if ( it != m_cache.end() ) {
-			memcpy( dest, &it->second.raw[offset], dataLength );
+		const MemoryCardPage* cachePage = m_cache.Find( page );
+		if ( cachePage != nullptr ) {
+			memcpy( dest, &cachePage->raw[offset], dataLength );
 		} else {
 			ReadDataWithoutCache( dest, adr, dataLength );
 		}
@@ -813,6 +914,8 @@ void FolderMemoryCard::ReadDataWithoutCache( u8* const dest, const u32 adr, cons
 }
 
 s32 FolderMemoryCard::Save( const u8 *src, u32 adr, int size ) {
+	ScopedLock lock( m_lock );
+
 	//const u32 block = adr / BlockSizeRaw;
 	//const u32 cluster = adr / ClusterSizeRaw;
 	const u32 page = adr / PageSizeRaw;
@@ -832,15 +935,12 @@ s32 FolderMemoryCard::Save( const u8 *src, u32 adr, int size ) {
 		const u32 dataLength = std::min( (u32)size, PageSize - offset );
 
 		// if cache page has not yet been touched, fill it with the data from our memory card
-		auto it = m_cache.find( page );
-		MemoryCardPage* cachePage;
-		if ( it == m_cache.end() ) {
-			cachePage = &m_cache[page];
+		MemoryCardPage* cachePage = m_cache.Find( page );
+		if ( cachePage == nullptr ) {
+			u8 data[PageSize];
 			const u32 adrLoad = page * PageSizeRaw;
-			ReadDataWithoutCache( &cachePage->raw[0], adrLoad, PageSize );
-			memcpy( &m_oldDataCache[page].raw[0], &cachePage->raw[0], PageSize );
-		} else {
-			cachePage = &it->second;
+			ReadDataWithoutCache( data, adrLoad, PageSize );
+			cachePage = m_cache.Insert( page, data );
 		}
 
 		// then just write to the cache
@@ -852,14 +952,31 @@ s32 FolderMemoryCard::Save( const u8 *src, u32 adr, int size ) {
 	return 1;
 }
 
-void FolderMemoryCard::NextFrame() {
+bool FolderMemoryCard::NextFrame() {
+	// if the flusher thread is busy with this card, just count this frame again next time
+	ScopedTryLock lock( m_lock );
+	if ( lock.Failed() ) { return false; }
+
 	if ( m_framesUntilFlush > 0 && --m_framesUntilFlush == 0 ) {
+		m_flushRequested = true;
+		return true;
+	}
+
+	return false;
+}
+
+void FolderMemoryCard::FlushIfRequested() {
+	ScopedLock lock( m_lock );
+
+	// the card may have been closed (and flushed) since the request
+	if ( m_flushRequested ) {
+		m_flushRequested = false;
 		Flush();
 	}
 }
 
 void FolderMemoryCard::Flush() {
-	if ( m_cache.empty() ) { return; }
+	if ( m_cache.IsEmpty() ) { return; }
 
 	#ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 	WriteToFile( m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format( L"%Y-%m-%d-%H-%M-%S" ) + L"_pre-flush.ps2" );
@@ -914,13 +1031,11 @@ void FolderMemoryCard::Flush() {
 	FlushDeletedFilesAndRemoveUnchangedDataFromCache( oldFileEntryTree );
 
 	// and finally, flush everything that hasn't been flushed yet
-	for ( uint i = 0; i < pageCount; ++i ) {
-		FlushPage( i );
-	}
+	FlushRemainingPages( pageCount );
 
 	m_lastAccessedFile.FlushAll();
 	m_lastAccessedFile.ClearMetadataWriteState();
-	m_oldDataCache.clear();
+	m_cache.Clear();
 
 	const u64 timeFlushEnd = wxGetLocalTimeMillis().GetValue();
 	Console.WriteLn( L"(FolderMcd) Done! Took %u ms.", timeFlushEnd - timeFlushStart );
@@ -931,10 +1046,10 @@ void FolderMemoryCard::Flush() {
 }
 
 bool FolderMemoryCard::FlushPage( const u32 page ) {
-	auto it = m_cache.find( page );
-	if ( it != m_cache.end() ) {
-		WriteWithoutCache( &it->second.raw[0], page * PageSizeRaw, PageSize );
-		m_cache.erase( it );
+	const MemoryCardPage* cachePage = m_cache.Find( page );
+	if ( cachePage != nullptr ) {
+		WriteWithoutCache( &cachePage->raw[0], page * PageSizeRaw, PageSize );
+		m_cache.Erase( page );
 		return true;
 	}
 	return false;
@@ -957,6 +1072,67 @@ bool FolderMemoryCard::FlushBlock( const u32 block ) {
 	return flushed;
 }
 
+void FolderMemoryCard::FlushRemainingPages( const u32 pageCount ) {
+	struct FileWrite {
+		MemoryCardFileMetadataReference* ref;
+		u32 fileOffset;
+		u32 page;
+	};
+
+	std::vector<u32> pages;
+	m_cache.GetPages( &pages );
+
+	// system data goes straight to the internal data, file data is collected first
+	std::vector<FileWrite> writes;
+	for ( auto it = pages.cbegin(); it != pages.cend() && *it < pageCount; ++it ) {
+		const u32 page = *it;
+		const u32 adr = page * PageSizeRaw;
+		if ( GetSystemBlockPointer( adr ) != nullptr ) {
+			FlushPage( page );
+			continue;
+		}
+
+		const u32 fatCluster = adr / ClusterSizeRaw - m_superBlock.data.alloc_offset;
+		MemoryCardFileMetadataReference* ref = nullptr;
+		if ( ( m_fat.data[0][0][fatCluster] & DataClusterInUseMask ) != 0 ) {
+			ref = FindMetadataQuickAccess( fatCluster );
+		}
+
+		if ( ref == nullptr ) {
+			// unused cluster or no file; WriteWithoutCache() would have dropped this too
+			m_cache.Erase( page );
+			continue;
+		}
+
+		FileWrite write = { ref, ref->consecutiveCluster * ClusterSize + ( page % 2 ) * PageSize, page };
+		writes.push_back( write );
+	}
+
+	// write each host file front to back, merging pages that are contiguous in the file
+	std::sort( writes.begin(), writes.end(), []( const FileWrite& a, const FileWrite& b ) {
+		if ( a.ref->entry != b.ref->entry ) { return a.ref->entry < b.ref->entry; }
+		return a.fileOffset < b.fileOffset;
+	});
+
+	std::vector<u8> buffer;
+	for ( size_t i = 0; i < writes.size(); ) {
+		size_t end = i + 1;
+		while ( end < writes.size() && writes[end].ref->entry == writes[i].ref->entry
+		     && writes[end].fileOffset == writes[end - 1].fileOffset + PageSize ) {
+			++end;
+		}
+
+		buffer.resize( ( end - i ) * PageSize );
+		for ( size_t j = i; j < end; ++j ) {
+			memcpy( &buffer[( j - i ) * PageSize], &m_cache.Find( writes[j].page )->raw[0], PageSize );
+			m_cache.Erase( writes[j].page );
+		}
+
+		WriteToFile( writes[i].ref, writes[i].fileOffset, &buffer[0], buffer.size() );
+		i = end;
+	}
+}
+
 void FolderMemoryCard::FlushSuperBlock() {
 	if ( FlushBlock( 0 ) && m_performFileWrites ) {
 		wxFileName superBlockFileName( m_folderName.GetPath(), L"_pcsx2_superblock" );
@@ -1108,13 +1284,12 @@ void FolderMemoryCard::RemoveUnchangedDataFromCache( const MemoryCardFileEntry*
 	while ( cluster != LastDataCluster ) {
 		for ( int i = 0; i < 2; ++i ) {
 			const u32 page = ( cluster + alloc_offset ) * 2 + i;
-			auto newIt = m_cache.find( page );
-			if ( newIt == m_cache.end() ) { continue; }
-			auto oldIt = m_oldDataCache.find( page );
-			if ( oldIt == m_oldDataCache.end() ) { continue; }
+			const MemoryCardPage* newPage = m_cache.Find( page );
+			if ( newPage == nullptr ) { continue; }
+			const MemoryCardPage* oldPage = m_cache.FindOld( page );
 
-			if ( memcmp( &oldIt->second.raw[0], &newIt->second.raw[0], PageSize ) == 0 ) {
-				m_cache.erase( newIt );
+			if ( memcmp( &oldPage->raw[0], &newPage->raw[0], PageSize ) == 0 ) {
+				m_cache.Erase( page );
 			}
 		}
 
@@ -1170,46 +1345,47 @@ bool FolderMemoryCard::WriteToFile( const u8* src, u32 adr, u32 dataLength ) {
 	}
 
 	// figure out which file to write to
-	auto it = m_fileMetadataQuickAccess.find( fatCluster );
-	if ( it != m_fileMetadataQuickAccess.end() ) {
-		const MemoryCardFileEntry* const entry = it->second.entry;
-		const u32 clusterNumber = it->second.consecutiveCluster;
-		
-		if ( m_performFileWrites ) {
-			wxFFile* file = m_lastAccessedFile.ReOpen( m_folderName, &it->second, true );
-			if ( file->IsOpened() ) {
-				const u32 clusterOffset = ( page % 2 ) * PageSize + offset;
-				const u32 fileSize = entry->entry.data.length;
-				const u32 fileOffsetStart = std::min( clusterNumber * ClusterSize + clusterOffset, fileSize );
-				const u32 fileOffsetEnd = std::min( fileOffsetStart + dataLength, fileSize );
-				const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
-
-				wxFileOffset actualFileSize = file->Length();
-				if ( actualFileSize < fileOffsetStart ) {
-					file->Seek( actualFileSize );
-					const u32 diff = fileOffsetStart - actualFileSize;
-					u8 temp = 0xFF;
-					for ( u32 i = 0; i < diff; ++i ) {
-						file->Write( &temp, 1 );
-					}
-				}
+	MemoryCardFileMetadataReference* ref = FindMetadataQuickAccess( fatCluster );
+	if ( ref != nullptr ) {
+		const u32 clusterOffset = ( page % 2 ) * PageSize + offset;
+		return WriteToFile( ref, ref->consecutiveCluster * ClusterSize + clusterOffset, src, dataLength );
+	}
 
-				const wxFileOffset fileOffset = file->Tell();
-				if ( fileOffset != fileOffsetStart ) {
-					file->Seek( fileOffsetStart );
-				}
-				if ( bytesToWrite > 0 ) {
-					file->Write( src, bytesToWrite );
+	return false;
+}
+
+bool FolderMemoryCard::WriteToFile( MemoryCardFileMetadataReference* fileRef, const u32 fileOffset, const u8* src, const u32 dataLength ) {
+	if ( m_performFileWrites ) {
+		wxFFile* file = m_lastAccessedFile.ReOpen( m_folderName, fileRef, true );
+		if ( file->IsOpened() ) {
+			const u32 fileSize = fileRef->entry->entry.data.length;
+			const u32 fileOffsetStart = std::min( fileOffset, fileSize );
+			const u32 fileOffsetEnd = std::min( fileOffsetStart + dataLength, fileSize );
+			const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
+
+			wxFileOffset actualFileSize = file->Length();
+			if ( actualFileSize < fileOffsetStart ) {
+				file->Seek( actualFileSize );
+				const u32 diff = fileOffsetStart - actualFileSize;
+				u8 temp = 0xFF;
+				for ( u32 i = 0; i < diff; ++i ) {
+					file->Write( &temp, 1 );
 				}
-			} else {
-				return false;
 			}
-		}
 
-		return true;
+			const wxFileOffset currentOffset = file->Tell();
+			if ( currentOffset != fileOffsetStart ) {
+				file->Seek( fileOffsetStart );
+			}
+			if ( bytesToWrite > 0 ) {
+				file->Write( src, bytesToWrite );
+			}
+		} else {
+			return false;
+		}
 	}
 
-	return false;
+	return true;
 }
 
 void FolderMemoryCard::CopyEntryDictIntoTree( std::vector<MemoryCardFileEntryTreeNode>* fileEntryTree, const u32 cluster, const u32 fileCount ) {
@@ -1261,6 +1437,8 @@ const MemoryCardFileEntry* FolderMemoryCard::FindEquivalent( const MemoryCardFil
 }
 
 s32 FolderMemoryCard::EraseBlock( u32 adr ) {
+	ScopedLock lock( m_lock );
+
 	const u32 block = adr / BlockSizeRaw;
 
 	u8 eraseData[PageSize];
@@ -1275,6 +1453,8 @@ s32 FolderMemoryCard::EraseBlock( u32 adr ) {
 }
 
 u64 FolderMemoryCard::GetCRC() const {
+	ScopedLock lock( m_lock );
+
 	// Since this is just used as integrity check for savestate loading,
 	// give a timestamp of the last time the memory card was written to
 	return m_timeLastWritten;
@@ -1373,6 +1553,8 @@ void FolderMemoryCard::CalculateECC( u8* ecc, const u8* data ) {
 }
 
 void FolderMemoryCard::WriteToFile( const wxString& filename ) {
+	ScopedLock lock( m_lock );
+
 	wxFFile targetFile( filename, L"wb" );
 
 	u8 buffer[FolderMemoryCard::PageSizeRaw];
@@ -1530,7 +1712,15 @@ void FileAccessHelper::CloseAll() {
 
 void FileAccessHelper::FlushAll() {
 	for ( auto it = m_files.begin(); it != m_files.end(); ++it ) {
-		it->second.fileHandle->Flush();
+		wxFFile* file = it->second.fileHandle;
+		file->Flush();
+
+		// this runs once at the end of a flush, off the emulation thread, so make it stick
+		#ifdef _WIN32
+		_commit( _fileno( file->fp() ) );
+		#else
+		fsync( fileno( file->fp() ) );
+		#endif
 	}
 }
 
@@ -1609,12 +1799,55 @@ void MemoryCardFileMetadataReference::GetInternalPath( std::string* fileName ) c
 	}
 }
 
+// --------------------------------------------------------------------------------------
+//  FolderMemoryCardAggregator::Flusher
+// --------------------------------------------------------------------------------------
+FolderMemoryCardAggregator::Flusher::Flusher( FolderMemoryCardAggregator& parent )
+	: _parent( L"FolderMcd Flush" )
+	, m_parent( parent )
+	, m_quit( false ) {
+}
+
+FolderMemoryCardAggregator::Flusher::~Flusher() {
+	try {
+		Quit();
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+void FolderMemoryCardAggregator::Flusher::Quit() {
+	// Cancel() could stop the thread halfway through writing a file, so let it finish instead.
+	if ( !IsRunning() ) { return; }
+	m_quit = true;
+	m_sem.Post();
+	Block();
+}
+
+void FolderMemoryCardAggregator::Flusher::ExecuteTaskInThread() {
+	for (;;) {
+		m_sem.WaitWithoutYield();
+		if ( m_quit ) { return; }
+
+		for ( uint i = 0; i < TotalCardSlots; ++i ) {
+			m_parent.m_cards[i].FlushIfRequested();
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  FolderMemoryCardAggregator
+// --------------------------------------------------------------------------------------
 FolderMemoryCardAggregator::FolderMemoryCardAggregator() {
 	for ( uint i = 0; i < TotalCardSlots; ++i ) {
 		m_cards[i].SetSlot( i );
 	}
 }
 
+void FolderMemoryCardAggregator::StopFlusher() {
+	// the cards flush whatever is left when they're closed
+	m_flusher = nullptr;
+}
+
 void FolderMemoryCardAggregator::Open() {
 	for ( int i = 0; i < TotalCardSlots; ++i ) {
 		m_cards[i].Open( m_enableFiltering, m_lastKnownFilter );
@@ -1622,6 +1855,8 @@ void FolderMemoryCardAggregator::Open() {
 }
 
 void FolderMemoryCardAggregator::Close() {
+	StopFlusher();
+
 	for ( int i = 0; i < TotalCardSlots; ++i ) {
 		m_cards[i].Close();
 	}
@@ -1660,7 +1895,13 @@ u64 FolderMemoryCardAggregator::GetCRC( uint slot ) {
 }
 
 void FolderMemoryCardAggregator::NextFrame( uint slot ) {
-	m_cards[slot].NextFrame();
+	if ( m_cards[slot].NextFrame() ) {
+		if ( !m_flusher ) {
+			m_flusher = std::unique_ptr<Flusher>( new Flusher( *this ) );
+			m_flusher->Start();
+		}
+		m_flusher->Post();
+	}
 }
 
 bool FolderMemoryCardAggregator::ReIndex( uint slot, const bool enableFiltering, const wxString& filter ) {
@@ -19,10 +19,12 @@
 #include <wx/dir.h>
 #include <wx/ffile.h>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "PluginCallbacks.h"
 #include "AppConfig.h"
+#include "Utilities/PersistentThread.h"
 
 //#define DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 
@@ -179,6 +181,47 @@ struct MemoryCardPage {
 };
 #pragma pack(pop)
 
+// --------------------------------------------------------------------------------------
+//  MemoryCardPageCache
+// --------------------------------------------------------------------------------------
+// Modified pages of a memory card that haven't been flushed yet, along with how each of
+// them looked before the first write.  Lookups go through a flat table indexed by page
+// number; page data is only kept for the pages that were written to.
+class MemoryCardPageCache {
+public:
+	// Grows the lookup table to cover a card of pageCount pages, keeping the cached pages.
+	void Resize( const u32 pageCount );
+	void Clear();
+
+	bool IsEmpty() const { return m_entries.empty(); }
+
+	// returns the cached copy of the page, or nullptr if it isn't cached
+	// the pointer is valid until the next Insert() or Erase()
+	MemoryCardPage* Find( const u32 page );
+
+	// returns the contents of the page before it was first written to, or nullptr if it isn't cached
+	const MemoryCardPage* FindOld( const u32 page ) const;
+
+	// adds a page to the cache, with both its current and its old contents set to data
+	MemoryCardPage* Insert( const u32 page, const u8* data );
+
+	void Erase( const u32 page );
+
+	// fills pages with the numbers of all cached pages, in ascending order
+	void GetPages( std::vector<u32>* pages ) const;
+
+protected:
+	struct Entry {
+		u32 page;
+		MemoryCardPage data;
+		MemoryCardPage oldData;
+	};
+
+	// page number -> index in m_entries + 1, 0 if the page isn't cached
+	std::vector<u32> m_index;
+	std::vector<Entry> m_entries;
+};
+
 struct MemoryCardFileEntryTreeNode {
 	MemoryCardFileEntry entry;
 	std::vector<MemoryCardFileEntryTreeNode> subdir;
@@ -277,6 +320,9 @@ public:
 
 	static const int FramesAfterWriteUntilFlush = 2;
 
+	// number of clusters the FAT can describe, which bounds the size of any memory card
+	static const int MaxFatClusters = IndirectFatClusterCount * ( ClusterSize / 4 ) * ( ClusterSize / 4 );
+
 protected:
 	union superBlockUnion {
 		superblock data;
@@ -298,18 +344,24 @@ protected:
 
 	// stores directory and file metadata
 	std::map<u32, MemoryCardFileEntryCluster> m_fileEntryDict;
-	// quick-access map of related file entry metadata for each memory card FAT cluster that contains file data
-	std::map<u32, MemoryCardFileMetadataReference> m_fileMetadataQuickAccess;
+	// quick-access table of related file entry metadata for each memory card FAT cluster that contains file data,
+	// indexed by FAT cluster and sized to MaxFatClusters when the card is loaded, so references to it stay valid
+	// entries with a null entry pointer aren't in use
+	std::vector<MemoryCardFileMetadataReference> m_fileMetadataQuickAccess;
 
 	// holds a copy of modified pages of the memory card before they're flushed to the file system
-	std::map<u32, MemoryCardPage> m_cache;
-	// contains the state of how the data looked before the first write to it
+	// also keeps the state of how the data looked before the first write to it
 	// used to reduce the amount of disk I/O by not re-writing unchanged data that just happened to be
 	// touched in memory due to how actual physical memory cards have to erase and rewrite in blocks
-	std::map<u32, MemoryCardPage> m_oldDataCache;
+	MemoryCardPageCache m_cache;
 	// if > 0, the amount of frames until data is flushed to the file system
 	// reset to FramesAfterWriteUntilFlush on each write
 	int m_framesUntilFlush;
+	// set by NextFrame() when the flush is due, cleared once the flusher thread has done it
+	bool m_flushRequested;
+	// held by every public method, and by the flusher thread for the whole flush,
+	// so the flush always sees a consistent card and the game can't write into it halfway through
+	Threading::MutexRecursive m_lock;
 	// used to figure out if contents were changed for savestate-related purposes, see GetCRC()
 	u64 m_timeLastWritten;
 
@@ -369,7 +421,11 @@ public:
 	void SetSizeInMB( u32 megaBytes );
 
 	// called once per frame, used for flushing data after FramesAfterWriteUntilFlush frames of no writes
-	void NextFrame();
+	// returns true when the flush is due; the caller is expected to run FlushIfRequested() on its I/O thread
+	bool NextFrame();
+
+	// does the flush requested by NextFrame(), if any
+	void FlushIfRequested();
 
 	static void CalculateECC( u8* ecc, const u8* data );
 
@@ -432,6 +488,9 @@ protected:
 	// returns the total amount of data clusters available on the memory card, both used and unused
 	u32 GetAmountDataClusters() const;
 
+	// returns the quick-access reference of the given FAT cluster, or nullptr if it has none
+	MemoryCardFileMetadataReference* FindMetadataQuickAccess( const u32 fatCluster );
+
 	// returns the lowest unused data cluster, relative to alloc_offset in the superblock
 	// returns 0xFFFFFFFFu when the memory card is full
 	u32 GetFreeDataCluster() const;
@@ -481,6 +540,9 @@ protected:
 	bool ReadFromFile( u8 *dest, u32 adr, u32 dataLength );
 	bool WriteToFile( const u8* src, u32 adr, u32 dataLength );
 
+	// writes dataLength bytes at fileOffset of the host file fileRef belongs to, clipped to the file's length
+	bool WriteToFile( MemoryCardFileMetadataReference* fileRef, const u32 fileOffset, const u8* src, const u32 dataLength );
+
 
 	// flush the whole cache to the internal data and/or host file system
 	void Flush();
@@ -494,6 +556,10 @@ protected:
 	// flush a whole memory card block of the cache to the internal data and/or host file system
 	bool FlushBlock( const u32 block );
 
+	// flush all remaining pages below pageCount; file data is sorted by host file and offset,
+	// and contiguous pages of a file are written with a single write
+	void FlushRemainingPages( const u32 pageCount );
+
 	// flush the superblock to the internal data and/or host file system
 	void FlushSuperBlock();
 
@@ -546,9 +612,33 @@ protected:
 // Forwards the API's requests for specific memory card slots to the correct FolderMemoryCard.
 class FolderMemoryCardAggregator {
 protected:
+	// Writes the cards back to the file system off the emulation thread, once they went
+	// FramesAfterWriteUntilFlush frames without being accessed.
+	class Flusher : public Threading::pxThread {
+		typedef Threading::pxThread _parent;
+
+	public:
+		Flusher( FolderMemoryCardAggregator& parent );
+		virtual ~Flusher();
+
+		void Post() { m_sem.Post(); }
+
+		// finishes the flush in progress, if any, and exits the thread
+		void Quit();
+
+	protected:
+		void ExecuteTaskInThread();
+
+		FolderMemoryCardAggregator& m_parent;
+		Threading::Semaphore m_sem;
+		std::atomic<bool> m_quit;
+	};
+
 	static const int TotalCardSlots = 8;
 	FolderMemoryCard m_cards[TotalCardSlots];
 
+	std::unique_ptr<Flusher> m_flusher;
+
 	// stores the specifics of the current filtering settings, so they can be
 	// re-applied automatically when memory cards are reloaded
 	bool m_enableFiltering = true;
@@ -572,4 +662,7 @@ public:
 	u64  GetCRC( uint slot );
 	void NextFrame( uint slot );
 	bool ReIndex( uint slot, const bool enableFiltering, const wxString& filter );
+
+protected:
+	void StopFlusher();
 };
@@ -22,6 +22,7 @@
 
 #include "GS.h"
 #include "Elfheader.h"
+#include "RewindBuffer.h"
 
 // --------------------------------------------------------------------------------------
 //  Saveslot Section
@@ -119,6 +120,32 @@ void States_DefrostCurrentSlotBackup()
 	_States_DefrostCurrentSlot( true );
 }
 
+void States_Rewind()
+{
+	if( !SysHasValidState() )
+	{
+		Console.WriteLn( "Rewind: Aborting (VM is not active)." );
+		return;
+	}
+
+	if( IsSavingOrLoading )
+	{
+		Console.WriteLn( "Load or save action is already pending." );
+		return;
+	}
+
+	ScopedCoreThreadPause paused_core;
+
+	if( GetRewindBuffer().Rewind() )
+		OSDlog( Color_StrongGreen, true, "Rewound (%u snapshots left).", GetRewindBuffer().GetSnapshotCount() );
+	else if( !EmuConfig.EnableRewind )
+		OSDlog( Color_StrongGreen, true, "Rewind is disabled." );
+	else
+		OSDlog( Color_StrongGreen, true, "Nothing to rewind to." );
+
+	paused_core.AllowResume();
+}
+
 
 void States_registerLoadBackupMenuItem( wxMenuItem* loadBackupMenuItem )
 {
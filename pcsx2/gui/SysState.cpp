@@ -27,7 +27,9 @@
 #include "ConsoleLogger.h"
 
 #include <wx/wfstream.h>
+#include <wx/mstream.h>
 #include <memory>
+#include <zlib.h>
 
 #include "Patch.h"
 
@@ -463,11 +465,19 @@ protected:
 			gzfp->CloseEntry();
 		}
 
-		(*new VmStateCompressThread())
+		BaseCompressThread& compressor = (*new VmStateCompressThread())
 			.SetSource(elist.get())
 			.SetOutStream(out.get())
-			.SetFinishedPath(m_filename)
-			.Start();
+			.SetFinishedPath(m_filename);
+
+		switch (EmuConfig.SavestateCompression)
+		{
+			case SavestateCompressionMethod::Zlib:		compressor.SetBlockCompression(Z_DEFAULT_COMPRESSION); break;
+			case SavestateCompressionMethod::ZlibFast:	compressor.SetBlockCompression(Z_BEST_SPEED); break;
+			default: break;
+		}
+
+		compressor.Start();
 
 		// No errors?  Release cleanup handlers:
 		elist.release();
@@ -479,6 +489,32 @@ protected:
 	}
 };
 
+// Entries written by the BlockCompressor are stored in the zip, and have to be unpacked
+// before they can be read.  Returns a stream over the unpacked data for those (and for any
+// other stored entry, since it had to be read to be checked), or NULL for deflated entries,
+// which are read straight from the zip stream.
+static pxInputStream* OpenPackedEntry( pxInputStream& reader, const wxZipEntry& entry, std::vector<u8>& unpacked )
+{
+	if (entry.GetMethod() != wxZIP_METHOD_STORE) return NULL;
+
+	std::vector<u8> packed( entry.GetSize() );
+	reader.Read( packed.data(), packed.size() );
+
+	s64 rawSize = BlockCompressor::GetRawSize( packed.data(), packed.size() );
+	if (rawSize < 0)
+		unpacked.swap( packed );
+	else
+	{
+		unpacked.resize( rawSize );
+		if (!BlockCompressor::Decompress( unpacked.data(), unpacked.size(), packed.data(), packed.size() ))
+			throw Exception::SaveStateLoadError( reader.GetStreamName() )
+				.SetDiagMsg( pxsFmt(L"Savestate entry '%s' is corrupted.", WX_STR(entry.GetName())) )
+				.SetUserMsg(_("This savestate cannot be loaded because it is corrupted.  See the log file for details."));
+	}
+
+	return new pxInputStream( entry.GetName(), new wxMemoryInputStream( unpacked.data(), unpacked.size() ) );
+}
+
 // --------------------------------------------------------------------------------------
 //  SysExecEvent_UnzipFromDisk
 // --------------------------------------------------------------------------------------
@@ -508,6 +544,8 @@ protected:
 	{
 		ScopedLock lock( mtx_CompressToDisk );
 
+		u64 startTicks = GetCPUTicks();
+
 		// Ugh.  Exception handling made crappy because wxWidgets classes don't support scoped pointers yet.
 
 		std::unique_ptr<wxFFileInputStream> woot(new wxFFileInputStream(m_filename));
@@ -616,18 +654,28 @@ protected:
 			Threading::pxTestCancel();
 
 			gzreader->OpenEntry( *foundEntry[i] );
-			SavestateEntries[i]->FreezeIn( *reader );
+
+			std::vector<u8> unpacked;
+			std::unique_ptr<pxInputStream> unpackedReader( OpenPackedEntry( *reader, *foundEntry[i], unpacked ) );
+			SavestateEntries[i]->FreezeIn( unpackedReader ? *unpackedReader : *reader );
 		}
 
 		// Load all the internal data
 
 		gzreader->OpenEntry( *foundInternal );
 
-		VmStateBuffer buffer( foundInternal->GetSize(), L"StateBuffer_UnzipFromDisk" );		// start with an 8 meg buffer to avoid frequent reallocation.
-		reader->Read( buffer.GetPtr(), foundInternal->GetSize() );
+		std::vector<u8> unpacked;
+		std::unique_ptr<pxInputStream> unpackedReader( OpenPackedEntry( *reader, *foundInternal, unpacked ) );
+		uint internalSize = unpackedReader ? unpacked.size() : foundInternal->GetSize();
+
+		VmStateBuffer buffer( internalSize, L"StateBuffer_UnzipFromDisk" );		// start with an 8 meg buffer to avoid frequent reallocation.
+		(unpackedReader ? *unpackedReader : *reader).Read( buffer.GetPtr(), internalSize );
 
 		memLoadingState( buffer ).FreezeBios().FreezeInternals();
 		GetCoreThread().Resume();	// force resume regardless of emulation state earlier.
+
+		Console.WriteLn( "(UnzipFromDisk) Savestate loaded in %u ms.",
+			(u32)(((GetCPUTicks() - startTicks) * 1000) / GetTickFrequency()) );
 	}
 };
 
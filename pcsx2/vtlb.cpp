@@ -99,6 +99,9 @@ DataType __fastcall vtlb_memRead(u32 addr)
 	uptr vmv=vtlbdata.vmap[addr>>VTLB_PAGE_BITS];
 	sptr ppf=addr+vmv;
 
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(addr, ppf, sizeof(DataType), false))
+		return 0;
+
 	if (!(ppf<0))
 	{
 		if (!CHECK_EEREC) 
@@ -154,6 +157,12 @@ void __fastcall vtlb_memRead64(u32 mem, mem64_t *out)
 	uptr vmv=vtlbdata.vmap[mem>>VTLB_PAGE_BITS];
 	sptr ppf=mem+vmv;
 
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(mem, ppf, sizeof(mem64_t), false))
+	{
+		*out = 0;
+		return;
+	}
+
 	if (!(ppf<0))
 	{
 		if (!CHECK_EEREC) {
@@ -181,6 +190,12 @@ void __fastcall vtlb_memRead128(u32 mem, mem128_t *out)
 	uptr vmv=vtlbdata.vmap[mem>>VTLB_PAGE_BITS];
 	sptr ppf=mem+vmv;
 
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(mem, ppf, sizeof(mem128_t), false))
+	{
+		out->lo = out->hi = 0;
+		return;
+	}
+
 	if (!(ppf<0))
 	{
 		if (!CHECK_EEREC) 
@@ -213,6 +228,10 @@ void __fastcall vtlb_memWrite(u32 addr, DataType data)
 
 	uptr vmv=vtlbdata.vmap[addr>>VTLB_PAGE_BITS];
 	sptr ppf=addr+vmv;
+
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(addr, ppf, sizeof(DataType), true))
+		return;
+
 	if (!(ppf<0))
 	{		
 		if (!CHECK_EEREC) 
@@ -261,6 +280,10 @@ void __fastcall vtlb_memWrite64(u32 mem, const mem64_t* value)
 {
 	uptr vmv=vtlbdata.vmap[mem>>VTLB_PAGE_BITS];
 	sptr ppf=mem+vmv;
+
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(mem, ppf, sizeof(mem64_t), true))
+		return;
+
 	if (!(ppf<0))
 	{		
 		if (!CHECK_EEREC) 
@@ -289,6 +312,10 @@ void __fastcall vtlb_memWrite128(u32 mem, const mem128_t *value)
 {
 	uptr vmv=vtlbdata.vmap[mem>>VTLB_PAGE_BITS];
 	sptr ppf=mem+vmv;
+
+	if (vtlb_ShadowActive && !vtlb_ShadowAccess(mem, ppf, sizeof(mem128_t), true))
+		return;
+
 	if (!(ppf<0))
 	{
 		if (!CHECK_EEREC) 
@@ -661,6 +688,48 @@ __fi u32 vtlb_V2P(u32 vaddr)
 	return paddr;
 }
 
+// Updates vtlbdata.fastmem_limit after the virtual mappings of [start, start+size) changed.
+// The limit is the size of the run of pages from address 0 which map straight onto
+// eeMem->Main; anything else (TLB remaps, handlers, unmapped pages) ends the run, and the
+// recompiled code sends the accesses past it through the vmap as usual.
+//
+// Only the pages of the range are checked; the run is only followed further when the range
+// covers its end.  MapTLB maps a page at a time, so rescanning the whole run on each call
+// would make TLB refills slow.
+static void vtlb_UpdateFastmemLimit(u32 start, u32 size)
+{
+	if (start >= Ps2MemSize::MainRam || start > vtlbdata.fastmem_limit) return;
+
+	if (!eeMem)
+	{
+		vtlbdata.fastmem_limit = 0;
+		return;
+	}
+
+	const sptr main = (sptr)eeMem->Main;
+	const u32 end = start + std::min(size, Ps2MemSize::MainRam - start);
+	u32 limit = vtlbdata.fastmem_limit;
+
+	// Pages of the range within the run which don't map to main ram anymore end it.
+	for (u32 page = start; page < limit && page < end; page += VTLB_PAGE_SIZE)
+	{
+		if (vtlbdata.vmap[page>>VTLB_PAGE_BITS] != main)
+		{
+			limit = page;
+			break;
+		}
+	}
+
+	// The range covers the page after the run: it may extend it.
+	if (limit >= start && limit < end)
+	{
+		while (limit < Ps2MemSize::MainRam && vtlbdata.vmap[limit>>VTLB_PAGE_BITS] == main)
+			limit += VTLB_PAGE_SIZE;
+	}
+
+	vtlbdata.fastmem_limit = limit;
+}
+
 //virtual mappings
 //TODO: Add invalid paddr checks
 void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
@@ -669,6 +738,7 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 	verify(0==(paddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, length = size;
 	while (size > 0)
 	{
 		sptr pme;
@@ -696,6 +766,7 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 		paddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+	vtlb_UpdateFastmemLimit(start, length);
 }
 
 void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
@@ -703,6 +774,7 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, length = size;
 	uptr bu8 = (uptr)buffer;
 	while (size > 0)
 	{
@@ -711,6 +783,7 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 		bu8 += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+	vtlb_UpdateFastmemLimit(start, length);
 }
 
 void vtlb_VMapUnmap(u32 vaddr,u32 size)
@@ -718,6 +791,7 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 start = vaddr, length = size;
 	while (size > 0)
 	{
 		u32 handl = UnmappedVirtHandler0;
@@ -733,6 +807,7 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 		vaddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+	vtlb_UpdateFastmemLimit(start, length);
 }
 
 // vtlb_Init -- Clears vtlb handlers and memory mappings.
@@ -82,6 +82,13 @@ extern void __fastcall vtlb_memWrite(u32 mem, DataType value);
 extern void __fastcall vtlb_memWrite64(u32 mem, const mem64_t* value);
 extern void __fastcall vtlb_memWrite128(u32 mem, const mem128_t* value);
 
+// Set while the EE rec's shadow checks run a block through the interpreter.  Every access
+// of the memory functions above then goes through vtlb_ShadowAccess first, which journals
+// the writes and turns away what would have side effects (returns false: the access is
+// dropped, and reads return 0).  See iR5900Shadow.h.
+extern bool vtlb_ShadowActive;
+extern bool __fastcall vtlb_ShadowAccess(u32 addr, sptr ppf, uint size, bool write);
+
 extern void vtlb_DynGenWrite(u32 sz);
 extern void vtlb_DynGenRead32(u32 bits, bool sign);
 extern void vtlb_DynGenRead64(u32 sz);
@@ -204,10 +211,15 @@ namespace vtlb_private
 
 		u32* ppmap;               //4MB (allocated by vtlb_init) // PS2 virtual to PS2 physical
 
+		// Virtual addresses below this are mapped 1:1 onto eeMem->Main, so the recompiled
+		// loads and stores access them directly (see vtlb_UpdateFastmemLimit).
+		u32 fastmem_limit;
+
 		MapData()
 		{
 			vmap = NULL;
 			ppmap = NULL;
+			fastmem_limit = 0;
 		}
 	};
 
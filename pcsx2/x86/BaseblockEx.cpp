@@ -17,13 +17,73 @@
 #include "PrecompiledHeader.h"
 #include "BaseblockEx.h"
 
+// Starting size of the link table, in buckets (power of two).  Most games link a few
+// thousand block starts, so it rarely has to grow.
+static const u32 LinkTableInitialBits = 14;
+
+BaseBlockLinks::BaseBlockLinks()
+{
+	m_buckets.resize(1 << LinkTableInitialBits);
+	m_shift = 32 - LinkTableInitialBits;
+	Clear();
+}
+
+void BaseBlockLinks::Clear()
+{
+	const Bucket empty = { 0, -1 };
+	std::fill(m_buckets.begin(), m_buckets.end(), empty);
+	m_nodes.clear();
+	m_used = 0;
+}
+
+// Doubles the bucket count, keeping the node pool (and so the chains) as is.
+void BaseBlockLinks::Grow()
+{
+	std::vector<Bucket> old;
+	old.swap(m_buckets);
+
+	const Bucket empty = { 0, -1 };
+	m_buckets.assign(old.size() * 2, empty);
+	m_shift--;
+
+	const u32 mask = m_buckets.size() - 1;
+	for (const Bucket& b : old) {
+		if (b.head < 0) continue;
+
+		u32 i = Slot(b.pc);
+		while (m_buckets[i].head >= 0)
+			i = (i + 1) & mask;
+		m_buckets[i] = b;
+	}
+}
+
+void BaseBlockLinks::Insert(u32 pc, uptr jumpptr)
+{
+	// Keep the load under 1/2, so that probe sequences stay short.
+	if ((m_used + 1) * 2 > m_buckets.size())
+		Grow();
+
+	const u32 mask = m_buckets.size() - 1;
+	u32 i = Slot(pc);
+	while (m_buckets[i].head >= 0 && m_buckets[i].pc != pc)
+		i = (i + 1) & mask;
+
+	Bucket& b = m_buckets[i];
+	if (b.head < 0) {
+		b.pc = pc;
+		m_used++;
+	}
+
+	Node node = { jumpptr, b.head };
+	b.head = (s32)m_nodes.size();
+	m_nodes.push_back(node);
+}
+
 BASEBLOCKEX* BaseBlocks::New(u32 startpc, uptr fnptr)
 {
-	std::pair<linkiter_t, linkiter_t> range = links.equal_range(startpc);
-	for (linkiter_t i = range.first; i != range.second; ++i)
-		*(u32*)i->second = fnptr - (i->second + 4);
-	
-	return blocks.insert(startpc, fnptr);;
+	links.Patch(startpc, fnptr);
+
+	return blocks.insert(startpc, fnptr);
 }
 
 int BaseBlocks::LastIndex(u32 startpc) const
@@ -77,6 +137,6 @@ void BaseBlocks::Link(u32 pc, s32* jumpptr)
 		*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
 	else
 		*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
-	links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
+	links.Insert(pc, (uptr)jumpptr);
 }
 
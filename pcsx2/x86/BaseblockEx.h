@@ -15,7 +15,7 @@
 
 #pragma once
 
-#include <map>			// used by BaseBlockEx
+#include <vector>		// used by BaseBlockLinks
 
 // Every potential jump point in the PS2's addressable memory has a BASEBLOCK
 // associated with it. So that means a BASEBLOCK for every 4 bytes of PS2
@@ -140,13 +140,68 @@ public:
 	}
 };
 
+// Jumps which were linked to a block start, by startpc.  The pcs are kept in an open
+// addressed table (linear probing), each pointing to a chain of jumps in a flat node pool,
+// so that linking and invalidating don't allocate once the table has grown, and a lookup
+// is usually a single cache line.  Links are only ever dropped all at once by Clear().
+class BaseBlockLinks
+{
+	struct Bucket {
+		u32 pc;
+		s32 head;		// First node of the chain, -1 if the bucket is empty
+	};
+
+	struct Node {
+		uptr jumpptr;
+		s32  next;		// Next node for the same pc, -1 at the end of the chain
+	};
+
+	std::vector<Bucket> m_buckets;
+	std::vector<Node> m_nodes;
+	u32 m_used;			// Number of non-empty buckets
+	u32 m_shift;		// 32 - log2(bucket count)
+
+	__fi u32 Slot(u32 pc) const
+	{
+		// pcs are word aligned; Fibonacci hashing spreads the consecutive ones.
+		return ((pc >> 2) * 0x9E3779B1u) >> m_shift;
+	}
+
+	__fi const Bucket* Find(u32 pc) const
+	{
+		const u32 mask = m_buckets.size() - 1;
+		for (u32 i = Slot(pc); ; i = (i + 1) & mask) {
+			const Bucket& b = m_buckets[i];
+			if (b.head < 0)  return NULL;
+			if (b.pc == pc)  return &b;
+		}
+	}
+
+	void Grow();
+
+public:
+	BaseBlockLinks();
+
+	void Insert(u32 pc, uptr jumpptr);
+	void Clear();
+
+	// Points all the jumps linked to pc at target.
+	__fi void Patch(u32 pc, uptr target) const
+	{
+		const Bucket* b = Find(pc);
+		if (!b) return;
+
+		for (s32 n = b->head; n >= 0; n = m_nodes[n].next) {
+			uptr jumpptr = m_nodes[n].jumpptr;
+			*(u32*)jumpptr = target - (jumpptr + 4);
+		}
+	}
+};
+
 class BaseBlocks
 {
 protected:
-	typedef std::multimap<u32, uptr>::iterator linkiter_t;
-
-	// switch to a hash map later?
-	std::multimap<u32, uptr> links;
+	BaseBlockLinks links;
 	uptr recompiler;
 	BaseBlockArray blocks;
 
@@ -197,10 +252,7 @@ public:
 		do{
 			pxAssert(idx <= last);
 
-			//u32 startpc = blocks[idx].startpc;
-			std::pair<linkiter_t, linkiter_t> range = links.equal_range(blocks[idx].startpc);
-			for (linkiter_t i = range.first; i != range.second; ++i)
-				*(u32*)i->second = recompiler - (i->second + 4);
+			links.Patch(blocks[idx].startpc, recompiler);
 
 			if( IsDevBuild )
 			{
@@ -224,7 +276,7 @@ public:
 	__fi void Reset()
 	{
 		blocks.clear();
-		links.clear();
+		links.Clear();
 	}
 };
 
@@ -37,6 +37,7 @@
 #include "AppConfig.h"
 
 #include "Utilities/Perf.h"
+#include "BlockProfiler.h"
 
 using namespace x86Emitter;
 
@@ -642,11 +643,21 @@ static void recReserveCache()
 	recMem->ThrowIfNotOk();
 }
 
+// Host code size of the block starting at pc, for the block profiler.
+static u32 recBlockSize(u32 pc)
+{
+	const u32 hwpc = HWADDR(pc);
+	BASEBLOCKEX* block = recBlocks.Get(hwpc);
+	return (block && block->startpc == hwpc) ? block->x86size : 0;
+}
+
 static void recReserve()
 {
 	// IOP has no hardware requirements!
 
 	recReserveCache();
+
+	GetBlockProfiler().SetBlockSizeLookup(BlockProfiler::Cpu_IOP, recBlockSize);
 }
 
 static void recAlloc()
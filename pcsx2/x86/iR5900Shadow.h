@@ -0,0 +1,65 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  EE rec shadow checks  (EmuConfig.Cpu.Recompiler.ShadowCheckEE)
+// --------------------------------------------------------------------------------------
+// Lockstep differential testing of the EE recompiler against the interpreter.  Every rec'd
+// block starts with a call to recShadowBlock, which:
+//
+//  1. Checks the block which ran before it, if any (see below).
+//  2. Saves cpuRegs, fpuRegs (and VU0, for blocks with COP2 code), and runs the block in
+//     the interpreter.  Its memory accesses go through vtlb_ShadowAccess, which journals
+//     the writes.
+//  3. Puts the registers and memory back the way they were, keeping what the interpreter
+//     came up with, and returns to the rec'd code, which runs the block for real.
+//
+// Once the block is done (the next block starts, or an event test or a compile comes up),
+// the registers and the memory the interpreter wrote are compared with what the rec did.
+// The first time a block disagrees, it's reported on the console with its disassembly and
+// the registers which differ; the VM keeps running with the rec's results.
+//
+// Blocks are only checked when running them twice is harmless:
+//  * no COP0, SYSCALL, BREAK or CACHE (TLB, interrupts, BIOS calls...);
+//  * no COP2 code which starts or resets a VU, and no COP2 code at all while VU0 is running
+//    a micro program;
+//  * the interpreter didn't touch anything but memory (hardware registers and unmapped
+//    pages are handled by the VM; that's seen as it goes, and the run is dropped).
+//
+// Cycle counts aren't compared, nor are the registers the recs update lazily or differently
+// by design (COP0 Count, FPU and VU flags other than the FPU condition, Q and P).  The rec'd
+// FPU clamps where the interpreter doesn't, so FPU differences are to be expected with some
+// games; see the clamping options.
+//
+// Slow: for debugging the recs only.  Changing the option resets the recs, so that the blocks
+// get recompiled with or without the call.
+
+// Flags recShadowScanBlock adds to the block end.
+static const u32 ShadowBlock_COP2 = 1;
+
+// Finds whether the block [startpc, endpc) can be checked, when it's recompiled.  Returns
+// what recShadowBlock is to be called with: endpc along with ShadowBlock_* flags, or 0.
+extern u32 recShadowScanBlock( u32 startpc, u32 endpc );
+
+// Called from rec'd code at the start of every block.
+extern void __fastcall recShadowBlock( u32 startpc, u32 block );
+
+// Checks the block which ran last, before anything else gets to change cpuRegs.
+extern void recShadowBlockEnd();
+
+// Drops the check of the block which ran last (rec reset).
+extern void recShadowReset();
@@ -33,7 +33,10 @@
 #include "Elfheader.h"
 
 #include "../DebugTools/Breakpoints.h"
+#include "../DebugTools/SymbolMap.h"
 #include "Patch.h"
+#include "BlockProfiler.h"
+#include "iR5900Shadow.h"
 
 #if !PCSX2_SEH
 #	include <csetjmp>
@@ -43,6 +46,8 @@
 #include "Utilities/MemsetFast.inl"
 #include "Utilities/Perf.h"
 
+#include <unordered_map>
+
 
 using namespace x86Emitter;
 using namespace R5900;
@@ -96,6 +101,11 @@ u32 s_nEndBlock = 0; // what pc the current block ends
 u32 s_branchTo;
 static bool s_nBlockFF;
 
+// Times a block runs through the interpreter before it's recompiled (EnableEETiering),
+// and how often the blocks which weren't recompiled yet ran, by physical address.
+static const u8 ColdBlockRuns = 2;
+static std::unordered_map<u32, u8> s_coldBlockRuns;
+
 // save states for branches
 GPR_reg64 s_saveConstRegs[32];
 static u32 s_saveHasConstReg = 0, s_saveFlushedConstReg = 0;
@@ -315,6 +325,7 @@ void recCall( void (*func)() )
 // =====================================================================================================
 
 static void __fastcall recRecompile( const u32 startpc );
+static void __fastcall recRecompileOrInterpret( const u32 startpc );
 static void __fastcall dyna_block_discard(u32 start,u32 sz);
 static void __fastcall dyna_page_reset(u32 start,u32 sz);
 
@@ -334,6 +345,7 @@ static DynGenFunc* DispatchPageReset    = NULL;
 
 static void recEventTest()
 {
+	recShadowBlockEnd();
 	_cpuEventTest_Shared();
 }
 
@@ -345,8 +357,10 @@ static DynGenFunc* _DynGen_JITCompile()
 
 	u8* retval = xGetAlignedCallTarget();
 
-	xFastCall((void*)recRecompile, ptr[&cpuRegs.pc] );
+	xFastCall((void*)recRecompileOrInterpret, ptr[&cpuRegs.pc] );
 
+	// Dispatch to the block which was just compiled, or to the next one if it ran in the
+	// interpreter instead.
 	xMOV( eax, ptr[&cpuRegs.pc] );
 	xMOV( ebx, eax );
 	xSHR( eax, 16 );
@@ -489,6 +503,29 @@ static void recReserveCache()
 	recMem->ThrowIfNotOk();
 }
 
+// Names EE blocks in the perf jitdump after the function they belong to.  Blocks are
+// mapped by physical address, which matches the symbols for the usual kuseg/kseg0 code.
+static std::string recGuestSymbol(u32 pc)
+{
+	const u32 start = symbolMap.GetFunctionStart(pc);
+	if (start == SymbolMap::INVALID_ADDRESS) return std::string();
+
+	const std::string name = symbolMap.GetLabelString(start);
+	if (name.empty() || start == pc) return name;
+
+	char offset[16];
+	snprintf(offset, sizeof(offset), "+0x%x", pc - start);
+	return name + offset;
+}
+
+// Host code size of the block starting at pc, for the block profiler.
+static u32 recBlockSize(u32 pc)
+{
+	const u32 hwpc = HWADDR(pc);
+	BASEBLOCKEX* block = recBlocks.Get(hwpc);
+	return (block && block->startpc == hwpc) ? block->x86size : 0;
+}
+
 static void recReserve()
 {
 	// Hardware Requirements Check...
@@ -497,6 +534,9 @@ static void recReserve()
 		recThrowHardwareDeficiency( L"SSE2" );
 
 	recReserveCache();
+
+	Perf::ee.set_symbol_lookup(recGuestSymbol);
+	GetBlockProfiler().SetBlockSizeLookup(BlockProfiler::Cpu_EE, recBlockSize);
 }
 
 static void recAlloc()
@@ -601,6 +641,8 @@ static void recResetRaw()
 
 	recBlocks.Reset();
 	mmap_ResetBlockTracking();
+	s_coldBlockRuns.clear();
+	recShadowReset();
 
 	x86SetPtr(*recMem);
 
@@ -1610,6 +1652,96 @@ void doPlace0Patches()
     ApplyLoadedPatches(PPT_ONCE_ON_LOAD);
 }
 
+// Finds the end of the block at startpc the same way recRecompile does, or returns 0 if
+// the block has to be recompiled right away.  That's the case for:
+//  * FPU and COP2 code: the interpreters don't clamp or handle flags like the recs do, and
+//    mixing both on the same registers could change results.
+//  * breakpoints and memchecks, which only the rec'd code checks for.
+//  * the addresses recRecompile hooks (EELOAD, elf entry point, Goemon TLB hack).
+static u32 recInterpretableBlockEnd( u32 startpc )
+{
+	if (HWADDR(startpc) == EELOAD_START || (eeloadMain && HWADDR(startpc) == HWADDR(eeloadMain))
+		|| (g_GameLoading && HWADDR(startpc) == ElfEntry)
+		|| EmuConfig.Gamefixes.GoemonTlbHack || EmuConfig.Cpu.Recompiler.PreBlockCheckEE)
+		return 0;
+
+	for (u32 i = startpc; ; i += 4)
+	{
+		if (isBreakpointNeeded(i) != 0 || isMemcheckNeeded(i) != 0)
+			return 0;
+
+		// breaks blocks at 4k page boundaries
+		if (i != startpc && (i & 0xffc) == 0x0)
+			return i;
+
+		const u32* ptr = (const u32*)PSM(i);
+		if (!ptr) return 0;
+
+		const u32 code  = *ptr;
+		const u32 rs    = (code >> 21) & 0x1f;
+		const u32 rt    = (code >> 16) & 0x1f;
+		const u32 funct = code & 0x3f;
+
+		switch (code >> 26)
+		{
+			case 0: // special
+				if (funct == 8 || funct == 9) return i + 8; // JR, JALR
+				break;
+
+			case 1: // regimm
+				if (rt < 4 || (rt >= 16 && rt < 20)) return i + 8;
+				break;
+
+			case 2: case 3: // J, JAL
+			case 4: case 5: case 6: case 7:
+			case 20: case 21: case 22: case 23:
+				return i + 8;
+
+			case 16: // cp0
+				if (rs == 16 && funct == 24) return i + 4; // eret
+				if (rs == 8) return i + 8; // BC0x
+				break;
+
+			case 17: case 18:	// cp1, cp2
+			case 49: case 57:	// LWC1, SWC1
+			case 54: case 62:	// LQC2, SQC2
+				return 0;
+		}
+	}
+}
+
+// Called by JITCompile for blocks which don't have any code yet.  With EnableEETiering,
+// a block runs through the interpreter the first few times it's reached, and only gets
+// recompiled once it's seen again after that.  Code which runs once (boot, loading and
+// init code, most of what streaming games pull in) then costs an interpreted run
+// instead of a compile, and the rec cache is kept for the code which matters.
+static void __fastcall recRecompileOrInterpret( const u32 startpc )
+{
+	recShadowBlockEnd();
+
+	if (EmuConfig.Cpu.Recompiler.EnableEETiering)
+	{
+		const u32 addr = HWADDR(startpc);
+		auto it = s_coldBlockRuns.find(addr);
+		u8 runs = (it != s_coldBlockRuns.end()) ? it->second : 0;
+
+		if (runs < ColdBlockRuns)
+		{
+			if (u32 endpc = recInterpretableBlockEnd(startpc))
+			{
+				s_coldBlockRuns[addr] = runs + 1;
+				intExecuteBlock(endpc);
+				return;
+			}
+		}
+
+		if (it != s_coldBlockRuns.end())
+			s_coldBlockRuns.erase(it);
+	}
+
+	recRecompile(startpc);
+}
+
 static void __fastcall recRecompile( const u32 startpc )
 {
 	u32 i = 0;
@@ -1999,6 +2131,10 @@ StartRecomp:
 	bool doRecompilation = !skipMPEG_By_Pattern(startpc);
 
 	if (doRecompilation) {
+		// Lockstep checks against the interpreter, see iR5900Shadow.h
+		if (EmuConfig.Cpu.Recompiler.ShadowCheckEE)
+			xFastCall((void*)recShadowBlock, startpc, recShadowScanBlock(startpc, s_nEndBlock));
+
 		// Finally: Generate x86 recompiled code!
 		g_pCurInstInfo = s_pInstCache;
 		while (!g_branch && pc < s_nEndBlock) {
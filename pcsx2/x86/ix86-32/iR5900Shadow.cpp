@@ -0,0 +1,348 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "Memory.h"
+#include "VUmicro.h"
+#include "vtlb.h"
+#include "iR5900Shadow.h"
+#include "DebugTools/Debug.h"
+
+#include <unordered_set>
+
+using namespace R5900;
+
+// Blocks reported in full; after that, divergences are only counted.
+static const uint MaxReports = 8;
+
+// Memory writes listed for a block, at most.
+static const uint MaxMemoryDiffs = 16;
+
+// FCR31 condition bit, the only FPU flag the rec keeps exact.
+static const u32 FpuConditionFlag = 0x00800000;
+
+struct ShadowWrite
+{
+	u32		addr;
+	u8*		ptr;
+	uint	size;
+	u128	before;		// memory before the interpreter wrote it
+	u128	after;		// what the interpreter left there
+};
+
+struct ShadowRegs
+{
+	cpuRegisters	cpu;
+	fpuRegisters	fpu;
+	VURegs			vu0;
+};
+
+bool vtlb_ShadowActive = false;
+
+static __aligned16 ShadowRegs s_before;		// when the block started
+static __aligned16 ShadowRegs s_interp;		// after the interpreter ran it
+
+static std::vector<ShadowWrite> s_writes;
+static bool s_touchedHardware = false;
+
+// Block the rec is running, compared once it's done (s_pendingBlock is 0 when there's none)
+static u32 s_pendingStart = 0;
+static u32 s_pendingBlock = 0;
+
+static u32 s_checked = 0;
+static u32 s_skipped = 0;
+static u32 s_diverged = 0;
+static std::unordered_set<u32> s_reported;
+
+bool __fastcall vtlb_ShadowAccess( u32 addr, sptr ppf, uint size, bool write )
+{
+	if (ppf < 0)
+	{
+		// Handlers: hardware registers, TLB misses, bus errors...
+		s_touchedHardware = true;
+		return false;
+	}
+
+	if (write)
+	{
+		ShadowWrite w;
+		w.addr = addr;
+		w.ptr = (u8*)ppf;
+		w.size = size;
+		w.before = w.after = u128::From64(0);
+		memcpy(&w.before, w.ptr, size);
+		s_writes.push_back(w);
+	}
+
+	return true;
+}
+
+u32 recShadowScanBlock( u32 startpc, u32 endpc )
+{
+	u32 flags = 0;
+
+	for (u32 i = startpc; i < endpc; i += 4)
+	{
+		const u32* ptr = (const u32*)PSM(i);
+		if (!ptr) return 0;
+
+		const u32 code  = *ptr;
+		const u32 rs    = (code >> 21) & 0x1f;
+		const u32 rd    = (code >> 11) & 0x1f;
+		const u32 funct = code & 0x3f;
+
+		switch (code >> 26)
+		{
+			case 0: // special
+				if (funct == 12 || funct == 13) return 0; // SYSCALL, BREAK
+				break;
+
+			case 16: // cp0
+			case 47: // cache
+				return 0;
+
+			case 18: // cp2
+				if (rs == 6 && rd >= REG_TPC) return 0; // CTC2 to TPC, CMSAR0, FBRST...
+				if ((rs & 0x10) && (funct == 0x38 || funct == 0x39)) return 0; // VCALLMS, VCALLMSR
+				flags |= ShadowBlock_COP2;
+				break;
+
+			case 54: case 62: // LQC2, SQC2
+				flags |= ShadowBlock_COP2;
+				break;
+		}
+	}
+
+	return endpc | flags;
+}
+
+static void SaveRegs( ShadowRegs& regs, bool vu0 )
+{
+	regs.cpu = cpuRegs;
+	regs.fpu = fpuRegs;
+	if (vu0) regs.vu0 = VU0;
+}
+
+static void RestoreRegs( const ShadowRegs& regs, bool vu0 )
+{
+	cpuRegs = regs.cpu;
+	fpuRegs = regs.fpu;
+	if (vu0) VU0 = regs.vu0;
+}
+
+static void RollBack( bool vu0 )
+{
+	for (auto w = s_writes.rbegin(); w != s_writes.rend(); ++w)
+		memcpy(w->ptr, &w->before, w->size);
+
+	RestoreRegs(s_before, vu0);
+}
+
+// --------------------------------------------------------------------------------------
+//  Comparison
+// --------------------------------------------------------------------------------------
+typedef std::vector<std::string> DiffList;
+
+static void Diff32( DiffList& diffs, const char* name, u32 before, u32 rec, u32 interp )
+{
+	if (rec == interp) return;
+
+	char line[128];
+	snprintf(line, sizeof(line), "    %-10s %08x / %08x / %08x", name, before, rec, interp);
+	diffs.push_back(line);
+}
+
+static void Diff128( DiffList& diffs, const char* name, const u32* before, const u32* rec, const u32* interp )
+{
+	if (!memcmp(rec, interp, 16)) return;
+
+	char line[192];
+	snprintf(line, sizeof(line), "    %-10s %08x%08x%08x%08x / %08x%08x%08x%08x / %08x%08x%08x%08x", name,
+		before[3], before[2], before[1], before[0],
+		rec[3], rec[2], rec[1], rec[0],
+		interp[3], interp[2], interp[1], interp[0]);
+	diffs.push_back(line);
+}
+
+static void DiffMemory( DiffList& diffs )
+{
+	uint count = 0;
+
+	for (const ShadowWrite& w : s_writes)
+	{
+		if (!memcmp(w.ptr, &w.after, w.size)) continue;
+
+		if (++count > MaxMemoryDiffs)
+		{
+			diffs.push_back("    (more memory differences left out)");
+			return;
+		}
+
+		u128 rec = u128::From64(0);
+		memcpy(&rec, w.ptr, w.size);
+
+		char name[16];
+		snprintf(name, sizeof(name), "[%08x]", w.addr);
+		Diff128(diffs, name, (const u32*)&w.before, (const u32*)&rec, (const u32*)&w.after);
+	}
+}
+
+static void DiffRegs( DiffList& diffs, u32 pc, bool vu0 )
+{
+	const ShadowRegs& b = s_before;
+	const ShadowRegs& i = s_interp;
+
+	Diff32(diffs, "pc", b.cpu.pc, pc, i.cpu.pc);
+
+	for (int r = 1; r < 32; ++r)
+		Diff128(diffs, GPR_REG[r], b.cpu.GPR.r[r].UL, cpuRegs.GPR.r[r].UL, i.cpu.GPR.r[r].UL);
+
+	Diff128(diffs, "hi", b.cpu.HI.UL, cpuRegs.HI.UL, i.cpu.HI.UL);
+	Diff128(diffs, "lo", b.cpu.LO.UL, cpuRegs.LO.UL, i.cpu.LO.UL);
+	Diff32(diffs, "sa", b.cpu.sa, cpuRegs.sa, i.cpu.sa);
+
+	for (int r = 0; r < 32; ++r)
+	{
+		if (r == 9) continue; // Count
+		Diff32(diffs, COP0_REG[r], b.cpu.CP0.r[r], cpuRegs.CP0.r[r], i.cpu.CP0.r[r]);
+	}
+
+	for (int r = 0; r < 32; ++r)
+		Diff32(diffs, COP1_REG_FP[r], b.fpu.fpr[r].UL, fpuRegs.fpr[r].UL, i.fpu.fpr[r].UL);
+
+	Diff32(diffs, "ACC", b.fpu.ACC.UL, fpuRegs.ACC.UL, i.fpu.ACC.UL);
+	Diff32(diffs, "FCR31.C", b.fpu.fprc[31] & FpuConditionFlag,
+		fpuRegs.fprc[31] & FpuConditionFlag, i.fpu.fprc[31] & FpuConditionFlag);
+
+	if (!vu0) return;
+
+	for (int r = 0; r < 32; ++r)
+		Diff128(diffs, COP2_REG_FP[r], b.vu0.VF[r].UL, VU0.VF[r].UL, i.vu0.VF[r].UL);
+
+	for (int r = 0; r < 16; ++r)
+		Diff32(diffs, COP2_REG_CTL[r], b.vu0.VI[r].UL, VU0.VI[r].UL, i.vu0.VI[r].UL);
+
+	Diff128(diffs, "vfACC", b.vu0.ACC.UL, VU0.ACC.UL, i.vu0.ACC.UL);
+}
+
+static void Report( u32 startpc, u32 endpc, const DiffList& diffs )
+{
+	Console.Error("(EE Shadow) Block %08x: the rec and the interpreter disagree (%u blocks checked, %u skipped, %u diverged).",
+		startpc, s_checked, s_skipped, s_diverged);
+
+	std::string disasm;
+	for (u32 pc = startpc; pc < endpc; pc += 4)
+	{
+		const u32* code = (const u32*)PSM(pc);
+		if (!code) break;
+
+		disasm.clear();
+		disR5900Fasm(disasm, *code, pc);
+		Console.WriteLn("    %08x: %s", pc, disasm.c_str());
+	}
+
+	Console.WriteLn("  Before / rec / interpreter:");
+	for (const std::string& line : diffs)
+		Console.WriteLn("%s", line.c_str());
+
+	if (s_reported.size() == MaxReports)
+		Console.Warning("(EE Shadow) Further divergences are counted, not reported.");
+}
+
+static void CheckPendingBlock( u32 pc )
+{
+	if (!s_pendingBlock) return;
+
+	const u32 startpc = s_pendingStart;
+	const u32 block = s_pendingBlock;
+	const bool vu0 = !!(block & ShadowBlock_COP2);
+	s_pendingBlock = 0;
+
+	++s_checked;
+
+	DiffList diffs;
+	DiffRegs(diffs, pc, vu0);
+	DiffMemory(diffs);
+
+	if (diffs.empty()) return;
+
+	++s_diverged;
+	if (s_reported.size() >= MaxReports || !s_reported.insert(startpc).second) return;
+
+	Report(startpc, block & ~ShadowBlock_COP2, diffs);
+}
+
+// --------------------------------------------------------------------------------------
+//  Rec interface
+// --------------------------------------------------------------------------------------
+void __fastcall recShadowBlock( u32 startpc, u32 block )
+{
+	CheckPendingBlock(startpc);
+
+	const bool vu0 = !!(block & ShadowBlock_COP2);
+
+	// A running VU0 would be synced by the COP2 code, and run twice.
+	if (!block || (vu0 && (VU0.VI[REG_VPU_STAT].UL & 1)))
+	{
+		++s_skipped;
+		return;
+	}
+
+	// Linked blocks don't always store the pc.
+	cpuRegs.pc = startpc;
+
+	SaveRegs(s_before, vu0);
+	s_writes.clear();
+	s_touchedHardware = false;
+
+	try {
+		ScopedBool active(vtlb_ShadowActive);
+		intShadowBlock(block & ~ShadowBlock_COP2);
+	}
+	catch (...)
+	{
+		RollBack(vu0);
+		throw;
+	}
+
+	if (!s_touchedHardware)
+	{
+		SaveRegs(s_interp, vu0);
+		for (ShadowWrite& w : s_writes)
+			memcpy(&w.after, w.ptr, w.size);
+	}
+
+	RollBack(vu0);
+
+	if (s_touchedHardware)
+	{
+		++s_skipped;
+		return;
+	}
+
+	s_pendingStart = startpc;
+	s_pendingBlock = block;
+}
+
+void recShadowBlockEnd()
+{
+	CheckPendingBlock(cpuRegs.pc);
+}
+
+void recShadowReset()
+{
+	s_pendingBlock = 0;
+}
@@ -148,9 +148,6 @@ namespace vtlb_private
 	//
 	static uptr* DynGen_PrepRegs()
 	{
-		// Warning dirty ebx (in case someone got the very bad idea to move this code)
-		EE::Profiler.EmitMem();
-
 		xMOV( eax, ecx );
 		xSHR( eax, VTLB_PAGE_BITS );
 		xMOV( eax, ptr[(eax*4) + vtlbdata.vmap] );
@@ -162,34 +159,36 @@ namespace vtlb_private
 	}
 
 	// ------------------------------------------------------------------------
-	static void DynGen_DirectRead( u32 bits, bool sign )
+	// base - host address of the PS2 address 0, for the fastmem path (the vtlb path has
+	// already added it to ecx).
+	static void DynGen_DirectRead( u32 bits, bool sign, sptr base = 0 )
 	{
 		switch( bits )
 		{
 			case 8:
 				if( sign )
-					xMOVSX( eax, ptr8[ecx] );
+					xMOVSX( eax, ptr8[ecx + base] );
 				else
-					xMOVZX( eax, ptr8[ecx] );
+					xMOVZX( eax, ptr8[ecx + base] );
 			break;
 
 			case 16:
 				if( sign )
-					xMOVSX( eax, ptr16[ecx] );
+					xMOVSX( eax, ptr16[ecx + base] );
 				else
-					xMOVZX( eax, ptr16[ecx] );
+					xMOVZX( eax, ptr16[ecx + base] );
 			break;
 
 			case 32:
-				xMOV( eax, ptr[ecx] );
+				xMOV( eax, ptr[ecx + base] );
 			break;
 
 			case 64:
-				iMOV64_Smart( ptr[edx], ptr[ecx] );
+				iMOV64_Smart( ptr[edx], ptr[ecx + base] );
 			break;
 
 			case 128:
-				iMOV128_SSE( ptr[edx], ptr[ecx] );
+				iMOV128_SSE( ptr[edx], ptr[ecx + base] );
 			break;
 
 			jNO_DEFAULT
@@ -197,29 +196,29 @@ namespace vtlb_private
 	}
 
 	// ------------------------------------------------------------------------
-	static void DynGen_DirectWrite( u32 bits )
+	static void DynGen_DirectWrite( u32 bits, sptr base = 0 )
 	{
 		switch(bits)
 		{
 			//8 , 16, 32 : data on EDX
 			case 8:
-				xMOV( ptr[ecx], dl );
+				xMOV( ptr[ecx + base], dl );
 			break;
 
 			case 16:
-				xMOV( ptr[ecx], dx );
+				xMOV( ptr[ecx + base], dx );
 			break;
 
 			case 32:
-				xMOV( ptr[ecx], edx );
+				xMOV( ptr[ecx + base], edx );
 			break;
 
 			case 64:
-				iMOV64_Smart( ptr[ecx], ptr[edx] );
+				iMOV64_Smart( ptr[ecx + base], ptr[edx] );
 			break;
 
 			case 128:
-				iMOV128_SSE( ptr[ecx], ptr[edx] );
+				iMOV128_SSE( ptr[ecx + base], ptr[edx] );
 			break;
 		}
 	}
@@ -338,18 +337,86 @@ void vtlb_dynarec_init()
 	Perf::any.map((uptr)m_IndirectDispatchers, __pagesize, "TLB Dispatcher");
 }
 
+// ------------------------------------------------------------------------
+// The vtlb lookup: direct access for pages backed by host memory, or a jump to the
+// indirect dispatcher (which returns to the end of the sequence) for handlers.
+static void DynGen_VtlbRead( u32 bits, bool sign )
+{
+	uptr* writeback = DynGen_PrepRegs();
+
+	DynGen_IndirectDispatch( 0, bits, sign && bits < 32 );
+	DynGen_DirectRead( bits, sign );
+
+	*writeback = (uptr)xGetPtr();		// return target for indirect's call/ret
+}
+
+static void DynGen_VtlbWrite( u32 bits )
+{
+	uptr* writeback = DynGen_PrepRegs();
+
+	DynGen_IndirectDispatch( 1, bits );
+	DynGen_DirectWrite( bits );
+
+	*writeback = (uptr)xGetPtr();
+}
+
+// ------------------------------------------------------------------------
+// Fastmem: the addresses below vtlbdata.fastmem_limit are kuseg RAM mapped 1:1 (the vtlb
+// keeps the limit in sync with the mappings), so they're accessed at a fixed offset from
+// eeMem->Main, without the vmap lookup.  Everything else takes the vtlb path.
+//
+// The limit is read at run time, so TLB changes don't need the rec to be cleared, and
+// self-modifying code is still caught by the page protection of eeMem->Main.
+//
+static void DynGen_Read( u32 bits, bool sign )
+{
+	// Warning dirty ebx (in case someone got the very bad idea to move this code)
+	EE::Profiler.EmitMem();
+
+	if( !EmuConfig.Cpu.Recompiler.EnableFastmem )
+	{
+		DynGen_VtlbRead( bits, sign );
+		return;
+	}
+
+	xCMP( ecx, ptr32[&vtlbdata.fastmem_limit] );
+	xForwardJAE8 slowpath;
+	DynGen_DirectRead( bits, sign, (sptr)eeMem->Main );
+	xForwardJump8 done;
+
+	slowpath.SetTarget();
+	DynGen_VtlbRead( bits, sign );
+	done.SetTarget();
+}
+
+static void DynGen_Write( u32 bits )
+{
+	// Warning dirty ebx (in case someone got the very bad idea to move this code)
+	EE::Profiler.EmitMem();
+
+	if( !EmuConfig.Cpu.Recompiler.EnableFastmem )
+	{
+		DynGen_VtlbWrite( bits );
+		return;
+	}
+
+	xCMP( ecx, ptr32[&vtlbdata.fastmem_limit] );
+	xForwardJAE8 slowpath;
+	DynGen_DirectWrite( bits, (sptr)eeMem->Main );
+	xForwardJump8 done;
+
+	slowpath.SetTarget();
+	DynGen_VtlbWrite( bits );
+	done.SetTarget();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //                            Dynarec Load Implementations
 void vtlb_DynGenRead64(u32 bits)
 {
 	pxAssume( bits == 64 || bits == 128 );
 
-	uptr* writeback = DynGen_PrepRegs();
-
-	DynGen_IndirectDispatch( 0, bits );
-	DynGen_DirectRead( bits, false );
-
-	*writeback = (uptr)xGetPtr();		// return target for indirect's call/ret
+	DynGen_Read( bits, false );
 }
 
 // ------------------------------------------------------------------------
@@ -360,12 +427,7 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 {
 	pxAssume( bits <= 32 );
 
-	uptr* writeback = DynGen_PrepRegs();
-
-	DynGen_IndirectDispatch( 0, bits, sign && bits < 32 );
-	DynGen_DirectRead( bits, sign );
-
-	*writeback = (uptr)xGetPtr();
+	DynGen_Read( bits, sign );
 }
 
 // ------------------------------------------------------------------------
@@ -496,12 +558,7 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 
 void vtlb_DynGenWrite(u32 sz)
 {
-	uptr* writeback = DynGen_PrepRegs();
-
-	DynGen_IndirectDispatch( 1, sz );
-	DynGen_DirectWrite( sz );
-
-	*writeback = (uptr)xGetPtr();
+	DynGen_Write( sz );
 }
 
 
@@ -69,6 +69,7 @@ void mVUinit(microVU& mVU, uint vuIndex) {
 	else mVU.dispCache = vu0_RecDispatchers;
 
 	mVU.regAlloc.reset(new microRegAlloc(mVU.index));
+	mVU.progCache.reset(new microProgCache(mVU));
 }
 
 // Resets Rec Data
@@ -77,6 +78,10 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 	// Restore reserve to uncommitted state
 	if (resetReserve) mVU.cache_reserve->Reset();
 
+	// A full reset means a new game (or a reboot); save what this one compiled.
+	// Running out of rec cache space keeps recording into the same cache.
+	if (resetReserve && mVU.progCache) mVU.progCache->Reset();
+
 	HostSys::MemProtect(mVU.dispCache, mVUdispCacheSize, PageAccess_ReadWrite());
 	memset(mVU.dispCache, 0xcc, mVUdispCacheSize);
 
@@ -127,6 +132,7 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 // Free Allocated Resources
 void mVUclose(microVU& mVU) {
 
+	mVU.progCache = nullptr; // Saves the program cache
 	safe_delete  (mVU.cache_reserve);
 
 	// Delete Programs and Block Managers
@@ -191,6 +197,7 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC) {
 __ri void mVUcacheProg(microVU& mVU, microProgram& prog) {
 	if (!mVU.index)	memcpy(prog.data, mVU.regs().Micro, 0x1000);
 	else			memcpy(prog.data, mVU.regs().Micro, 0x4000);
+	prog.hash = 0; // The program cache hashes the new image when it needs it
 	mVUdumpProg(mVU, prog);
 }
 
@@ -255,7 +262,7 @@ __fi bool mVUcmpProg(microVU& mVU, microProgram& prog, const bool cmpWholeProg)
 }
 
 // Searches for Cached Micro Program and sets prog.cur to it (returns entry-point to program)
-_mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
+_mVUt static __fi void* mVUfindProg(u32 startPC, uptr pState) {
 	microVU& mVU = mVUx;
 	microProgramQuick& quick = mVU.prog.quick[startPC/8];
 	microProgramList*  list  = mVU.prog.prog [startPC/8];
@@ -297,6 +304,18 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
 	return mVUentryGet(mVU, quick.block, startPC, pState);
 }
 
+// Same as mVUfindProg, and records the entry in the program cache when it had to be
+// compiled.  Recorded here (not for every block) so that branch targets within programs
+// aren't replayed as programs of their own, and after compiling so that the image saved
+// is the one mVUcheckIsSame refreshed the program with.
+_mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
+	microVU& mVU = mVUx;
+	u8* start = x86Ptr;
+	void* entryPoint = mVUfindProg<vuIndex>(startPC, pState);
+	if (x86Ptr != start) mVU.progCache->Record(*mVU.prog.cur, startPC, pState);
+	return entryPoint;
+}
+
 //------------------------------------------------------------------
 // recMicroVU0 / recMicroVU1
 //------------------------------------------------------------------
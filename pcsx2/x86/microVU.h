@@ -35,6 +35,7 @@ using namespace x86Emitter;
 #include "microVU_Misc.h"
 #include "microVU_IR.h"
 #include "microVU_Profiler.h"
+#include "microVU_ProgCache.h"
 #include "Utilities/Perf.h"
 
 struct microBlockLink {
@@ -149,6 +150,7 @@ struct microProgram {
 	std::deque<microRange>* ranges;			   // The ranges of the microProgram that have already been recompiled
 	u32 startPC; // Start PC of this program
 	int idx;	 // Program index
+	u64 hash;	 // Hash of data for the program cache (0 = not computed yet)
 };
 
 typedef std::deque<microProgram*> microProgramList;
@@ -198,6 +200,7 @@ struct microVU {
 	microProfiler					profiler;   // Opcode Profiler
 	std::unique_ptr<microRegAlloc>	regAlloc;	// Reg Alloc Class
 	std::unique_ptr<AsciiFile>		logFile;	// Log File Pointer
+	std::unique_ptr<microProgCache>	progCache;	// Programs compiled in earlier sessions
 
 	RecompiledCodeReserve* cache_reserve;
 	u8*		cache;		  // Dynarec Cache Start (where we will start writing the recompiled code to)
@@ -280,5 +283,6 @@ void sortVector(T& v) {
 #include "microVU_Flags.inl"
 #include "microVU_Branch.inl"
 #include "microVU_Compile.inl"
+#include "microVU_ProgCache.inl"
 #include "microVU_Execute.inl"
 #include "microVU_Macro.inl"
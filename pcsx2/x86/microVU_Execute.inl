@@ -129,6 +129,7 @@ _mVUt void* __fastcall mVUexecute(u32 startPC, u32 cycles) {
 	mVU.cycles		= cycles;
 	mVU.totalCycles = cycles;
 
+	mVU.progCache->Update(); // Might recompile preloaded programs
 	xSetPtr(mVU.prog.x86ptr); // Set x86ptr to where last program left off
 	return mVUsearchProg<vuIndex>(startPC & vuLimit, (uptr)&mVU.prog.lpState); // Find and set correct program
 }
@@ -0,0 +1,98 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+struct microVU;
+struct microProgram;
+
+//------------------------------------------------------------------
+// Micro VU - Program Cache
+//------------------------------------------------------------------
+// Remembers the microprograms a game ran, along with the pipeline states each of them
+// was entered with, in a file per game (ElfCRC) and VU.  When the game is booted again
+// the file is read by a helper thread, and the programs are recompiled ahead of time a
+// bit on every execute, so that the first time a scene runs the blocks are already
+// in the rec cache.
+//
+// The recompiled code itself isn't saved: it refers to the addresses of the VU regs,
+// dispatchers and block managers of this session, and depends on the clamp modes and
+// gamefixes.  Replaying the inputs instead keeps the cache valid across all of them.
+//
+// The folder is given by the gui, with mVUsetProgCacheFolder(); no cache is kept until
+// it is.
+//
+// Every program is stored with a hash of its micro memory image, which is checked on
+// load, so a damaged file only loses the programs it damaged.
+
+struct microProgCacheEntry {
+	u32 startPC;				// Start PC (in bytes)
+	u32 pState[160/4];			// microRegInfo at entry (unaligned copy)
+};
+
+struct microProgCacheProgram {
+	u64 hash;							// mVUprogHash() of data
+	std::vector<u32> data;				// Micro memory image
+	std::vector<microProgCacheEntry> entries;
+};
+
+typedef std::vector<std::unique_ptr<microProgCacheProgram>> microProgCacheList;
+
+class microProgCacheLoader;
+class microProgCacheWriter;
+
+class microProgCache {
+public:
+	microProgCache(microVU& mVU);
+	~microProgCache();
+
+	// Called before every program execution, on the thread running the VU.  Follows
+	// ElfCRC changes and recompiles some of the preloaded programs.
+	void Update();
+
+	// Called by mVUsearchProg when an entry into a program had to be compiled. Does
+	// nothing while replaying.
+	void Record(microProgram& prog, u32 startPC, uptr pState);
+
+	// Hands what was recorded since the last save to a thread that writes it out.
+	void Save();
+
+	// Saves, and forgets the game.  The next Update() opens the cache again.
+	void Reset();
+
+private:
+	void Open(u32 crc);
+	void MergeLoaded();
+	void Replay();
+	microProgCacheProgram* FindProg(u64 hash);
+	wxString Filename() const;
+
+	microVU& mVU;
+	u32  m_crc;					// Game the cache is for (0 = none)
+	wxDirName m_folder;			// Where the cache of m_crc is kept
+	bool m_dirty;				// Programs/entries were added since the last save
+	bool m_replaying;			// Compiling preloaded programs (don't record them again)
+
+	microProgCacheList m_progs;
+	std::unordered_map<u64, size_t> m_index;		// hash -> m_progs
+
+	std::unique_ptr<microProgCacheLoader> m_loader;
+	std::unique_ptr<microProgCacheWriter> m_writer;	// Last save, if it's still being written
+	std::vector<microProgCacheProgram*> m_preload;	// Loaded programs still to be recompiled
+	size_t m_preloadPos;
+	std::vector<u32> m_backup;		// Micro memory of the game while replaying
+};
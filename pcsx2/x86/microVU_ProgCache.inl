@@ -0,0 +1,393 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2010  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Micro VU - Program Cache
+//------------------------------------------------------------------
+
+static const u32 mVUprogCacheMagic	 = 0x6355566d; // "mVUc"
+static const u32 mVUprogCacheVersion = 1;
+static const u32 mVUprogCacheMaxProgs = 1024;	// Per VU and game (16mb of VU1 images at most)
+
+struct mVUprogCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 vuIndex;
+	u32 crc;
+	u32 microMemSize;	// Size of every program image
+	u32 regInfoSize;	// sizeof(microRegInfo), in case its layout changes
+	u32 progCount;
+};
+
+struct mVUprogCacheProgHeader {
+	u64 hash;
+	u32 entryCount;
+	u32 pad;
+};
+
+// FNV-1a over 64bit words. Never returns 0, which microProgram::hash uses for 'not computed'.
+static u64 mVUprogHash(const u32* data, u32 size) {
+	const u64* src = (const u64*)data;
+	u64 hash = 0xcbf29ce484222325ULL;
+	for (u32 i = 0; i < size / 8; i++) {
+		hash ^= src[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash ? hash : 1;
+}
+
+// Set by the gui, which knows where the user's folders are
+static Threading::Mutex	mVUprogCacheFolderLock;
+static wxDirName		mVUprogCacheFolderName;
+
+void mVUsetProgCacheFolder(const wxDirName& folder) {
+	Threading::ScopedLock lock(mVUprogCacheFolderLock);
+	mVUprogCacheFolderName = folder;
+}
+
+static wxDirName mVUprogCacheFolder() {
+	Threading::ScopedLock lock(mVUprogCacheFolderLock);
+	return mVUprogCacheFolderName;
+}
+
+// Forces the next execution to search for its program again (without clearing lpState,
+// micro memory is the same as the last program left it)
+static void mVUprogCacheClearQuick(microVU& mVU) {
+	mVU.prog.cleared = 1;
+	mVU.prog.isSame  = -1;
+	for (u32 i = 0; i < (mVU.progSize / 2); i++) {
+		mVU.prog.quick[i].block = NULL;
+		mVU.prog.quick[i].prog  = NULL;
+	}
+}
+
+//------------------------------------------------------------------
+// microProgCacheLoader
+//------------------------------------------------------------------
+// Reads and verifies the cache file of a game, off the VU thread.
+class microProgCacheLoader : public pxThread {
+	typedef pxThread _parent;
+
+public:
+	microProgCacheList m_progs;
+
+	microProgCacheLoader(const wxString& filename, u32 vuIndex, u32 crc, u32 microMemSize)
+		: _parent(L"mVU Prog Cache")
+		, m_filename(filename)
+		, m_vuIndex(vuIndex)
+		, m_crc(crc)
+		, m_microMemSize(microMemSize)
+	{
+	}
+
+	virtual ~microProgCacheLoader() {
+		try {
+			_parent::Cancel();
+		}
+		DESTRUCTOR_CATCHALL
+	}
+
+protected:
+	wxString m_filename;
+	u32 m_vuIndex;
+	u32 m_crc;
+	u32 m_microMemSize;
+
+	void ExecuteTaskInThread() {
+		wxFFile file(m_filename, L"rb");
+		if (!file.IsOpened()) return;
+
+		mVUprogCacheHeader header;
+		if (file.Read(&header, sizeof(header)) != sizeof(header)
+		||  header.magic != mVUprogCacheMagic || header.version != mVUprogCacheVersion
+		||  header.vuIndex != m_vuIndex || header.crc != m_crc
+		||  header.microMemSize != m_microMemSize || header.regInfoSize != sizeof(microRegInfo)) {
+			DevCon.Warning("microVU%d: Ignoring outdated program cache [%s]", m_vuIndex, WX_STR(m_filename));
+			return;
+		}
+
+		u32 corrupt = 0;
+		for (u32 i = 0; i < std::min(header.progCount, mVUprogCacheMaxProgs); i++) {
+			mVUprogCacheProgHeader progHeader;
+			if (file.Read(&progHeader, sizeof(progHeader)) != sizeof(progHeader)) break;
+			if (progHeader.entryCount > 0x10000) break; // Can't be right, and can't be skipped
+
+			std::unique_ptr<microProgCacheProgram> prog(new microProgCacheProgram);
+			prog->hash = progHeader.hash;
+			prog->data.resize(m_microMemSize / 4);
+			prog->entries.resize(progHeader.entryCount);
+
+			const size_t entriesSize = progHeader.entryCount * sizeof(microProgCacheEntry);
+			if (file.Read(prog->data.data(), m_microMemSize) != m_microMemSize) break;
+			if (entriesSize && file.Read(prog->entries.data(), entriesSize) != entriesSize) break;
+
+			bool valid = mVUprogHash(prog->data.data(), m_microMemSize) == prog->hash;
+			for (const microProgCacheEntry& entry : prog->entries)
+				valid = valid && !(entry.startPC & 7) && entry.startPC < m_microMemSize;
+
+			if (!valid) { corrupt++; continue; }
+			m_progs.push_back(std::move(prog));
+		}
+
+		if (corrupt) Console.Warning("microVU%d: Dropped %d corrupt programs from the program cache", m_vuIndex, corrupt);
+		DevCon.WriteLn("microVU%d: Loaded %d programs from the program cache", m_vuIndex, (int)m_progs.size());
+	}
+};
+
+//------------------------------------------------------------------
+// microProgCacheWriter
+//------------------------------------------------------------------
+// Writes a cache file that Save() put together, off the VU thread.
+class microProgCacheWriter : public pxThread {
+	typedef pxThread _parent;
+
+public:
+	microProgCacheWriter(const wxDirName& folder, const wxString& filename, u32 vuIndex, std::vector<u8>& data)
+		: _parent(L"mVU Prog Cache Writer")
+		, m_folder(folder)
+		, m_filename(filename)
+		, m_vuIndex(vuIndex)
+	{
+		m_data.swap(data);
+	}
+
+	virtual ~microProgCacheWriter() {
+		try {
+			_parent::Block(); // Don't lose what the game compiled
+		}
+		DESTRUCTOR_CATCHALL
+	}
+
+protected:
+	wxDirName m_folder;
+	wxString m_filename;
+	u32 m_vuIndex;
+	std::vector<u8> m_data;
+
+	void ExecuteTaskInThread() {
+		m_folder.Mkdir();
+
+		wxFFile file(m_filename, L"wb");
+		if (!file.IsOpened()) {
+			Console.Warning("microVU%d: Can't write the program cache [%s]", m_vuIndex, WX_STR(m_filename));
+			return;
+		}
+		if (file.Write(m_data.data(), m_data.size()) != m_data.size())
+			Console.Warning("microVU%d: Error writing the program cache [%s]", m_vuIndex, WX_STR(m_filename));
+	}
+};
+
+//------------------------------------------------------------------
+// microProgCache
+//------------------------------------------------------------------
+
+microProgCache::microProgCache(microVU& _mVU)
+	: mVU(_mVU)
+	, m_crc(0)
+	, m_dirty(false)
+	, m_replaying(false)
+	, m_preloadPos(0)
+{
+}
+
+microProgCache::~microProgCache() {
+	try {
+		Reset();
+		m_writer = nullptr;
+	}
+	DESTRUCTOR_CATCHALL
+}
+
+wxString microProgCache::Filename() const {
+	return (m_folder + pxsFmt(L"mVU%u_%08X.bin", mVU.index, m_crc)).GetFullPath();
+}
+
+microProgCacheProgram* microProgCache::FindProg(u64 hash) {
+	auto it = m_index.find(hash);
+	return (it != m_index.end()) ? m_progs[it->second].get() : NULL;
+}
+
+void microProgCache::Open(u32 crc) {
+	m_crc	 = crc;
+	m_folder = mVUprogCacheFolder();
+	if (!m_folder.IsOk()) { m_crc = 0; return; } // The gui didn't say where to keep it
+
+	wxString filename = Filename();
+	if (!wxFileExists(filename)) return;
+
+	m_loader.reset(new microProgCacheLoader(filename, mVU.index, crc, mVU.microMemSize));
+	m_loader->Start();
+}
+
+// Takes over what the loader read, once it's done.  Programs the game compiled in the
+// meantime keep their entries, and get the loaded ones added.
+void microProgCache::MergeLoaded() {
+	if (!m_loader) return;
+	m_loader->Block();
+
+	for (auto& loaded : m_loader->m_progs) {
+		microProgCacheProgram* prog = FindProg(loaded->hash);
+		if (prog) {
+			for (const microProgCacheEntry& entry : loaded->entries) {
+				bool found = false;
+				for (const microProgCacheEntry& e : prog->entries)
+					found = found || (e.startPC == entry.startPC && !memcmp(e.pState, entry.pState, sizeof(e.pState)));
+				if (!found) prog->entries.push_back(entry);
+			}
+		}
+		else {
+			if (m_progs.size() >= mVUprogCacheMaxProgs) break;
+			prog = loaded.get();
+			m_index[prog->hash] = m_progs.size();
+			m_progs.push_back(std::move(loaded));
+		}
+		m_preload.push_back(prog);
+	}
+	m_loader = nullptr;
+}
+
+void microProgCache::Update() {
+	const u32 crc = EmuConfig.Cpu.Recompiler.EnableVUProgCache ? ElfCRC : 0;
+	if (crc != m_crc) {
+		Reset();
+		if (crc) Open(crc);
+	}
+
+	if (m_loader && !m_loader->IsRunning()) MergeLoaded();
+	if (m_preloadPos < m_preload.size()) Replay();
+}
+
+// Recompiles preloaded programs for about 2ms, by putting their image in micro memory
+// and searching for each recorded entry, just as if the game had uploaded and run it.
+// The search changes the state the game's next program is searched with (the current
+// program, the quick lookups, and lpState on early exit VUs), so it's put back after.
+void microProgCache::Replay() {
+	const u64 start  = GetCPUTicks();
+	const u64 budget = GetTickFrequency() / 500;
+	const u32 size   = mVU.microMemSize;
+
+	// Leave the second half of the rec cache to the game, filling it would only get it reset
+	const u8* limit = mVU.prog.x86start + (mVU.prog.x86end - mVU.prog.x86start) / 2;
+	if (mVU.prog.x86ptr >= limit) {
+		DevCon.WriteLn("microVU%d: Rec cache half full, skipping %d cached programs", mVU.index, (int)(m_preload.size() - m_preloadPos));
+		m_preloadPos = m_preload.size();
+		return;
+	}
+
+	m_backup.assign((u32*)mVU.regs().Micro, (u32*)(mVU.regs().Micro + size));
+	std::vector<microProgramQuick> quick(mVU.prog.quick, mVU.prog.quick + mVU.progSize / 2);
+	microProgram* cur	 = mVU.prog.cur;
+	const int isSame	 = mVU.prog.isSame;
+	const int cleared	 = mVU.prog.cleared;
+	microRegInfo lpState = mVU.prog.lpState;
+	m_replaying = true;
+	xSetPtr(mVU.prog.x86ptr);
+
+	while (m_preloadPos < m_preload.size() && xGetPtr() < limit) {
+		const microProgCacheProgram& prog = *m_preload[m_preloadPos++];
+		memcpy(mVU.regs().Micro, prog.data.data(), size);
+		mVUprogCacheClearQuick(mVU);
+
+		for (const microProgCacheEntry& entry : prog.entries) {
+			microRegInfo pState;
+			memcpy(&pState, entry.pState, sizeof(pState));
+			if (mVU.index) mVUsearchProg<1>(entry.startPC, (uptr)&pState);
+			else		   mVUsearchProg<0>(entry.startPC, (uptr)&pState);
+		}
+
+		if (GetCPUTicks() - start > budget) break;
+	}
+
+	mVU.prog.x86ptr = xGetPtr();
+	memcpy(mVU.regs().Micro, m_backup.data(), size);
+	std::copy(quick.begin(), quick.end(), mVU.prog.quick);
+	mVU.prog.cur	 = cur;
+	mVU.prog.isSame	 = isSame;
+	mVU.prog.cleared = cleared;
+	mVU.prog.lpState = lpState;
+	m_replaying = false;
+
+	if (m_preloadPos >= m_preload.size())
+		DevCon.WriteLn("microVU%d: Recompiled %d cached programs", mVU.index, (int)m_preload.size());
+}
+
+void microProgCache::Record(microProgram& prog, u32 startPC, uptr pState) {
+	if (m_replaying || !m_crc) return;
+
+	if (!prog.hash) prog.hash = mVUprogHash(prog.data, mVU.microMemSize);
+	microProgCacheProgram* cached = FindProg(prog.hash);
+	if (!cached) {
+		if (m_progs.size() >= mVUprogCacheMaxProgs) return;
+		cached = new microProgCacheProgram;
+		cached->hash = prog.hash;
+		cached->data.assign(prog.data, prog.data + mVU.microMemSize / 4);
+		m_index[prog.hash] = m_progs.size();
+		m_progs.push_back(std::unique_ptr<microProgCacheProgram>(cached));
+	}
+
+	for (const microProgCacheEntry& e : cached->entries) {
+		if (e.startPC == startPC && !memcmp(e.pState, (void*)pState, sizeof(e.pState))) return;
+	}
+
+	microProgCacheEntry entry;
+	entry.startPC = startPC;
+	memcpy(entry.pState, (void*)pState, sizeof(entry.pState));
+	cached->entries.push_back(entry);
+	m_dirty = true;
+}
+
+// Puts the file together here, and leaves writing it to a helper thread.
+void microProgCache::Save() {
+	MergeLoaded();
+	if (!m_dirty || !m_crc) return;
+	m_dirty = false;
+
+	size_t fileSize = sizeof(mVUprogCacheHeader);
+	for (auto& prog : m_progs)
+		fileSize += sizeof(mVUprogCacheProgHeader) + mVU.microMemSize + prog->entries.size() * sizeof(microProgCacheEntry);
+
+	std::vector<u8> data(fileSize);
+	u8* dst = data.data();
+	auto append = [&dst](const void* src, size_t size) { if (size) memcpy(dst, src, size); dst += size; };
+
+	mVUprogCacheHeader header = { mVUprogCacheMagic, mVUprogCacheVersion, mVU.index, m_crc,
+								  mVU.microMemSize, sizeof(microRegInfo), (u32)m_progs.size() };
+	append(&header, sizeof(header));
+
+	for (auto& prog : m_progs) {
+		mVUprogCacheProgHeader progHeader = { prog->hash, (u32)prog->entries.size(), 0 };
+		append(&progHeader, sizeof(progHeader));
+		append(prog->data.data(), mVU.microMemSize);
+		append(prog->entries.data(), prog->entries.size() * sizeof(microProgCacheEntry));
+	}
+
+	m_writer = nullptr; // Waits for the last save
+	m_writer.reset(new microProgCacheWriter(m_folder, Filename(), mVU.index, data));
+	m_writer->Start();
+	DevCon.WriteLn("microVU%d: Saving %d programs to the program cache", mVU.index, (int)m_progs.size());
+}
+
+void microProgCache::Reset() {
+	Save();
+
+	m_crc		 = 0;
+	m_dirty		 = false;
+	m_progs.clear();
+	m_index.clear();
+	m_preload.clear();
+	m_preloadPos = 0;
+}
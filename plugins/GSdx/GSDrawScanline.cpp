@@ -114,6 +114,25 @@ void GSDrawScanline::EndDraw(uint64 frame, uint64 ticks, int actual, int total)
 	m_ds_map.UpdateStats(frame, ticks, actual, total);
 }
 
+void GSDrawScanline::GetJitKeys(JitKeys& keys)
+{
+	m_sp_map.GetKeys(keys.sp);
+	m_ds_map.GetKeys(keys.ds);
+}
+
+void GSDrawScanline::GenerateJit(const JitKeys& keys)
+{
+	for(uint64 key : keys.sp)
+	{
+		m_sp_map.GetDefaultFunction(key);
+	}
+
+	for(uint64 key : keys.ds)
+	{
+		m_ds_map.GetDefaultFunction(key);
+	}
+}
+
 #ifndef ENABLE_JIT_RASTERIZER
 
 void GSDrawScanline::SetupPrim(const GSVertexSW* vertex, const uint32* index, const GSVertexSW& dscan)
@@ -87,4 +87,6 @@ public:
 #endif
 
 	void PrintStats() {m_ds_map.PrintStats();}
+	void GetJitKeys(JitKeys& keys);
+	void GenerateJit(const JitKeys& keys);
 };
@@ -162,6 +162,7 @@ class GSCodeGeneratorFunctionMap : public GSFunctionMap<KEY, VALUE>
 	std::unordered_map<uint64, VALUE> m_cgmap;
 	GSCodeBuffer m_cb;
 	size_t m_total_code_size;
+	std::mutex m_lock; // functions may also be generated ahead of time, on another thread
 
 	enum {MAX_SIZE = 8192};
 
@@ -182,6 +183,8 @@ public:
 
 	VALUE GetDefaultFunction(KEY key)
 	{
+		std::lock_guard<std::mutex> l(m_lock);
+
 		VALUE ret = NULL;
 
 		auto i = m_cgmap.find(key);
@@ -256,4 +259,14 @@ public:
 
 		return ret;
 	}
+
+	void GetKeys(std::set<uint64>& keys)
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+
+		for(const auto& i : m_cgmap)
+		{
+			keys.insert(i.first);
+		}
+	}
 };
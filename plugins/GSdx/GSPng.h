@@ -52,7 +52,7 @@ namespace GSPng {
 
     bool Save(GSPng::Format fmt, const std::string& file, uint8* image, int w, int h, int pitch, int compression, bool rb_swapped = false);
 
-    void Process(std::shared_ptr<Transaction> &item);
+    void Process(std::unique_ptr<Transaction> &item);
 
-    using Worker = GSJobQueue<std::shared_ptr<Transaction>, 16>;
+    using Worker = GSJobQueue<std::unique_ptr<Transaction>, 16>;
 }
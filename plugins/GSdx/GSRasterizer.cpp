@@ -27,8 +27,9 @@
 int GSRasterizerData::s_counter = 0;
 
 static int compute_best_thread_height(int threads) {
-	// - for more threads screen segments should be smaller to better distribute the pixels
-	// - but not too small to keep the threading overhead low
+	// height of the tiles:
+	// - for more threads tiles should be smaller to better distribute the pixels
+	// - but not too small, primitives spanning several tiles are set up in each of them
 	// - ideal value between 3 and 5, or log2(64 / number of threads)
 
 	int th = theApp.GetConfigI("extrathreads_height");
@@ -39,37 +40,22 @@ static int compute_best_thread_height(int threads) {
 		return 4;
 }
 
-GSRasterizer::GSRasterizer(IDrawScanline* ds, int id, int threads, GSPerfMon* perfmon)
+GSRasterizer::GSRasterizer(IDrawScanline* ds, int id, GSPerfMon* perfmon)
 	: m_perfmon(perfmon)
 	, m_ds(ds)
 	, m_id(id)
-	, m_threads(threads)
 {
 	memset(&m_pixels, 0, sizeof(m_pixels));
 
-	m_thread_height = compute_best_thread_height(threads);
+	m_band.top = 0;
+	m_band.bottom = 2048;
 
 	m_edge.buff = (GSVertexSW*)vmalloc(sizeof(GSVertexSW) * 2048, false);
 	m_edge.count = 0;
-
-	int rows = (2048 >> m_thread_height) + 16;
-	m_scanline = (uint8*)_aligned_malloc(rows, 64);
-
-	int row = 0;
-
-	while(row < rows)
-	{
-		for(int i = 0; i < threads; i++, row++)
-		{
-			m_scanline[row] = i == id ? 1 : 0;
-		}
-	}
 }
 
 GSRasterizer::~GSRasterizer()
 {
-	_aligned_free(m_scanline);
-
 	if(m_edge.buff != NULL) vmfree(m_edge.buff, sizeof(GSVertexSW) * 2048);
 
 	delete m_ds;
@@ -77,41 +63,12 @@ GSRasterizer::~GSRasterizer()
 
 bool GSRasterizer::IsOneOfMyScanlines(int top) const
 {
-	ASSERT(top >= 0 && top < 2048);
-
-	return m_scanline[top >> m_thread_height] != 0;
-}
-
-bool GSRasterizer::IsOneOfMyScanlines(int top, int bottom) const
-{
-	ASSERT(top >= 0 && top < 2048 && bottom >= 0 && bottom < 2048);
-
-	top = top >> m_thread_height;
-	bottom = (bottom + (1 << m_thread_height) - 1) >> m_thread_height;
-
-	while(top < bottom)
-	{
-		if(m_scanline[top++])
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return m_band.top <= top && top < m_band.bottom;
 }
 
 int GSRasterizer::FindMyNextScanline(int top) const
 {
-	int i = top >> m_thread_height;
-
-	if(m_scanline[i] == 0)
-	{
-		while(m_scanline[++i] == 0);
-
-		top = i << m_thread_height;
-	}
-
-	return top;
+	return std::max<int>(top, m_band.top);
 }
 
 void GSRasterizer::Queue(const std::shared_ptr<GSRasterizerData>& data)
@@ -132,10 +89,18 @@ int GSRasterizer::GetPixels(bool reset)
 }
 
 void GSRasterizer::Draw(GSRasterizerData* data)
+{
+	Draw(data, data->index, data->index_count, 0, 2048);
+}
+
+void GSRasterizer::Draw(GSRasterizerData* data, const uint32* index, int index_count, int top, int bottom)
 {
 	GSPerfMonAutoTimer pmat(m_perfmon, GSPerfMon::WorkerDraw0 + m_id);
 
-	if(data->vertex != NULL && data->vertex_count == 0 || data->index != NULL && data->index_count == 0) return;
+	if(data->vertex != NULL && data->vertex_count == 0 || index != NULL && index_count == 0) return;
+
+	m_band.top = top;
+	m_band.bottom = bottom;
 
 	m_pixels.actual = 0;
 	m_pixels.total = 0;
@@ -147,8 +112,7 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 	const GSVertexSW* vertex = data->vertex;
 	const GSVertexSW* vertex_end = data->vertex + data->vertex_count;
 
-	const uint32* index = data->index;
-	const uint32* index_end = data->index + data->index_count;
+	const uint32* index_end = index + index_count;
 
 	uint32 tmp_index[] = {0, 1, 2};
 
@@ -164,11 +128,11 @@ void GSRasterizer::Draw(GSRasterizerData* data)
 
 		if(scissor_test)
 		{
-			DrawPoint<true>(vertex, data->vertex_count, index, data->index_count);
+			DrawPoint<true>(vertex, data->vertex_count, index, index_count);
 		}
 		else
 		{
-			DrawPoint<false>(vertex, data->vertex_count, index, data->index_count);
+			DrawPoint<false>(vertex, data->vertex_count, index, index_count);
 		}
 
 		break;
@@ -540,6 +504,7 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW2& edge, c
 	GSVector4 scissor = m_fscissor_x;
 
 	top = FindMyNextScanline(top);
+	bottom = std::min<int>(bottom, m_band.bottom);
 
 	while(top < bottom)
 	{
@@ -572,11 +537,6 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW2& edge, c
 		}
 
 		top++;
-
-		if(!IsOneOfMyScanlines(top))
-		{
-			top += (m_threads - 1) << m_thread_height;
-		}
 	}
 
 	m_edge.count += e - &m_edge.buff[m_edge.count];
@@ -729,6 +689,7 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW& edge, co
 	GSVector4 scissor = m_fscissor_x;
 
 	top = FindMyNextScanline(top);
+	bottom = std::min<int>(bottom, m_band.bottom);
 
 	while(top < bottom)
 	{
@@ -763,11 +724,6 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW& edge, co
 		}
 
 		top++;
-
-		if(!IsOneOfMyScanlines(top))
-		{
-			top += (m_threads - 1) << m_thread_height;
-		}
 	}
 
 	m_edge.count += e - &m_edge.buff[m_edge.count];
@@ -801,7 +757,10 @@ void GSRasterizer::DrawSprite(const GSVertexSW* vertex, const uint32* index)
 
 	if(m_ds->IsSolidRect())
 	{
-		if(m_threads == 1)
+		r.top = FindMyNextScanline(r.top);
+		r.bottom = std::min<int>(r.bottom, m_band.bottom);
+
+		if(r.top < r.bottom)
 		{
 			m_ds->DrawRect(r, scan);
 
@@ -810,26 +769,6 @@ void GSRasterizer::DrawSprite(const GSVertexSW* vertex, const uint32* index)
 			m_pixels.actual += pixels;
 			m_pixels.total += pixels;
 		}
-		else
-		{
-			int top = FindMyNextScanline(r.top);
-			int bottom = r.bottom;
-
-			while(top < bottom)
-			{
-				r.top = top;
-				r.bottom = std::min<int>((top + (1 << m_thread_height)) & ~((1 << m_thread_height) - 1), bottom);
-
-				m_ds->DrawRect(r, scan);
-
-				int pixels = r.width() * r.height();
-
-				m_pixels.actual += pixels;
-				m_pixels.total += pixels;
-
-				top = r.bottom + ((m_threads - 1) << m_thread_height);
-			}
-		}
 
 		return;
 	}
@@ -851,6 +790,13 @@ void GSRasterizer::DrawSprite(const GSVertexSW* vertex, const uint32* index)
 	if((m & 2) == 0) scan.t += dedge.t * prestep.yyyy();
 	if((m & 1) == 0) scan.t += dscan.t * prestep.xxxx();
 
+	// rows above the tile are still stepped through, the texture coordinates must add up
+	// the same whichever tile the rows are drawn in
+
+	int bottom = std::min<int>(r.bottom, m_band.bottom);
+
+	if(r.top >= bottom) return;
+
 	m_ds->SetupPrim(vertex, index, dscan);
 
 	while(1)
@@ -860,7 +806,7 @@ void GSRasterizer::DrawSprite(const GSVertexSW* vertex, const uint32* index)
 			DrawScanline(r.width(), r.left, r.top, scan);
 		}
 
-		if(++r.top >= r.bottom) break;
+		if(++r.top >= bottom) break;
 
 		scan.t += dedge.t;
 	}
@@ -1139,26 +1085,279 @@ void GSRasterizer::DrawEdge(int pixels, int left, int top, const GSVertexSW& sca
 
 GSRasterizerList::GSRasterizerList(int threads, GSPerfMon* perfmon)
 	: m_perfmon(perfmon)
+	, m_queued(0)
+	, m_sleeping(0)
+	, m_waiting(false)
+	, m_exit(false)
+	, m_draw_next(0)
 {
 	m_thread_height = compute_best_thread_height(threads);
 
-	int rows = (2048 >> m_thread_height) + 16;
-	m_scanline = (uint8*)_aligned_malloc(rows, 64);
+	int tiles = 2048 >> m_thread_height;
+
+	m_tiles.resize(tiles);
+
+	for(int i = 0; i < tiles; i++)
+	{
+		m_tiles[i].worker = i % threads; // interleaved, until they are taken over
+		m_tiles[i].ready = false;
+		m_tiles[i].busy = false;
+	}
+
+	m_bin_size.resize(tiles);
+	m_bin_next.resize(tiles);
+
+	for(auto& d : m_draws)
+	{
+		d.jobs = 0;
+		d.busy = false;
+	}
+}
+
+GSRasterizerList::~GSRasterizerList()
+{
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+
+		m_exit = true;
+	}
+
+	m_notempty.notify_all();
 
-	int row = 0;
+	for(auto& t : m_workers)
+	{
+		t.join();
+	}
+}
 
-	while(row < rows)
+void GSRasterizerList::Start()
+{
+	for(size_t i = 0; i < m_r.size(); i++)
 	{
-		for(int i = 0; i < threads; i++, row++)
+		m_workers.push_back(std::thread(&GSRasterizerList::ThreadProc, this, (int)i));
+	}
+}
+
+void GSRasterizerList::ThreadProc(int id)
+{
+	GSRasterizer* r = m_r[id].get();
+
+	std::vector<Job> jobs;
+
+	std::unique_lock<std::mutex> l(m_lock);
+
+	while(true)
+	{
+		while(m_ready.empty())
 		{
-			m_scanline[row] = (uint8)i;
+			if(m_exit)
+				return;
+
+			m_sleeping++;
+
+			m_notempty.wait(l);
+
+			m_sleeping--;
+		}
+
+		// the first tile this worker drew last, or else the one waiting for the longest
+
+		auto it = std::find_if(m_ready.begin(), m_ready.end(), [&](int i) {return m_tiles[i].worker == id;});
+
+		if(it == m_ready.end()) it = m_ready.begin();
+
+		int i = *it;
+
+		m_ready.erase(it);
+
+		Tile& tile = m_tiles[i];
+
+		tile.worker = id;
+		tile.ready = false;
+		tile.busy = true;
+
+		jobs.swap(tile.queue);
+
+		l.unlock();
+
+		int top = i << m_thread_height;
+		int bottom = top + (1 << m_thread_height);
+
+		for(const Job& job : jobs)
+		{
+			Draw* draw = job.draw;
+
+			r->Draw(draw->data.get(), job.index, job.index_count, top, bottom);
+
+			if(--draw->jobs == 0)
+			{
+				draw->data.reset(); // the last reference to the draw may go here, better not under the lock
+				draw->busy.store(false, std::memory_order_release);
+			}
+		}
+
+		int done = (int)jobs.size();
+
+		jobs.clear();
+
+		l.lock();
+
+		tile.busy = false;
+
+		if(!tile.queue.empty())
+		{
+			tile.ready = true;
+
+			m_ready.push_back(i);
+		}
+
+		if((m_queued -= done) == 0 && m_waiting)
+		{
+			m_empty.notify_all();
 		}
 	}
 }
 
-GSRasterizerList::~GSRasterizerList()
+// Sorts the primitives of the draw into the tiles [top, bottom), adds a job to m_jobs for
+// each tile with some, returns how many.
+
+int GSRasterizerList::Bin(Draw* draw, const GSVector4i& r, int top, int bottom)
 {
-	_aligned_free(m_scanline);
+	GSRasterizerData* data = draw->data.get();
+
+	int n = 1;
+
+	switch(data->primclass)
+	{
+	case GS_POINT_CLASS: n = 1; break;
+	case GS_LINE_CLASS: n = 2; break;
+	case GS_TRIANGLE_CLASS: n = 3; break;
+	case GS_SPRITE_CLASS: n = 2; break;
+	default: __assume(0);
+	}
+
+	const GSVertexSW* vertex = data->vertex;
+	const uint32* index = data->index;
+
+	int prims = (index != NULL ? data->index_count : data->vertex_count) / n;
+
+	m_prim_tiles.resize(prims);
+
+	std::fill(m_bin_size.begin() + top, m_bin_size.begin() + bottom, 0);
+
+	int size = 0;
+
+	for(int i = 0; i < prims; i++)
+	{
+		float ymin = (float)r.top;
+		float ymax = (float)r.bottom;
+
+		float y = vertex[index != NULL ? index[i * n] : i * n].p.y;
+
+		if(y == y)
+		{
+			ymin = ymax = y;
+
+			for(int j = 1; j < n; j++)
+			{
+				y = vertex[index != NULL ? index[i * n + j] : i * n + j].p.y;
+
+				if(y != y)
+				{
+					ymin = (float)r.top;
+					ymax = (float)r.bottom;
+
+					break;
+				}
+
+				ymin = std::min<float>(ymin, y);
+				ymax = std::max<float>(ymax, y);
+			}
+		}
+
+		// the rows a primitive is drawn on are within [ymin - 1, ymax + 2) once truncated, lines
+		// and edges stepping from one end to the other can be off by one
+
+		int y0 = (int)std::max<float>(ymin, (float)r.top - 2) - 1;
+		int y1 = (int)std::min<float>(ymax, (float)r.bottom) + 2;
+
+		y0 = std::max<int>(y0, r.top);
+		y1 = std::min<int>(y1, r.bottom);
+
+		if(y0 >= y1)
+		{
+			m_prim_tiles[i] = 0xffffffff;
+
+			continue;
+		}
+
+		int t0 = y0 >> m_thread_height;
+		int t1 = (y1 - 1) >> m_thread_height;
+
+		m_prim_tiles[i] = t0 | (t1 << 16);
+
+		for(int t = t0; t <= t1; t++)
+		{
+			m_bin_size[t] += n;
+		}
+
+		size += (t1 - t0 + 1) * n;
+	}
+
+	if(size == 0)
+	{
+		return 0;
+	}
+
+	data->bins = (uint32*)_aligned_malloc(sizeof(uint32) * size, 32);
+
+	uint32* bin = data->bins;
+
+	for(int t = top; t < bottom; t++)
+	{
+		m_bin_next[t] = bin;
+
+		bin += m_bin_size[t];
+	}
+
+	for(int i = 0; i < prims; i++)
+	{
+		uint32 tiles = m_prim_tiles[i];
+
+		if(tiles == 0xffffffff) continue;
+
+		for(int t = tiles & 0xffff, t1 = tiles >> 16; t <= t1; t++)
+		{
+			uint32* RESTRICT dst = m_bin_next[t];
+
+			for(int j = 0; j < n; j++)
+			{
+				dst[j] = index != NULL ? index[i * n + j] : (uint32)(i * n + j);
+			}
+
+			m_bin_next[t] = dst + n;
+		}
+	}
+
+	int jobs = 0;
+
+	for(int t = top; t < bottom; t++)
+	{
+		if(m_bin_size[t] > 0)
+		{
+			Job job;
+
+			job.draw = draw;
+			job.index = m_bin_next[t] - m_bin_size[t];
+			job.index_count = m_bin_size[t];
+
+			m_jobs.push_back(std::make_pair(t, job));
+
+			jobs++;
+		}
+	}
+
+	return jobs;
 }
 
 void GSRasterizerList::Queue(const std::shared_ptr<GSRasterizerData>& data)
@@ -1167,12 +1366,86 @@ void GSRasterizerList::Queue(const std::shared_ptr<GSRasterizerData>& data)
 
 	ASSERT(r.top >= 0 && r.top < 2048 && r.bottom >= 0 && r.bottom < 2048);
 
+	if(r.top >= r.bottom)
+	{
+		return;
+	}
+
 	int top = r.top >> m_thread_height;
-	int bottom = std::min<int>((r.bottom + (1 << m_thread_height) - 1) >> m_thread_height, top + m_workers.size());
+	int bottom = ((r.bottom - 1) >> m_thread_height) + 1;
 
-	while(top < bottom)
+	Draw* draw = &m_draws[m_draw_next];
+
+	if(draw->busy.load(std::memory_order_acquire))
+	{
+		Sync(); // that many draws in flight, the workers can't keep up anyway
+	}
+
+	m_draw_next = (m_draw_next + 1) % countof(m_draws);
+
+	draw->data = data;
+
+	m_jobs.clear();
+
+	if(bottom - top == 1)
+	{
+		Job job;
+
+		job.draw = draw;
+		job.index = data->index;
+		job.index_count = data->index_count;
+
+		m_jobs.push_back(std::make_pair(top, job));
+	}
+	else if(Bin(draw, r, top, bottom) == 0)
+	{
+		draw->data.reset();
+
+		return;
+	}
+
+	draw->jobs = (int)m_jobs.size();
+	draw->busy = true;
+
+	int ready = 0;
+	int sleeping = 0;
+
+	{
+		std::lock_guard<std::mutex> l(m_lock);
+
+		for(const auto& j : m_jobs)
+		{
+			Tile& tile = m_tiles[j.first];
+
+			tile.queue.push_back(j.second);
+
+			if(!tile.ready && !tile.busy)
+			{
+				tile.ready = true;
+
+				m_ready.push_back(j.first);
+
+				ready++;
+			}
+		}
+
+		m_queued += (int)m_jobs.size();
+
+		sleeping = m_sleeping;
+	}
+
+	// the workers which are awake pick the new tiles up on their own
+
+	if(sleeping > 0)
 	{
-		m_workers[m_scanline[top++]]->Push(data);
+		if(ready == 1)
+		{
+			m_notempty.notify_one();
+		}
+		else if(ready > 1)
+		{
+			m_notempty.notify_all();
+		}
 	}
 }
 
@@ -1180,36 +1453,52 @@ void GSRasterizerList::Sync()
 {
 	if(!IsSynced())
 	{
-		for(size_t i = 0; i < m_workers.size(); i++)
+		std::unique_lock<std::mutex> l(m_lock);
+
+		m_waiting = true;
+
+		while(m_queued > 0)
 		{
-			m_workers[i]->Wait();
+			m_empty.wait(l);
 		}
 
+		m_waiting = false;
+
 		m_perfmon->Put(GSPerfMon::SyncPoint, 1);
 	}
 }
 
 bool GSRasterizerList::IsSynced() const
 {
-	for(size_t i = 0; i < m_workers.size(); i++)
-	{
-		if(!m_workers[i]->IsEmpty())
-		{
-			return false;
-		}
-	}
-
-	return true;
+	return m_queued == 0;
 }
 
 int GSRasterizerList::GetPixels(bool reset)
 {
 	int pixels = 0;
 
-	for(size_t i = 0; i < m_workers.size(); i++)
+	for(size_t i = 0; i < m_r.size(); i++)
 	{
 		pixels += m_r[i]->GetPixels(reset);
 	}
 
 	return pixels;
 }
+
+void GSRasterizerList::GetJitKeys(IDrawScanline::JitKeys& keys)
+{
+	for(size_t i = 0; i < m_r.size(); i++)
+	{
+		m_r[i]->GetJitKeys(keys);
+	}
+}
+
+void GSRasterizerList::GenerateJit(const IDrawScanline::JitKeys& keys)
+{
+	// each rasterizer has its own functions, they point to its local data
+
+	for(size_t i = 0; i < m_r.size(); i++)
+	{
+		m_r[i]->GenerateJit(keys);
+	}
+}
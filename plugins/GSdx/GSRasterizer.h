@@ -37,6 +37,7 @@ public:
 	GSVector4i bbox;
 	GS_PRIM_CLASS primclass;
 	uint8* buff;
+	uint32* bins; // primitives of each tile, when GSRasterizerList bins the draw
 	GSVertexSW* vertex;
 	int vertex_count;
 	uint32* index;
@@ -51,6 +52,7 @@ public:
 		, bbox(GSVector4i::zero())
 		, primclass(GS_INVALID_CLASS)
 		, buff(NULL)
+		, bins(NULL)
 		, vertex(NULL)
 		, vertex_count(0)
 		, index(NULL)
@@ -65,6 +67,7 @@ public:
 	virtual ~GSRasterizerData() 
 	{
 		if(buff != NULL) _aligned_free(buff);
+		if(bins != NULL) _aligned_free(bins);
 	}
 };
 
@@ -106,6 +109,16 @@ public:
 
 	virtual void PrintStats() = 0;
 
+	// Keys of the JIT'd functions, to generate them ahead of time the next time around
+
+	struct JitKeys
+	{
+		std::set<uint64> sp, ds;
+	};
+
+	virtual void GetJitKeys(JitKeys& keys) {}
+	virtual void GenerateJit(const JitKeys& keys) {}
+
 	__forceinline bool HasEdge() const {return m_de != NULL;}
 	__forceinline bool IsSolidRect() const {return m_dr != NULL;}
 };
@@ -120,6 +133,10 @@ public:
 	virtual bool IsSynced() const = 0;
 	virtual int GetPixels(bool reset = true) = 0;
 	virtual void PrintStats() = 0;
+
+	// may be called from any thread
+	virtual void GetJitKeys(IDrawScanline::JitKeys& keys) = 0;
+	virtual void GenerateJit(const IDrawScanline::JitKeys& keys) = 0;
 };
 
 class alignas(32) GSRasterizer : public IRasterizer
@@ -128,9 +145,7 @@ protected:
 	GSPerfMon* m_perfmon;
 	IDrawScanline* m_ds;
 	int m_id;
-	int m_threads;
-	int m_thread_height;
-	uint8* m_scanline;
+	struct {int top, bottom;} m_band; // rows of the tile being drawn
 	GSVector4i m_scissor;
 	GSVector4 m_fscissor_x;
 	GSVector4 m_fscissor_y;
@@ -160,15 +175,17 @@ protected:
 	__forceinline void DrawEdge(int pixels, int left, int top, const GSVertexSW& scan);
 
 public:
-	GSRasterizer(IDrawScanline* ds, int id, int threads, GSPerfMon* perfmon);
+	GSRasterizer(IDrawScanline* ds, int id, GSPerfMon* perfmon);
 	virtual ~GSRasterizer();
 
 	__forceinline bool IsOneOfMyScanlines(int top) const;
-	__forceinline bool IsOneOfMyScanlines(int top, int bottom) const;
 	__forceinline int FindMyNextScanline(int top) const;
 
 	void Draw(GSRasterizerData* data);
 
+	// Draws the primitives of index (all of the vertices if NULL), only on the rows [top, bottom)
+	void Draw(GSRasterizerData* data, const uint32* index, int index_count, int top, int bottom);
+
 	// IRasterizer
 
 	void Queue(const std::shared_ptr<GSRasterizerData>& data);
@@ -176,22 +193,73 @@ public:
 	bool IsSynced() const {return true;}
 	int GetPixels(bool reset);
 	void PrintStats() {m_ds->PrintStats();}
+	void GetJitKeys(IDrawScanline::JitKeys& keys) {m_ds->GetJitKeys(keys);}
+	void GenerateJit(const IDrawScanline::JitKeys& keys) {m_ds->GenerateJit(keys);}
 };
 
+// Draws are sorted into tiles, bands of 1 << m_thread_height rows across the screen: each
+// primitive is listed in the tiles its rows fall in, once, when the draw is queued.  Each
+// tile has a queue, drawn in order by one worker at a time, so the pixels of a tile are
+// always written in the order of the draws.  Workers go for the tiles they drew last
+// (their rows are still in their caches), and take over any other tile which is waiting
+// when there are none.
+
 class GSRasterizerList : public IRasterizer
 {
 protected:
-	using GSWorker = GSJobQueue<std::shared_ptr<GSRasterizerData>, 65536>;
+	// Draws in flight are held here rather than by each of their jobs, so the shared_ptr is
+	// only copied once per draw.  The worker which draws the last job releases it.
+	struct Draw
+	{
+		std::shared_ptr<GSRasterizerData> data;
+		std::atomic<int> jobs; // not drawn yet
+		std::atomic<bool> busy;
+	};
+
+	struct Job
+	{
+		Draw* draw;
+		const uint32* index; // NULL: all of the vertices
+		int index_count;
+	};
+
+	struct Tile
+	{
+		std::vector<Job> queue;
+		int worker; // last to draw it
+		bool ready; // listed in m_ready
+		bool busy; // being drawn
+	};
 
 	GSPerfMon* m_perfmon;
 	// Worker threads depend on the rasterizers, so don't change the order.
 	std::vector<std::unique_ptr<GSRasterizer>> m_r;
-	std::vector<std::unique_ptr<GSWorker>> m_workers;
-	uint8* m_scanline;
+	std::vector<std::thread> m_workers;
+	std::vector<Tile> m_tiles;
+	std::deque<int> m_ready; // tiles with jobs nobody is drawing
+	std::mutex m_lock;
+	std::condition_variable m_notempty;
+	std::condition_variable m_empty;
+	std::atomic<int> m_queued; // jobs not drawn yet
+	int m_sleeping; // workers waiting on m_notempty
+	bool m_waiting; // Sync waits on m_empty
+	bool m_exit;
+	Draw m_draws[256];
+	int m_draw_next;
 	int m_thread_height;
 
+	// scratch buffers of Queue and Bin
+	std::vector<std::pair<int, Job>> m_jobs;
+	std::vector<int> m_bin_size;
+	std::vector<uint32*> m_bin_next;
+	std::vector<uint32> m_prim_tiles;
+
 	GSRasterizerList(int threads, GSPerfMon* perfmon);
 
+	void Start();
+	void ThreadProc(int id);
+	int Bin(Draw* draw, const GSVector4i& r, int top, int bottom);
+
 public:
 	virtual ~GSRasterizerList();
 
@@ -201,19 +269,18 @@ public:
 
 		if(threads == 0)
 		{
-			return new GSRasterizer(new DS(), 0, 1, perfmon);
+			return new GSRasterizer(new DS(), 0, perfmon);
 		}
 
 		GSRasterizerList* rl = new GSRasterizerList(threads, perfmon);
 
 		for(int i = 0; i < threads; i++)
 		{
-			rl->m_r.push_back(std::unique_ptr<GSRasterizer>(new GSRasterizer(new DS(), i, threads, perfmon)));
-			auto &r = *rl->m_r[i];
-			rl->m_workers.push_back(std::unique_ptr<GSWorker>(new GSWorker(
-				[&r](std::shared_ptr<GSRasterizerData> &item) { r.Draw(item.get()); })));
+			rl->m_r.push_back(std::unique_ptr<GSRasterizer>(new GSRasterizer(new DS(), i, perfmon)));
 		}
 
+		rl->Start();
+
 		return rl;
 	}
 
@@ -224,4 +291,6 @@ public:
 	bool IsSynced() const;
 	int GetPixels(bool reset);
 	void PrintStats() {}
+	void GetJitKeys(IDrawScanline::JitKeys& keys);
+	void GenerateJit(const IDrawScanline::JitKeys& keys);
 };
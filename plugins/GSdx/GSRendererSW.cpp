@@ -42,6 +42,7 @@ void GSRendererSW::InitVectors()
 
 GSRendererSW::GSRendererSW(int threads)
 	: m_fzb(NULL)
+	, m_jit_crc(0)
 {
 	m_nativeres = true; // ignore ini, sw is always native
 
@@ -87,6 +88,8 @@ GSRendererSW::GSRendererSW(int threads)
 
 GSRendererSW::~GSRendererSW()
 {
+	SaveJitCache();
+
 	delete m_tc;
 
 	for(size_t i = 0; i < countof(m_texture); i++)
@@ -99,6 +102,124 @@ GSRendererSW::~GSRendererSW()
 	_aligned_free(m_output);
 }
 
+// bump when the scanline selectors change, old keys would generate the wrong functions
+#define JIT_CACHE_VERSION 1
+
+std::string GSRendererSW::GetJitCachePath() const
+{
+	return theApp.GetConfigDir() + format("/GSdx_jit/%08X.txt", m_jit_crc);
+}
+
+void GSRendererSW::LoadJitCache()
+{
+	if(m_jit_crc == 0 || !theApp.GetConfigB("jit_cache"))
+	{
+		return;
+	}
+
+	FILE* fp = fopen(GetJitCachePath().c_str(), "r");
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	IDrawScanline::JitKeys keys;
+
+	int version = 0;
+
+	if(fscanf(fp, "GSdx JIT keys %d\n", &version) == 1 && version == JIT_CACHE_VERSION)
+	{
+		char type[4];
+		uint64 key;
+
+		while(fscanf(fp, "%3s %llx\n", type, &key) == 2)
+		{
+			if(strcmp(type, "sp") == 0) keys.sp.insert(key);
+			else if(strcmp(type, "ds") == 0) keys.ds.insert(key);
+		}
+	}
+
+	fclose(fp);
+
+	if(keys.sp.empty() && keys.ds.empty())
+	{
+		return;
+	}
+
+	m_jit_loaded = keys;
+
+	printf("GSdx: generating %d cached JIT functions for %08X\n", (int)(keys.sp.size() + keys.ds.size()), m_jit_crc);
+
+	IRasterizer* rl = m_rl;
+
+	m_jit_thread = std::thread([rl, keys]() {rl->GenerateJit(keys);});
+}
+
+void GSRendererSW::SaveJitCache()
+{
+	if(m_jit_thread.joinable())
+	{
+		m_jit_thread.join();
+	}
+
+	if(m_jit_crc == 0 || !theApp.GetConfigB("jit_cache"))
+	{
+		return;
+	}
+
+	// what this game generated, and what it had cached
+
+	IDrawScanline::JitKeys all;
+
+	m_rl->GetJitKeys(all);
+
+	IDrawScanline::JitKeys keys = m_jit_loaded;
+
+	std::set_difference(all.sp.begin(), all.sp.end(), m_jit_prior.sp.begin(), m_jit_prior.sp.end(), std::inserter(keys.sp, keys.sp.end()));
+	std::set_difference(all.ds.begin(), all.ds.end(), m_jit_prior.ds.begin(), m_jit_prior.ds.end(), std::inserter(keys.ds, keys.ds.end()));
+
+	if(keys.sp.empty() && keys.ds.empty())
+	{
+		return;
+	}
+
+	GSmkdir((theApp.GetConfigDir() + "/GSdx_jit").c_str());
+
+	FILE* fp = fopen(GetJitCachePath().c_str(), "w");
+
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	fprintf(fp, "GSdx JIT keys %d\n", JIT_CACHE_VERSION);
+
+	for(uint64 key : keys.sp) fprintf(fp, "sp %016llx\n", key);
+	for(uint64 key : keys.ds) fprintf(fp, "ds %016llx\n", key);
+
+	fclose(fp);
+}
+
+void GSRendererSW::SetGameCRC(uint32 crc, int options)
+{
+	GSRenderer::SetGameCRC(crc, options);
+
+	if(crc != m_jit_crc)
+	{
+		SaveJitCache();
+
+		m_jit_crc = crc;
+
+		m_jit_prior = IDrawScanline::JitKeys();
+		m_jit_loaded = IDrawScanline::JitKeys();
+
+		m_rl->GetJitKeys(m_jit_prior);
+
+		LoadJitCache();
+	}
+}
+
 void GSRendererSW::Reset()
 {
 	Sync(-1);
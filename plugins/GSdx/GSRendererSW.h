@@ -100,6 +100,22 @@ protected:
 
 	bool GetScanlineGlobalData(SharedData* data);
 
+	// Keys of the JIT'd draw functions are saved per game, and generated on a thread of
+	// their own as soon as the game is known the next time, rather than on the first draw
+	// which needs them. The code maps aren't reset between games, so only what was first
+	// generated while the game ran (and what its file had) is saved.
+
+	uint32 m_jit_crc;
+	std::thread m_jit_thread;
+	IDrawScanline::JitKeys m_jit_prior; // generated before m_jit_crc was set
+	IDrawScanline::JitKeys m_jit_loaded; // read from the file of m_jit_crc
+
+	std::string GetJitCachePath() const;
+	void LoadJitCache();
+	void SaveJitCache();
+
+	void SetGameCRC(uint32 crc, int options);
+
 public:
 	static void InitVectors();
 
@@ -24,49 +24,92 @@
 #include "GSdx.h"
 #include "boost_spsc_queue.hpp"
 
+// Runs func on the items pushed, in order, on a thread of its own.
+//
+// The queue itself is lock-free (single producer, single consumer).  Both sides spin for a
+// little while before they go to sleep, and flag it when they do: the other side only takes
+// the lock and notifies when the flag is set, so a busy worker costs no syscalls at all.
+
 template<class T, int CAPACITY> class GSJobQueue final
 {
 private:
+	// rounds of _mm_pause before going to sleep
+	static const int SPIN_COUNT = 1024;
+
 	std::thread m_thread;
 	std::function<void(T&)> m_func;
 	bool m_exit;
 	ringbuffer_base<T, CAPACITY> m_queue;
 
 	std::mutex m_lock;
-	std::mutex m_wait_lock;
 	std::condition_variable m_empty;
 	std::condition_variable m_notempty;
+	std::atomic<bool> m_sleeping; // the worker waits on m_notempty
+	std::atomic<bool> m_waiting; // the producer waits on m_empty
 
-	void ThreadProc() {
-		std::unique_lock<std::mutex> l(m_lock);
+	template<class Pred> static bool Spin(Pred pred)
+	{
+		for(int i = 0; i < SPIN_COUNT; i++)
+		{
+			if(pred())
+				return true;
 
-		while (true) {
+			_mm_pause();
+		}
 
-			while (m_queue.empty()) {
-				if (m_exit)
-					return;
+		return pred();
+	}
+
+	// Wakes the other side up if it flagged it's asleep.  The fence orders the queue update
+	// before the load of the flag, as Sleep orders the store of the flag before checking the
+	// queue: one of the two always sees the other.
+	void WakeUp(std::atomic<bool>& sleeping, std::condition_variable& cv)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-				m_notempty.wait(l);
+		if(sleeping.load(std::memory_order_relaxed))
+		{
+			{
+				std::lock_guard<std::mutex> l(m_lock);
 			}
+			cv.notify_one();
+		}
+	}
 
-			l.unlock();
+	void ThreadProc() {
+		while (true) {
 
-			while (m_queue.consume_one(*this))
-				;
+			if (!Spin([this] { return !m_queue.empty(); })) {
+				std::unique_lock<std::mutex> l(m_lock);
 
-			{
-				std::lock_guard<std::mutex> wait_guard(m_wait_lock);
+				m_sleeping = true;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				while (m_queue.empty()) {
+					if (m_exit) {
+						m_sleeping = false;
+						return;
+					}
+
+					m_notempty.wait(l);
+				}
+
+				m_sleeping = false;
 			}
-			m_empty.notify_one();
 
-			l.lock();
+			while (m_queue.consume_one(*this))
+				;
+
+			WakeUp(m_waiting, m_empty);
 		}
 	}
 
 public:
 	GSJobQueue(std::function<void(T&)> func) :
 		m_func(func),
-		m_exit(false)
+		m_exit(false),
+		m_sleeping(false),
+		m_waiting(false)
 	{
 		m_thread = std::thread(&GSJobQueue::ThreadProc, this);
 	}
@@ -91,21 +134,49 @@ public:
 		while(!m_queue.push(item))
 			std::this_thread::yield();
 
-		{
-			std::lock_guard<std::mutex> l(m_lock);
+		WakeUp(m_sleeping, m_notempty);
+	}
+
+	void Push(T&& item) {
+		while(!m_queue.push(std::move(item)))
+			std::this_thread::yield();
+
+		WakeUp(m_sleeping, m_notempty);
+	}
+
+	// Pushes all of the items, waking the worker up once
+	void Push(T* items, size_t count) {
+		while (count > 0) {
+			size_t pushed = m_queue.push(items, count);
+
+			items += pushed;
+			count -= pushed;
+
+			if (count > 0) {
+				// full, the worker needs to be running to make room
+				WakeUp(m_sleeping, m_notempty);
+				std::this_thread::yield();
+			}
 		}
-		m_notempty.notify_one();
+
+		WakeUp(m_sleeping, m_notempty);
 	}
 
 	void Wait()
 	{
-		if (IsEmpty())
+		if (Spin([this] { return m_queue.empty(); }))
 			return;
 
-		std::unique_lock<std::mutex> l(m_wait_lock);
+		std::unique_lock<std::mutex> l(m_lock);
+
+		m_waiting = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
 		while (!IsEmpty())
 			m_empty.wait(l);
 
+		m_waiting = false;
+
 		assert(IsEmpty());
 	}
 
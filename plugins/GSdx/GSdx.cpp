@@ -372,6 +372,7 @@ void GSdxApp::Init()
 	m_default_configuration["force_texture_clear"]                        = "0";
 	m_default_configuration["fxaa"]                                       = "0";
 	m_default_configuration["interlace"]                                  = "7";
+	m_default_configuration["jit_cache"]                                  = "1";
 	m_default_configuration["large_framebuffer"]                          = "1";
 	m_default_configuration["linear_present"]                             = "1";
 	m_default_configuration["MaxAnisotropy"]                              = "0";
@@ -515,6 +516,13 @@ void GSdxApp::SetConfigDir(const char* dir)
 	}
 }
 
+std::string GSdxApp::GetConfigDir()
+{
+	size_t i = m_ini.find_last_of("/\\");
+
+	return i != std::string::npos ? m_ini.substr(0, i) : ".";
+}
+
 std::string GSdxApp::GetConfigS(const char* entry)
 {
 	char buff[4096] = {0};
@@ -45,6 +45,7 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include <atomic>
+#include <utility>
 
 template <typename T, size_t max_size>
 class ringbuffer_base
@@ -113,6 +114,47 @@ public:
         return true;
     }
 
+    bool push(T && t)
+    {
+        const size_t write_index = write_index_.load(std::memory_order_relaxed);  // only written from push thread
+        const size_t next = next_index(write_index);
+
+        if (next == read_index_.load(std::memory_order_acquire))
+            return false; /* ringbuffer is full */
+
+        new (buffer + write_index) T(std::move(t)); // move-construct
+
+        write_index_.store(next, std::memory_order_release);
+
+        return true;
+    }
+
+    // Moves as many items as there is room for, all made visible to the consumer at once.
+    // Returns how many were pushed.
+    size_t push(T * t, size_t count)
+    {
+        size_t write_index = write_index_.load(std::memory_order_relaxed);  // only written from push thread
+        const size_t read_index = read_index_.load(std::memory_order_acquire);
+
+        size_t pushed = 0;
+
+        for (; pushed < count; pushed++) {
+            const size_t next = next_index(write_index);
+
+            if (next == read_index)
+                break; /* ringbuffer is full */
+
+            new (buffer + write_index) T(std::move(t[pushed])); // move-construct
+
+            write_index = next;
+        }
+
+        if (pushed > 0)
+            write_index_.store(write_index, std::memory_order_release);
+
+        return pushed;
+    }
+
     bool pop (T & ret)
     {
         const size_t write_index = write_index_.load(std::memory_order_acquire);
@@ -120,7 +162,7 @@ public:
         if (empty(write_index, read_index))
             return false;
 
-        ret = buffer[read_index];
+        ret = std::move(buffer[read_index]);
         buffer[read_index].~T();
 
         size_t next = next_index(read_index);
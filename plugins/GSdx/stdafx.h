@@ -119,6 +119,7 @@ typedef int64 sint64;
 #include <condition_variable>
 #include <functional>
 #include <memory>
+#include <iterator>
 
 #include <zlib.h>
 
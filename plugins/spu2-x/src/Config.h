@@ -76,6 +76,7 @@ extern float VolumeAdjustSRdb;
 extern float VolumeAdjustLFEdb;
 extern bool postprocess_filter_enabled;
 extern bool postprocess_filter_dealias;
+extern bool MixThreadEnabled;
 
 extern int dplLevel;
 
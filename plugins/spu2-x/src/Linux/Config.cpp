@@ -69,6 +69,7 @@ unsigned int delayCycles;
 
 bool postprocess_filter_enabled = true;
 bool postprocess_filter_dealias = false;
+bool MixThreadEnabled = false;
 bool _visual_debug_enabled = false; // windows only feature
 
 // OUTPUT
@@ -94,6 +95,7 @@ void ReadSettings()
     Interpolation = CfgReadInt(L"MIXING", L"Interpolation", 4);
     EffectsDisabled = CfgReadBool(L"MIXING", L"Disable_Effects", false);
     postprocess_filter_dealias = CfgReadBool(L"MIXING", L"DealiasFilter", false);
+    MixThreadEnabled = CfgReadBool(L"MIXING", L"Mix_Thread", false);
     FinalVolume = ((float)CfgReadInt(L"MIXING", L"FinalVolume", 100)) / 100;
     if (FinalVolume > 1.0f)
         FinalVolume = 1.0f;
@@ -183,6 +185,7 @@ void WriteSettings()
     CfgWriteInt(L"MIXING", L"Interpolation", Interpolation);
     CfgWriteBool(L"MIXING", L"Disable_Effects", EffectsDisabled);
     CfgWriteBool(L"MIXING", L"DealiasFilter", postprocess_filter_dealias);
+    CfgWriteBool(L"MIXING", L"Mix_Thread", MixThreadEnabled);
     CfgWriteInt(L"MIXING", L"FinalVolume", (int)(FinalVolume * 100 + 0.5f));
 
     CfgWriteBool(L"MIXING", L"AdvancedVolumeControl", AdvancedVolumeControl);
@@ -0,0 +1,231 @@
+/* SPU2-X, A plugin for Emulating the Sound Processing Unit of the Playstation 2
+ * Developed and maintained by the Pcsx2 Development Team.
+ *
+ * Original portions from SPU2ghz are (c) 2008 by David Quintana [gigaherz]
+ *
+ * SPU2-X is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Found-
+ * ation, either version 3 of the License, or (at your option) any later version.
+ *
+ * SPU2-X is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with SPU2-X.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Global.h"
+#include "MixThread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <emmintrin.h>
+
+namespace MixThread
+{
+struct Command
+{
+    u32 rmem; // register written, or TimeUpdateCommand
+    u32 value;
+};
+
+static const u32 TimeUpdateCommand = 0xffffffff;
+
+// Commands the queue holds; the IOP thread waits when it's full.
+static const u32 QueueSize = 4096;
+
+// Times the thread looks at an empty queue before it goes to sleep.
+static const int SpinCount = 1024;
+
+static Command s_queue[QueueSize];
+
+// s_head is only written by the IOP thread, s_tail by the mixing thread.
+static std::atomic<u32> s_head(0);
+static std::atomic<u32> s_tail(0);
+
+static std::thread s_thread;
+static std::mutex s_lock;
+static std::condition_variable s_wakeup; // the mixing thread sleeps on it
+static std::condition_variable s_done;   // Sync() waits on it
+static std::atomic<bool> s_sleeping(false);
+static std::atomic<bool> s_waiting(false);
+static bool s_exit = false;
+
+// Nothing is queued, and the IOP thread may use the SPU2 state.
+static bool s_synced = true;
+
+static void WriteReg(u32 rmem, u16 value)
+{
+    if (rmem >> 16 == 0x1f80)
+        Cores[0].WriteRegPS1(rmem, value);
+    else {
+        SPU2writeLog("write", rmem, value);
+        SPU2_FastWrite(rmem, value);
+    }
+}
+
+// Interrupts may be raised (see MixThread.h).
+static bool MayRaiseInterrupts()
+{
+    if (has_to_call_irq)
+        return true;
+
+    for (int i = 0; i < 2; i++) {
+        if (Cores[i].IRQEnable || Cores[i].DMAICounter > 0 || (Cores[i].AutoDMACtrl & 3))
+            return true;
+    }
+
+    return false;
+}
+
+// Writes which start or stop interrupts, or run a transfer.
+static bool IsSyncWrite(u32 rmem)
+{
+    if (rmem >> 16 == 0x1f80)
+        return true; // PS1 mode, SPUCNT is ATTR
+
+    const u32 omem = rmem & 0xFFFF & ~0x400;
+
+    return omem == REG_C_ATTR || omem == REG_S_ADMAS || omem == 0x1AC;
+}
+
+static void Run()
+{
+    for (;;) {
+        u32 tail = s_tail.load(std::memory_order_relaxed);
+
+        for (int spin = 0; tail == s_head.load(std::memory_order_acquire); spin++) {
+            if (spin < SpinCount) {
+                _mm_pause();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(s_lock);
+
+            s_sleeping = true;
+
+            while (tail == s_head && !s_exit)
+                s_wakeup.wait(lock);
+
+            s_sleeping = false;
+
+            if (tail == s_head)
+                return; // s_exit, and nothing left
+        }
+
+        const Command &cmd = s_queue[tail % QueueSize];
+
+        if (cmd.rmem == TimeUpdateCommand)
+            ::TimeUpdate(cmd.value);
+        else
+            WriteReg(cmd.rmem, cmd.value);
+
+        s_tail.store(tail + 1);
+
+        if (s_waiting && tail + 1 == s_head) {
+            std::lock_guard<std::mutex> lock(s_lock);
+            s_done.notify_one();
+        }
+    }
+}
+
+static void Push(u32 rmem, u32 value)
+{
+    const u32 head = s_head.load(std::memory_order_relaxed);
+
+    while (head - s_tail.load(std::memory_order_acquire) == QueueSize)
+        std::this_thread::yield();
+
+    s_queue[head % QueueSize].rmem = rmem;
+    s_queue[head % QueueSize].value = value;
+
+    s_head.store(head + 1);
+    s_synced = false;
+
+    if (s_sleeping) {
+        std::lock_guard<std::mutex> lock(s_lock);
+        s_wakeup.notify_one();
+    }
+}
+
+void Open()
+{
+#ifndef S2R_ENABLE // the replays log the cycle of each write
+    if (!MixThreadEnabled || s_thread.joinable())
+        return;
+
+    s_head = 0;
+    s_tail = 0;
+    s_exit = false;
+    s_synced = true;
+
+    s_thread = std::thread(Run);
+#endif
+}
+
+void Close()
+{
+    if (!s_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        s_exit = true;
+        s_wakeup.notify_one();
+    }
+
+    s_thread.join();
+    s_synced = true;
+}
+
+void Sync()
+{
+    if (s_synced)
+        return;
+
+    const u32 head = s_head.load(std::memory_order_relaxed);
+
+    for (int spin = 0; s_tail.load(std::memory_order_acquire) != head; spin++) {
+        if (spin < SpinCount) {
+            _mm_pause();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(s_lock);
+
+        s_waiting = true;
+
+        while (s_tail != head)
+            s_done.wait(lock);
+
+        s_waiting = false;
+    }
+
+    s_synced = true;
+}
+
+// Once something is queued, nothing which may raise interrupts gets queued until the next
+// Sync(), so the state MayRaiseInterrupts() found holds until then.
+
+void TimeUpdate(u32 cClocks)
+{
+    if (s_thread.joinable() && (!s_synced || !MayRaiseInterrupts()))
+        Push(TimeUpdateCommand, cClocks);
+    else
+        ::TimeUpdate(cClocks);
+}
+
+void Write(u32 rmem, u16 value)
+{
+    if (s_thread.joinable() && !IsSyncWrite(rmem) && (!s_synced || !MayRaiseInterrupts()))
+        Push(rmem, value);
+    else {
+        Sync();
+        WriteReg(rmem, value);
+    }
+}
+}
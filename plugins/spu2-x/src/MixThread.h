@@ -0,0 +1,44 @@
+/* SPU2-X, A plugin for Emulating the Sound Processing Unit of the Playstation 2
+ * Developed and maintained by the Pcsx2 Development Team.
+ *
+ * Original portions from SPU2ghz are (c) 2008 by David Quintana [gigaherz]
+ *
+ * SPU2-X is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Found-
+ * ation, either version 3 of the License, or (at your option) any later version.
+ *
+ * SPU2-X is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with SPU2-X.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// --------------------------------------------------------------------------------------
+//  MixThread  (MIXING/Mix_Thread in the ini)
+// --------------------------------------------------------------------------------------
+// Takes the mixing off the IOP thread.  TimeUpdates and register writes are queued, in
+// order, and a thread of its own runs them.  Anything else which looks at or changes the
+// state of the SPU2 (register reads, DMAs, savestates...) waits for the thread to be done
+// with the queue first, and then runs on the IOP thread as before.
+//
+// The IOP has to see the interrupts the SPU2 raises at the time they're raised, so nothing
+// is queued while they may be raised: while either core has its IRQ enabled, a DMA is in
+// progress (DMAICounter), or AutoDMA is running.  Those only change through DMAs and writes
+// to ATTR and ADMAS, which wait for the queue and decide again.  Everything then runs the
+// same as without the thread, in the same order.
+
+namespace MixThread
+{
+extern void Open();
+extern void Close();
+
+// Waits for the thread to run everything queued.  The SPU2 state can then be used.
+extern void Sync();
+
+extern void TimeUpdate(u32 cClocks);
+extern void Write(u32 rmem, u16 value);
+}
@@ -18,6 +18,7 @@
 #include "Global.h"
 #include "PS2E-spu2.h"
 #include "Dma.h"
+#include "MixThread.h"
 #include "Dialogs.h"
 
 #ifdef __APPLE__
@@ -192,11 +193,15 @@ void (*dma7callback)();
 EXPORT_C_(u32)
 CALLBACK SPU2ReadMemAddr(int core)
 {
+    MixThread::Sync();
+
     return Cores[core].MADR;
 }
 EXPORT_C_(void)
 CALLBACK SPU2WriteMemAddr(int core, u32 value)
 {
+    MixThread::Sync();
+
     Cores[core].MADR = value;
 }
 
@@ -221,6 +226,8 @@ CALLBACK SPU2setLogDir(const char *dir)
 EXPORT_C_(s32)
 SPU2dmaRead(s32 channel, u32 *data, u32 bytesLeft, u32 *bytesProcessed)
 {
+    MixThread::Sync();
+
     if (channel == 4)
         return Cores[0].NewDmaRead(data, bytesLeft, bytesProcessed);
     else
@@ -230,6 +237,8 @@ SPU2dmaRead(s32 channel, u32 *data, u32 bytesLeft, u32 *bytesProcessed)
 EXPORT_C_(s32)
 SPU2dmaWrite(s32 channel, u32 *data, u32 bytesLeft, u32 *bytesProcessed)
 {
+    MixThread::Sync();
+
     if (channel == 4)
         return Cores[0].NewDmaWrite(data, bytesLeft, bytesProcessed);
     else
@@ -239,6 +248,8 @@ SPU2dmaWrite(s32 channel, u32 *data, u32 bytesLeft, u32 *bytesProcessed)
 EXPORT_C_(void)
 SPU2dmaInterrupt(s32 channel)
 {
+    MixThread::Sync();
+
     if (channel == 4)
         return Cores[0].NewDmaInterrupt();
     else
@@ -249,12 +260,16 @@ SPU2dmaInterrupt(s32 channel)
 EXPORT_C_(void)
 SPU2irqCallback(void (*SPU2callback)())
 {
+    MixThread::Sync();
+
     _irqcallback = SPU2callback;
 }
 #else
 EXPORT_C_(void)
 SPU2irqCallback(void (*SPU2callback)(), void (*DMA4callback)(), void (*DMA7callback)())
 {
+    MixThread::Sync();
+
     _irqcallback = SPU2callback;
     dma4callback = DMA4callback;
     dma7callback = DMA7callback;
@@ -264,6 +279,8 @@ SPU2irqCallback(void (*SPU2callback)(), void (*DMA4callback)(), void (*DMA7callb
 EXPORT_C_(void)
 CALLBACK SPU2readDMA4Mem(u16 *pMem, u32 size) // size now in 16bit units
 {
+    MixThread::Sync();
+
     if (cyclePtr != NULL)
         TimeUpdate(*cyclePtr);
 
@@ -274,6 +291,8 @@ CALLBACK SPU2readDMA4Mem(u16 *pMem, u32 size) // size now in 16bit units
 EXPORT_C_(void)
 CALLBACK SPU2writeDMA4Mem(u16 *pMem, u32 size) // size now in 16bit units
 {
+    MixThread::Sync();
+
     if (cyclePtr != NULL)
         TimeUpdate(*cyclePtr);
 
@@ -288,6 +307,8 @@ CALLBACK SPU2writeDMA4Mem(u16 *pMem, u32 size) // size now in 16bit units
 EXPORT_C_(void)
 CALLBACK SPU2interruptDMA4()
 {
+    MixThread::Sync();
+
     FileLog("[%10d] SPU2 interruptDMA4\n", Cycles);
     Cores[0].Regs.STATX |= 0x80;
     //Cores[0].Regs.ATTR &= ~0x30;
@@ -296,6 +317,8 @@ CALLBACK SPU2interruptDMA4()
 EXPORT_C_(void)
 CALLBACK SPU2interruptDMA7()
 {
+    MixThread::Sync();
+
     FileLog("[%10d] SPU2 interruptDMA7\n", Cycles);
     Cores[1].Regs.STATX |= 0x80;
     //Cores[1].Regs.ATTR &= ~0x30;
@@ -304,6 +327,8 @@ CALLBACK SPU2interruptDMA7()
 EXPORT_C_(void)
 CALLBACK SPU2readDMA7Mem(u16 *pMem, u32 size)
 {
+    MixThread::Sync();
+
     if (cyclePtr != NULL)
         TimeUpdate(*cyclePtr);
 
@@ -314,6 +339,8 @@ CALLBACK SPU2readDMA7Mem(u16 *pMem, u32 size)
 EXPORT_C_(void)
 CALLBACK SPU2writeDMA7Mem(u16 *pMem, u32 size)
 {
+    MixThread::Sync();
+
     if (cyclePtr != NULL)
         TimeUpdate(*cyclePtr);
 
@@ -328,6 +355,8 @@ CALLBACK SPU2writeDMA7Mem(u16 *pMem, u32 size)
 EXPORT_C_(void)
 SPU2reset()
 {
+    MixThread::Sync();
+
     memset(spu2regs, 0, 0x010000);
     memset(_spu2mem, 0, 0x200000);
     memset(_spu2mem + 0x2800, 7, 0x10); // from BIOS reversal. Locks the voices so they don't run free.
@@ -469,6 +498,7 @@ SPU2open(void *pDsp)
 
     try {
         SndBuffer::Init();
+        MixThread::Open();
 
 #ifndef __POSIX__
         DspLoadLibrary(dspPlugin, dspPluginModule);
@@ -489,6 +519,8 @@ SPU2close()
         return;
     IsOpened = false;
 
+    MixThread::Close();
+
     FileLog("[%10d] SPU2 Close\n", Cycles);
 
 #ifndef __POSIX__
@@ -558,10 +590,10 @@ SPU2async(u32 cycles)
     DspUpdate();
 
     if (cyclePtr != NULL) {
-        TimeUpdate(*cyclePtr);
+        MixThread::TimeUpdate(*cyclePtr);
     } else {
         pClocks += cycles;
-        TimeUpdate(pClocks);
+        MixThread::TimeUpdate(pClocks);
     }
 
 #ifdef DEBUG_KEYS
@@ -625,6 +657,8 @@ SPU2read(u32 rmem)
         core = 1;
     }
 
+    MixThread::Sync();
+
     if (omem == 0x1f9001AC) {
         ret = Cores[core].DmaRead();
     } else {
@@ -659,14 +693,9 @@ SPU2write(u32 rmem, u16 value)
     // incorrect pitches and loop lengths.
 
     if (cyclePtr != NULL)
-        TimeUpdate(*cyclePtr);
+        MixThread::TimeUpdate(*cyclePtr);
 
-    if (rmem >> 16 == 0x1f80)
-        Cores[0].WriteRegPS1(rmem, value);
-    else {
-        SPU2writeLog("write", rmem, value);
-        SPU2_FastWrite(rmem, value);
-    }
+    MixThread::Write(rmem, value);
 }
 
 // if start is 1, starts recording spu2 data, else stops
@@ -675,6 +704,8 @@ SPU2write(u32 rmem, u16 value)
 EXPORT_C_(int)
 SPU2setupRecording(int start, void *pData)
 {
+    MixThread::Sync();
+
     if (start == 0)
         RecordStop();
     else if (start == 1)
@@ -699,6 +730,8 @@ SPU2freeze(int mode, freezeData *data)
 
     pxAssume(mode == FREEZE_LOAD || mode == FREEZE_SAVE);
 
+    MixThread::Sync();
+
     if (data->data == NULL) {
         printf("SPU2-X savestate null pointer!\n");
         return -1;
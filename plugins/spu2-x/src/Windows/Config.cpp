@@ -62,6 +62,7 @@ unsigned int delayCycles;
 
 bool postprocess_filter_enabled = 1;
 bool postprocess_filter_dealias = false;
+bool MixThreadEnabled = false;
 
 // OUTPUT
 int SndOutLatencyMS = 100;
@@ -89,6 +90,7 @@ void ReadSettings()
 
     EffectsDisabled = CfgReadBool(L"MIXING", L"Disable_Effects", false);
     postprocess_filter_dealias = CfgReadBool(L"MIXING", L"DealiasFilter", false);
+    MixThreadEnabled = CfgReadBool(L"MIXING", L"Mix_Thread", false);
     FinalVolume = ((float)CfgReadInt(L"MIXING", L"FinalVolume", 100)) / 100;
     if (FinalVolume > 1.0f)
         FinalVolume = 1.0f;
@@ -171,6 +173,7 @@ void WriteSettings()
 
     CfgWriteBool(L"MIXING", L"Disable_Effects", EffectsDisabled);
     CfgWriteBool(L"MIXING", L"DealiasFilter", postprocess_filter_dealias);
+    CfgWriteBool(L"MIXING", L"Mix_Thread", MixThreadEnabled);
     CfgWriteInt(L"MIXING", L"FinalVolume", (int)(FinalVolume * 100 + 0.5f));
 
     CfgWriteBool(L"MIXING", L"AdvancedVolumeControl", AdvancedVolumeControl);
@@ -22,6 +22,9 @@ sub help {
 
     The script run_test.pl is a test runner that work in conjunction with ps2autotests (https://github.com/unknownbrackets/ps2autotests)
 
+    Note: PCSX2 can now run the suite by itself, headless and without copying configurations:
+        PCSX2 --autotest=<suite> [--testjobs=N] [--testcompare] [--testresults=out.xml]
+
     Mandatory Option
         --exe <STRING>          : the PCSX2 binary that you want to test
         --cfg <STRING>          : a path to the a default ini configuration of PCSX2